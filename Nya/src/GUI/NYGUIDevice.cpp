@@ -1,5 +1,6 @@
 #include "pch.hpp"
 #include "NYGUIDevice.hpp"
+#include "logging/NYLogger.hpp"
 
 namespace Nya {
 	NYGUIDevice::NYGUIDevice(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain):renderDevice(_renderDevice), swapchain(_swapchain) {
@@ -30,8 +31,21 @@ namespace Nya {
 		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
 		poolInfo.pPoolSizes = poolSizes.data();
 
-		 pool = renderDevice.getDevice().createDescriptorPool(poolInfo);
+		pool = renderDevice.getDevice().createDescriptorPool(poolInfo);
 		ImGui_ImplGlfw_InitForVulkan(renderDevice.getWindow().getHandlePointer(), true);
+	}
+
+	NYGUIDevice::~NYGUIDevice(){
+		if (initialized) {
+			ImGui_ImplVulkan_Shutdown();
+		}
+		ImGui_ImplGlfw_Shutdown();
+		renderDevice.getDevice().destroyDescriptorPool(pool);
+		ImGui::DestroyContext();
+	}
+
+	void NYGUIDevice::init(vk::RenderPass renderPass, uint32_t subpass) {
+		NYLogger::checkAssert(!initialized, "NYGUIDevice is already initialized");
 
 		ImGui_ImplVulkan_InitInfo init_info = {};
 		init_info.Instance = static_cast<VkInstance>(renderDevice.getInstance());
@@ -39,71 +53,25 @@ namespace Nya {
 		init_info.Device = static_cast<VkDevice>(renderDevice.getDevice());
 		init_info.QueueFamily = renderDevice.getGraphicsQueueFamilyIndex();
 		init_info.Queue = static_cast<VkQueue>(renderDevice.getGraphicsQueue());
-		init_info.PipelineCache = VK_NULL_HANDLE;
+		init_info.PipelineCache = renderDevice.getPipelineCache();
 		init_info.DescriptorPool = pool;
+		init_info.Subpass = subpass;
 		init_info.Allocator = nullptr;
 		init_info.MinImageCount = swapchain.getSwapchainCapabilities().minImageCount;
 		init_info.ImageCount = swapchain.numSwapchainImages();
 		init_info.CheckVkResultFn = nullptr;
 
-		guiPass.addAttachment(swapchain.getSwapchainFormat(), vk::AttachmentLoadOp::eLoad, vk::AttachmentStoreOp::eStore, vk::ImageLayout::eColorAttachmentOptimal, vk::ImageLayout::ePresentSrcKHR);
-		
-		vk::AttachmentReference colorAttachmentRef = vk::AttachmentReference(0, vk::ImageLayout::eColorAttachmentOptimal);
-		std::vector<vk::AttachmentReference> colorAttachmentRefs;
-		colorAttachmentRefs.push_back(colorAttachmentRef);
-
-		std::vector<vk::AttachmentReference> inputAttachmentRefs;
-
-		guiPass.addSubpass(colorAttachmentRefs, inputAttachmentRefs, nullptr);
-
-		vk::SubpassDependency dependency;
-		dependency.setSrcSubpass(VK_SUBPASS_EXTERNAL);
-		dependency.setDstSubpass(0);
-		dependency.setSrcAccessMask(vk::AccessFlagBits::eNone);
-		dependency.setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite);
-		dependency.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		dependency.setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-
-		guiPass.build();
-		ImGui_ImplVulkan_Init(&init_info, static_cast<VkRenderPass>(guiPass.getRenderpass()));
+		ImGui_ImplVulkan_Init(&init_info, static_cast<VkRenderPass>(renderPass));
 
 		vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
 		ImGui_ImplVulkan_CreateFontsTexture(static_cast<VkCommandBuffer>(commandBuffer));
 		renderDevice.endSingleTimeCommandBuffers(commandBuffer);
 
-		createFramebuffers();
-	}
-
-	NYGUIDevice::~NYGUIDevice(){
-		ImGui_ImplVulkan_Shutdown();
-		ImGui_ImplGlfw_Shutdown();
-		renderDevice.getDevice().destroyDescriptorPool(pool);
-		for (int i = 0; i < framebuffers.size(); i++) {
-			renderDevice.getDevice().destroyFramebuffer(framebuffers[i]);
-		}
-		ImGui::DestroyContext();
+		initialized = true;
 	}
 
-	void NYGUIDevice::recordCommands(vk::CommandBuffer& commandBuffer, NYPipeline& pipeline, uint32_t imageIndex){
-		guiPass.begin(commandBuffer, framebuffers[imageIndex], swapchain.getSwapchainExtent(), glm::vec4(1.0));
-		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.getPipeline());
+	void NYGUIDevice::recordCommands(vk::CommandBuffer& commandBuffer){
 		auto draw_data = ImGui::GetDrawData();
 		ImGui_ImplVulkan_RenderDrawData(draw_data, commandBuffer, NULL);
-		guiPass.end(commandBuffer);
-	}
-
-	void NYGUIDevice::createFramebuffers(){
-		framebuffers.resize(swapchain.numSwapchainImages());
-		for (int i = 0; i < framebuffers.size(); i++) {
-			vk::FramebufferCreateInfo createInfo;
-			createInfo.attachmentCount = 1;
-			createInfo.pAttachments = swapchain.getImageView_Ptr(i);
-			createInfo.layers = 1;
-			createInfo.setWidth(swapchain.getSwapchainExtent().width);
-			createInfo.setHeight(swapchain.getSwapchainExtent().height);
-			createInfo.setRenderPass(guiPass.getRenderpass());
-
-			framebuffers[i] = renderDevice.getDevice().createFramebuffer(createInfo);
-		}
 	}
 }
\ No newline at end of file
@@ -2,8 +2,6 @@
 #include "pch.hpp"
 #include "backend/NYRenderDevice.hpp"
 #include "backend/NYSwapchain.hpp"
-#include "backend/NYRenderPass.hpp"
-#include "backend/NYPipeline.hpp"
 
 namespace Nya {
 	class NYGUIDevice {
@@ -14,16 +12,15 @@ namespace Nya {
 		NYGUIDevice(NYGUIDevice const&) = delete;
 		NYGUIDevice& operator=(NYGUIDevice const&) = delete;
 
-		void recordCommands(vk::CommandBuffer& commandBuffer, NYPipeline& pipeline, uint32_t imageIndex);
+		//imgui's pipeline is made for one subpass, so the vulkan side is only set up once the frame graph has placed the gui pass
+		void init(vk::RenderPass renderPass, uint32_t subpass);
+		bool isInitialized() { return initialized; }
+		void recordCommands(vk::CommandBuffer& commandBuffer);
 	private:
 		NYRenderDevice& renderDevice;
 		NYSwapchain& swapchain;
 
-		NYRenderPass guiPass{renderDevice};
-
 		vk::DescriptorPool pool;
-		std::vector<vk::Framebuffer> framebuffers;
-
-		void createFramebuffers();
+		bool initialized = false;
 	};
 }
@@ -0,0 +1,224 @@
+#include "pch.hpp"
+#include "NYAssetPack.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYHash.hpp"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Nya {
+	static const char packMagic[8] = { 'N', 'Y', 'A', 'P', 'A', 'C', 'K', '\0' };
+	static const uint32_t packVersion = 1;
+	//blobs start on page boundaries, so they can be mapped, copied or read unbuffered without straddling pages
+	static const uint64_t blobAlignment = 4096;
+
+	struct NYAssetPack::Header {
+		char magic[8];
+		uint32_t version;
+		uint32_t entryCount;
+		uint64_t tocOffset;
+		uint64_t stringsOffset;
+		uint64_t stringsSize;
+	};
+
+	struct NYAssetPack::Entry {
+		uint64_t pathHash;
+		uint64_t offset;
+		uint64_t size;
+		uint32_t pathOffset;
+		uint32_t pathLength;
+	};
+
+	static uint64_t hashPath(const std::string& path){
+		NYHash hash;
+		hash.addString(path);
+		return hash.get();
+	}
+
+	NYAssetPack::~NYAssetPack(){
+		close();
+	}
+
+	bool NYAssetPack::open(const std::string& path){
+		close();
+#ifdef _WIN32
+		file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+		LARGE_INTEGER fileSize;
+		if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize)) {
+			NYLogger::logWarning("Failed to open asset pack %s", path.c_str());
+			close();
+			return false;
+		}
+		mappingSize = static_cast<size_t>(fileSize.QuadPart);
+		fileMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		mapping = fileMapping ? static_cast<const uint8_t*>(MapViewOfFile(fileMapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+#else
+		file = ::open(path.c_str(), O_RDONLY);
+		struct stat fileStat;
+		if (file < 0 || fstat(file, &fileStat) != 0) {
+			NYLogger::logWarning("Failed to open asset pack %s", path.c_str());
+			close();
+			return false;
+		}
+		mappingSize = static_cast<size_t>(fileStat.st_size);
+		void* view = mmap(nullptr, mappingSize, PROT_READ, MAP_SHARED, file, 0);
+		mapping = view != MAP_FAILED ? static_cast<const uint8_t*>(view) : nullptr;
+#endif
+		if (!mapping) {
+			NYLogger::logWarning("Failed to map asset pack %s", path.c_str());
+			close();
+			return false;
+		}
+
+		Header header;
+		if (mappingSize < sizeof(header)) {
+			NYLogger::logWarning("%s isn't an asset pack", path.c_str());
+			close();
+			return false;
+		}
+		memcpy(&header, mapping, sizeof(header));
+		if (memcmp(header.magic, packMagic, sizeof(packMagic)) != 0 || header.version != packVersion ||
+			header.tocOffset > mappingSize || header.tocOffset % alignof(Entry) != 0 || header.entryCount > (mappingSize - header.tocOffset) / sizeof(Entry) ||
+			header.stringsOffset > mappingSize || header.stringsSize > mappingSize - header.stringsOffset) {
+			NYLogger::logWarning("%s isn't an asset pack this version can read", path.c_str());
+			close();
+			return false;
+		}
+		entryCount = header.entryCount;
+		entries = reinterpret_cast<const Entry*>(mapping + header.tocOffset);
+		strings = reinterpret_cast<const char*>(mapping + header.stringsOffset);
+
+		//checked once here so find() and the blobs it hands out can trust the table
+		for (uint32_t i = 0; i < entryCount; i++) {
+			const Entry& entry = entries[i];
+			if (entry.offset > mappingSize || entry.size > mappingSize - entry.offset ||
+				entry.pathOffset > header.stringsSize || entry.pathLength > header.stringsSize - entry.pathOffset) {
+				NYLogger::logWarning("%s has an entry pointing outside the pack, it's corrupt", path.c_str());
+				close();
+				return false;
+			}
+		}
+		NYLogger::logTrace("asset pack %s mapped, %u entries", path.c_str(), entryCount);
+		return true;
+	}
+
+	void NYAssetPack::close(){
+#ifdef _WIN32
+		if (mapping) {
+			UnmapViewOfFile(mapping);
+		}
+		if (fileMapping) {
+			CloseHandle(fileMapping);
+		}
+		if (file != INVALID_HANDLE_VALUE) {
+			CloseHandle(file);
+		}
+		fileMapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (mapping) {
+			munmap(const_cast<uint8_t*>(mapping), mappingSize);
+		}
+		if (file >= 0) {
+			::close(file);
+		}
+		file = -1;
+#endif
+		mapping = nullptr;
+		mappingSize = 0;
+		entryCount = 0;
+		entries = nullptr;
+		strings = nullptr;
+	}
+
+	NYAssetPack::Blob NYAssetPack::find(const std::string& path){
+		Blob blob;
+		if (!mapping) {
+			return blob;
+		}
+		std::string normalized = normalizePath(path);
+		uint64_t hash = hashPath(normalized);
+
+		const Entry* end = entries + entryCount;
+		const Entry* entry = std::lower_bound(entries, end, hash, [](const Entry& entry, uint64_t hash) { return entry.pathHash < hash; });
+		//paths sharing a hash sit next to each other, the stored path settles it
+		for (; entry != end && entry->pathHash == hash; entry++) {
+			if (entry->pathLength == normalized.size() && memcmp(strings + entry->pathOffset, normalized.data(), normalized.size()) == 0) {
+				blob.data = mapping + entry->offset;
+				blob.size = static_cast<size_t>(entry->size);
+				return blob;
+			}
+		}
+		return blob;
+	}
+
+	std::string NYAssetPack::normalizePath(const std::string& path){
+		std::string normalized = path;
+		std::replace(normalized.begin(), normalized.end(), '\\', '/');
+		while (normalized.compare(0, 2, "./") == 0) {
+			normalized.erase(0, 2);
+		}
+		return normalized;
+	}
+
+	bool NYAssetPack::write(const std::string& packPath, std::vector<PackEntry>& packEntries){
+		std::ofstream output(packPath, std::ios::binary);
+		if (!output.is_open()) {
+			NYLogger::logWarning("Failed to write asset pack %s", packPath.c_str());
+			return false;
+		}
+
+		//the header is written last, once the table's offset is known
+		std::vector<Entry> toc;
+		std::string pathStrings;
+		std::vector<uint8_t> data;
+		uint64_t offset = blobAlignment;
+		std::vector<char> padding(blobAlignment, 0);
+		output.write(padding.data(), blobAlignment);
+
+		for (auto& packEntry : packEntries) {
+			data.clear();
+			if (!packEntry.read(data)) {
+				NYLogger::logWarning("Failed to read %s, left out of the pack", packEntry.path.c_str());
+				continue;
+			}
+			std::string path = normalizePath(packEntry.path);
+
+			Entry entry{};
+			entry.pathHash = hashPath(path);
+			entry.offset = offset;
+			entry.size = data.size();
+			entry.pathOffset = static_cast<uint32_t>(pathStrings.size());
+			entry.pathLength = static_cast<uint32_t>(path.size());
+			toc.push_back(entry);
+			pathStrings += path;
+
+			output.write(reinterpret_cast<const char*>(data.data()), data.size());
+			uint64_t padded = (data.size() + blobAlignment - 1) / blobAlignment * blobAlignment;
+			output.write(padding.data(), padded - data.size());
+			offset += padded;
+		}
+
+		std::sort(toc.begin(), toc.end(), [](const Entry& a, const Entry& b) { return a.pathHash < b.pathHash; });
+		Header header{};
+		memcpy(header.magic, packMagic, sizeof(packMagic));
+		header.version = packVersion;
+		header.entryCount = static_cast<uint32_t>(toc.size());
+		header.tocOffset = offset;
+		header.stringsOffset = offset + toc.size() * sizeof(Entry);
+		header.stringsSize = pathStrings.size();
+		output.write(reinterpret_cast<const char*>(toc.data()), toc.size() * sizeof(Entry));
+		output.write(pathStrings.data(), pathStrings.size());
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		if (!output.good()) {
+			NYLogger::logWarning("Failed to write asset pack %s", packPath.c_str());
+			return false;
+		}
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include "pch.hpp"
+
+/*
+read only archive of asset files, memory mapped so opening it is the only file open
+-a header, then every file's bytes starting on a 4096 byte boundary, then the table of contents
+-the table is sorted by a hash of the file's path so lookups are a binary search, paths are kept too to tell collisions apart
+-paths are stored with forward slashes, relative to the parent of the packed directory, so packing res gives res/...
+blobs are handed out as pointers into the mapping, nothing is copied until it's memcpy'd into staging
+*/
+
+namespace Nya {
+	class NYAssetPack {
+	public:
+		struct Blob {
+			const uint8_t* data = nullptr;
+			size_t size = 0;
+		};
+
+		//one file going into a pack, read is called once when its turn to be written comes, so only one is held in memory at a time
+		struct PackEntry {
+			std::string path;
+			std::function<bool(std::vector<uint8_t>&)> read;
+		};
+
+		NYAssetPack() {};
+		~NYAssetPack();
+
+		NYAssetPack(NYAssetPack const&) = delete;
+		NYAssetPack& operator=(NYAssetPack const&) = delete;
+
+		//maps the whole pack, false and a warning if it isn't one
+		bool open(const std::string& path);
+		void close();
+		bool isOpen() { return mapping != nullptr; }
+
+		//a null blob if the path isn't in the pack. the blob is valid until the pack is closed
+		//safe from any thread once the pack is open
+		Blob find(const std::string& path);
+		uint32_t getEntryCount() { return entryCount; }
+
+		//forward slashes and no leading ./, what paths are hashed and stored as
+		static std::string normalizePath(const std::string& path);
+		//writes entries into a new pack at packPath, entries that fail to read are skipped with a warning
+		static bool write(const std::string& packPath, std::vector<PackEntry>& entries);
+
+	private:
+		//laid out as in the file, defined in the cpp
+		struct Header;
+		struct Entry;
+
+		const uint8_t* mapping = nullptr;
+		size_t mappingSize = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE fileMapping = nullptr;
+#else
+		int file = -1;
+#endif
+
+		uint32_t entryCount = 0;
+		//both point into the mapping
+		const Entry* entries = nullptr;
+		const char* strings = nullptr;
+	};
+}
\ No newline at end of file
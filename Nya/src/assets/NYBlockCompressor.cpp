@@ -0,0 +1,396 @@
+#include "pch.hpp"
+#include "NYBlockCompressor.hpp"
+
+namespace Nya {
+	//bc7 4 bit index interpolation weights, out of 64
+	static const uint32_t bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	//a few rounds of power iteration are plenty for a 4x4 block, false if the start vector got sent to zero
+	static bool powerIterate(const float covariance[4][4], uint32_t channelCount, float* axis){
+		for (uint32_t iteration = 0; iteration < 8; iteration++) {
+			float next[4] = {};
+			float length = 0.0f;
+			for (uint32_t a = 0; a < channelCount; a++) {
+				for (uint32_t b = 0; b < channelCount; b++) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				length += next[a] * next[a];
+			}
+			length = std::sqrt(length);
+			if (length <= 1e-6f) {
+				return false;
+			}
+			for (uint32_t c = 0; c < channelCount; c++) {
+				axis[c] = next[c] / length;
+			}
+		}
+		return true;
+	}
+
+	static float getVarianceAlong(const float covariance[4][4], uint32_t channelCount, const float* axis){
+		float variance = 0.0f;
+		for (uint32_t a = 0; a < channelCount; a++) {
+			for (uint32_t b = 0; b < channelCount; b++) {
+				variance += axis[a] * covariance[a][b] * axis[b];
+			}
+		}
+		return variance;
+	}
+
+	//mean and dominant direction of the block's first channelCount channels, the axis is zero for flat blocks
+	static void findPrincipalAxis(const uint8_t* texels, uint32_t channelCount, float* mean, float* axis){
+		float minimum[4];
+		float maximum[4];
+		for (uint32_t c = 0; c < channelCount; c++) {
+			mean[c] = 0.0f;
+			minimum[c] = 255.0f;
+			maximum[c] = 0.0f;
+			for (uint32_t i = 0; i < 16; i++) {
+				mean[c] += texels[i * 4 + c];
+				minimum[c] = std::min(minimum[c], static_cast<float>(texels[i * 4 + c]));
+				maximum[c] = std::max(maximum[c], static_cast<float>(texels[i * 4 + c]));
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		uint32_t widest = 0;
+		for (uint32_t a = 0; a < channelCount; a++) {
+			for (uint32_t i = 0; i < 16; i++) {
+				for (uint32_t b = 0; b < channelCount; b++) {
+					covariance[a][b] += (texels[i * 4 + a] - mean[a]) * (texels[i * 4 + b] - mean[b]);
+				}
+			}
+			if (covariance[a][a] > covariance[widest][widest]) {
+				widest = a;
+			}
+		}
+		if (covariance[widest][widest] <= 1e-6f) {
+			for (uint32_t c = 0; c < channelCount; c++) {
+				axis[c] = 0.0f;
+			}
+			return;
+		}
+
+		//the all ones start gets sent to zero on edges between complementary colours, like red against green.
+		//the row of the channel that varies most can't be, its own channel's variance keeps it off zero
+		for (uint32_t c = 0; c < channelCount; c++) {
+			axis[c] = 1.0f;
+		}
+		if (!powerIterate(covariance, channelCount, axis)) {
+			for (uint32_t c = 0; c < channelCount; c++) {
+				axis[c] = covariance[widest][c];
+			}
+			powerIterate(covariance, channelCount, axis);
+		}
+
+		//never worse than the bounding box diagonal
+		float diagonal[4];
+		float length = 0.0f;
+		for (uint32_t c = 0; c < channelCount; c++) {
+			diagonal[c] = maximum[c] - minimum[c];
+			length += diagonal[c] * diagonal[c];
+		}
+		length = std::sqrt(length);
+		for (uint32_t c = 0; c < channelCount; c++) {
+			diagonal[c] /= length;
+		}
+		if (getVarianceAlong(covariance, channelCount, diagonal) > getVarianceAlong(covariance, channelCount, axis)) {
+			for (uint32_t c = 0; c < channelCount; c++) {
+				axis[c] = diagonal[c];
+			}
+		}
+	}
+
+	//the block's texels projected onto the axis give the endpoints, clamped to the byte range
+	static void findEndpoints(const uint8_t* texels, uint32_t channelCount, float* endpoint0, float* endpoint1){
+		float mean[4];
+		float axis[4];
+		findPrincipalAxis(texels, channelCount, mean, axis);
+
+		float minT = 0.0f;
+		float maxT = 0.0f;
+		for (uint32_t i = 0; i < 16; i++) {
+			float t = 0.0f;
+			for (uint32_t c = 0; c < channelCount; c++) {
+				t += (texels[i * 4 + c] - mean[c]) * axis[c];
+			}
+			minT = std::min(minT, t);
+			maxT = std::max(maxT, t);
+		}
+		for (uint32_t c = 0; c < channelCount; c++) {
+			endpoint0[c] = std::clamp(mean[c] + axis[c] * minT, 0.0f, 255.0f);
+			endpoint1[c] = std::clamp(mean[c] + axis[c] * maxT, 0.0f, 255.0f);
+		}
+	}
+
+	static uint16_t packRGB565(const float* color){
+		uint32_t r = static_cast<uint32_t>(color[0] * 31.0f / 255.0f + 0.5f);
+		uint32_t g = static_cast<uint32_t>(color[1] * 63.0f / 255.0f + 0.5f);
+		uint32_t b = static_cast<uint32_t>(color[2] * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	static void unpackRGB565(uint16_t packed, int32_t* color){
+		uint32_t r = (packed >> 11) & 31;
+		uint32_t g = (packed >> 5) & 63;
+		uint32_t b = packed & 31;
+		color[0] = static_cast<int32_t>((r << 3) | (r >> 2));
+		color[1] = static_cast<int32_t>((g << 2) | (g >> 4));
+		color[2] = static_cast<int32_t>((b << 3) | (b >> 2));
+	}
+
+	//writes bc7 fields lowest bit first
+	class BitWriter {
+	public:
+		BitWriter(uint8_t* _block) :block(_block) { memset(block, 0, 16); }
+		void write(uint32_t value, uint32_t bitCount) {
+			for (uint32_t i = 0; i < bitCount; i++, position++) {
+				block[position / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (position % 8));
+			}
+		}
+	private:
+		uint8_t* block;
+		uint32_t position = 0;
+	};
+
+	uint32_t NYBlockCompressor::getBlockBytes(Format format){
+		return format == Format::eBC1 || format == Format::eBC4 ? 8 : 16;
+	}
+
+	std::vector<uint8_t> NYBlockCompressor::compress(Format format, const uint8_t* pixels, uint32_t width, uint32_t height){
+		uint32_t blocksX = (width + 3) / 4;
+		uint32_t blocksY = (height + 3) / 4;
+		uint32_t blockBytes = getBlockBytes(format);
+		std::vector<uint8_t> blocks(static_cast<size_t>(blocksX) * blocksY * blockBytes);
+
+		uint8_t texels[64];
+		for (uint32_t blockY = 0; blockY < blocksY; blockY++) {
+			for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+				for (uint32_t i = 0; i < 16; i++) {
+					uint32_t x = std::min(blockX * 4 + i % 4, width - 1);
+					uint32_t y = std::min(blockY * 4 + i / 4, height - 1);
+					memcpy(texels + i * 4, pixels + (static_cast<size_t>(y) * width + x) * 4, 4);
+				}
+
+				uint8_t* block = blocks.data() + (static_cast<size_t>(blockY) * blocksX + blockX) * blockBytes;
+				switch (format) {
+				case Format::eBC1:
+					compressBC1(texels, block);
+					break;
+				case Format::eBC3:
+					compressBC4(texels, 3, block);
+					compressBC1(texels, block + 8);
+					break;
+				case Format::eBC4:
+					compressBC4(texels, 0, block);
+					break;
+				case Format::eBC7:
+					compressBC7(texels, block);
+					break;
+				}
+			}
+		}
+		return blocks;
+	}
+
+	void NYBlockCompressor::compressBC1(const uint8_t* texels, uint8_t* block){
+		float endpoint0[3];
+		float endpoint1[3];
+		findEndpoints(texels, 3, endpoint0, endpoint1);
+
+		//the first color has to be the larger one, otherwise the block is read in 3 color mode with transparent black
+		uint16_t color0 = packRGB565(endpoint1);
+		uint16_t color1 = packRGB565(endpoint0);
+		if (color0 < color1) {
+			std::swap(color0, color1);
+		}
+
+		int32_t palette[4][3];
+		unpackRGB565(color0, palette[0]);
+		unpackRGB565(color1, palette[1]);
+		for (uint32_t c = 0; c < 3; c++) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		//equal endpoints are in 3 color mode, index 0 is still the right color there
+		if (color0 != color1) {
+			for (uint32_t i = 0; i < 16; i++) {
+				uint32_t bestIndex = 0;
+				int32_t bestError = INT32_MAX;
+				for (uint32_t index = 0; index < 4; index++) {
+					int32_t error = 0;
+					for (uint32_t c = 0; c < 3; c++) {
+						int32_t difference = palette[index][c] - texels[i * 4 + c];
+						error += difference * difference;
+					}
+					if (error < bestError) {
+						bestError = error;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (i * 2);
+			}
+		}
+
+		memcpy(block, &color0, 2);
+		memcpy(block + 2, &color1, 2);
+		memcpy(block + 4, &indices, 4);
+	}
+
+	void NYBlockCompressor::compressBC4(const uint8_t* texels, uint32_t channel, uint8_t* block){
+		uint8_t minValue = 255;
+		uint8_t maxValue = 0;
+		for (uint32_t i = 0; i < 16; i++) {
+			minValue = std::min(minValue, texels[i * 4 + channel]);
+			maxValue = std::max(maxValue, texels[i * 4 + channel]);
+		}
+
+		//the first value larger picks the 8 value mode, a flat block decodes fine in the other one
+		block[0] = maxValue;
+		block[1] = minValue;
+		uint64_t indices = 0;
+		if (maxValue != minValue) {
+			int32_t palette[8];
+			palette[0] = maxValue;
+			palette[1] = minValue;
+			for (int32_t index = 2; index < 8; index++) {
+				palette[index] = ((8 - index) * maxValue + (index - 1) * minValue) / 7;
+			}
+			for (uint32_t i = 0; i < 16; i++) {
+				uint64_t bestIndex = 0;
+				int32_t bestError = INT32_MAX;
+				for (uint32_t index = 0; index < 8; index++) {
+					int32_t error = std::abs(palette[index] - texels[i * 4 + channel]);
+					if (error < bestError) {
+						bestError = error;
+						bestIndex = index;
+					}
+				}
+				indices |= bestIndex << (i * 3);
+			}
+		}
+		for (uint32_t i = 0; i < 6; i++) {
+			block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+		}
+	}
+
+	void NYBlockCompressor::compressBC7(const uint8_t* texels, uint8_t* block){
+		float endpoints[2][4];
+		findEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+		//mode 6 endpoints are 7 bits a channel plus one shared low bit per endpoint
+		uint32_t quantized[2][4];
+		uint32_t pBits[2];
+		int32_t palette[16][4];
+		uint32_t indices[16];
+		uint64_t bestError = UINT64_MAX;
+		uint32_t bestQuantized[2][4];
+		uint32_t bestPBits[2];
+		uint32_t bestIndices[16];
+
+		//the second round refits the endpoints to the first round's indices with least squares
+		for (uint32_t round = 0; round < 2; round++) {
+			for (uint32_t e = 0; e < 2; e++) {
+				uint32_t bestPError = UINT32_MAX;
+				for (uint32_t p = 0; p < 2; p++) {
+					uint32_t pError = 0;
+					uint32_t candidate[4];
+					for (uint32_t c = 0; c < 4; c++) {
+						float value = (endpoints[e][c] - p) / 2.0f;
+						candidate[c] = static_cast<uint32_t>(std::clamp(value + 0.5f, 0.0f, 127.0f));
+						int32_t difference = static_cast<int32_t>((candidate[c] << 1) | p) - static_cast<int32_t>(endpoints[e][c] + 0.5f);
+						pError += difference * difference;
+					}
+					if (pError < bestPError) {
+						bestPError = pError;
+						pBits[e] = p;
+						memcpy(quantized[e], candidate, sizeof(candidate));
+					}
+				}
+			}
+
+			for (uint32_t index = 0; index < 16; index++) {
+				for (uint32_t c = 0; c < 4; c++) {
+					int32_t value0 = (quantized[0][c] << 1) | pBits[0];
+					int32_t value1 = (quantized[1][c] << 1) | pBits[1];
+					palette[index][c] = ((64 - bc7Weights[index]) * value0 + bc7Weights[index] * value1 + 32) >> 6;
+				}
+			}
+
+			uint64_t error = 0;
+			for (uint32_t i = 0; i < 16; i++) {
+				int32_t bestTexelError = INT32_MAX;
+				for (uint32_t index = 0; index < 16; index++) {
+					int32_t texelError = 0;
+					for (uint32_t c = 0; c < 4; c++) {
+						int32_t difference = palette[index][c] - texels[i * 4 + c];
+						texelError += difference * difference;
+					}
+					if (texelError < bestTexelError) {
+						bestTexelError = texelError;
+						indices[i] = index;
+					}
+				}
+				error += bestTexelError;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				memcpy(bestQuantized, quantized, sizeof(quantized));
+				memcpy(bestPBits, pBits, sizeof(pBits));
+				memcpy(bestIndices, indices, sizeof(indices));
+			}
+			if (round == 1 || error == 0) {
+				break;
+			}
+
+			//solves [a b; b c] [e0; e1] = [x0; x1] per channel with each texel weighted by its index
+			float a = 0.0f, b = 0.0f, d = 0.0f;
+			float x0[4] = {};
+			float x1[4] = {};
+			for (uint32_t i = 0; i < 16; i++) {
+				float w = bc7Weights[indices[i]] / 64.0f;
+				a += (1.0f - w) * (1.0f - w);
+				b += (1.0f - w) * w;
+				d += w * w;
+				for (uint32_t c = 0; c < 4; c++) {
+					x0[c] += (1.0f - w) * texels[i * 4 + c];
+					x1[c] += w * texels[i * 4 + c];
+				}
+			}
+			float determinant = a * d - b * b;
+			if (std::abs(determinant) < 1e-6f) {
+				break;
+			}
+			for (uint32_t c = 0; c < 4; c++) {
+				endpoints[0][c] = std::clamp((d * x0[c] - b * x1[c]) / determinant, 0.0f, 255.0f);
+				endpoints[1][c] = std::clamp((a * x1[c] - b * x0[c]) / determinant, 0.0f, 255.0f);
+			}
+		}
+
+		//the first index is stored with its top bit implied zero, so the endpoints are flipped when it's set
+		if (bestIndices[0] & 8) {
+			std::swap(bestQuantized[0], bestQuantized[1]);
+			std::swap(bestPBits[0], bestPBits[1]);
+			for (uint32_t i = 0; i < 16; i++) {
+				bestIndices[i] = 15 - bestIndices[i];
+			}
+		}
+
+		BitWriter writer(block);
+		writer.write(1 << 6, 7);
+		for (uint32_t c = 0; c < 4; c++) {
+			writer.write(bestQuantized[0][c], 7);
+			writer.write(bestQuantized[1][c], 7);
+		}
+		writer.write(bestPBits[0], 1);
+		writer.write(bestPBits[1], 1);
+		writer.write(bestIndices[0], 3);
+		for (uint32_t i = 1; i < 16; i++) {
+			writer.write(bestIndices[i], 4);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	//cpu encoders for the bc formats the cooker writes, quality over speed since it only runs offline
+	//endpoints come from the principal axis of each 4x4 block, bc7 also gets a least squares pass over them
+	class NYBlockCompressor {
+	public:
+		enum class Format {
+			eBC1,//rgb, 8 bytes a block
+			eBC3,//rgba with a separate bc4 style alpha block, 16 bytes a block
+			eBC4,//the red channel only, 8 bytes a block
+			eBC7,//rgba in mode 6, 16 bytes a block
+		};
+
+		static uint32_t getBlockBytes(Format format);
+		//compresses a tightly packed rgba8 image into row major blocks
+		//images that aren't multiples of 4 get their edge blocks filled by repeating the last row and column
+		static std::vector<uint8_t> compress(Format format, const uint8_t* pixels, uint32_t width, uint32_t height);
+
+	private:
+		//every block takes 16 rgba8 texels in row order
+		static void compressBC1(const uint8_t* texels, uint8_t* block);
+		static void compressBC4(const uint8_t* texels, uint32_t channel, uint8_t* block);
+		static void compressBC7(const uint8_t* texels, uint8_t* block);
+	};
+}
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "pch.hpp"
+#include "NYKTX2.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYImageUtils.hpp"
+
+namespace Nya {
+	static const uint8_t ktx2Identifier[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+	//every level starts on this, a multiple of every supported block size
+	static const size_t levelAlignment = 16;
+
+	//file header and section index, laid out exactly as in the file
+	struct KTX2Header {
+		uint8_t identifier[12];
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(KTX2Header) == 80, "KTX2Header has to match the file layout");
+
+	struct KTX2LevelIndex {
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	//khronos data format values the descriptors below are made of
+	enum : uint32_t {
+		dfModelRGBSDA = 1,
+		dfModelBC1A = 128,
+		dfModelBC3 = 130,
+		dfModelBC4 = 131,
+		dfModelBC7 = 134,
+		dfPrimariesBT709 = 1,
+		dfTransferLinear = 1,
+		dfTransferSRGB = 2,
+		dfChannelAlpha = 15,
+		dfSampleLinear = 0x10,
+	};
+
+	bool NYKTX2::load(const std::string& path){
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			NYLogger::logWarning("Failed to open %s", path.c_str());
+			return false;
+		}
+		fileData.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(fileData.data()), fileData.size());
+
+		if (!parse(fileData.data(), fileData.size())) {
+			NYLogger::logWarning("%s isn't a ktx2 texture that can be loaded", path.c_str());
+			fileData.clear();
+			return false;
+		}
+		return true;
+	}
+
+	bool NYKTX2::parse(const uint8_t* data, size_t size){
+		levels.clear();
+		KTX2Header header;
+		if (size < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if (!isKTX2(data, size)) {
+			return false;
+		}
+		if (header.supercompressionScheme != 0) {
+			NYLogger::logWarning("ktx2 supercompression scheme %u isn't supported", header.supercompressionScheme);
+			return false;
+		}
+		if (header.pixelDepth > 1 || header.layerCount > 1 || header.faceCount != 1 || header.pixelWidth == 0 || header.pixelHeight == 0) {
+			NYLogger::logWarning("only single 2d ktx2 images are supported");
+			return false;
+		}
+		format = static_cast<VkFormat>(header.vkFormat);
+		if (getBlockBytes(format) == 0) {
+			NYLogger::logWarning("ktx2 vkFormat %u isn't supported", header.vkFormat);
+			return false;
+		}
+		width = header.pixelWidth;
+		height = header.pixelHeight;
+
+		//0 levels asks the loader to generate them, only level 0 is stored then
+		uint32_t levelCount = std::max(header.levelCount, 1u);
+		//past the 1x1 level the shifts below stop making sense, and the image couldn't be created with that many levels anyway
+		if (levelCount > NYImageUtils::getMipLevelCount(width, height)) {
+			NYLogger::logWarning("ktx2 has %u levels, more than a %ux%u image can have", levelCount, width, height);
+			return false;
+		}
+		if (size < sizeof(header) + levelCount * sizeof(KTX2LevelIndex)) {
+			return false;
+		}
+		for (uint32_t level = 0; level < levelCount; level++) {
+			KTX2LevelIndex index;
+			memcpy(&index, data + sizeof(header) + level * sizeof(KTX2LevelIndex), sizeof(index));
+
+			Level entry;
+			entry.width = std::max(width >> level, 1u);
+			entry.height = std::max(height >> level, 1u);
+			entry.size = getLevelSize(format, entry.width, entry.height);
+			if (index.byteOffset > size || index.byteLength > size - index.byteOffset || index.byteLength < entry.size) {
+				NYLogger::logWarning("ktx2 level %u is out of the file's bounds", level);
+				levels.clear();
+				return false;
+			}
+			entry.data = data + index.byteOffset;
+			levels.push_back(entry);
+		}
+		return true;
+	}
+
+	bool NYKTX2::isKTX2(const uint8_t* data, size_t size){
+		return size >= sizeof(ktx2Identifier) && memcmp(data, ktx2Identifier, sizeof(ktx2Identifier)) == 0;
+	}
+
+	uint32_t NYKTX2::getBlockBytes(VkFormat format){
+		switch (format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			return 4;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	bool NYKTX2::isBlockCompressed(VkFormat format){
+		return format != VK_FORMAT_R8G8B8A8_UNORM && format != VK_FORMAT_R8G8B8A8_SRGB;
+	}
+
+	size_t NYKTX2::getLevelSize(VkFormat format, uint32_t width, uint32_t height){
+		if (isBlockCompressed(format)) {
+			return static_cast<size_t>((width + 3) / 4) * ((height + 3) / 4) * getBlockBytes(format);
+		}
+		return static_cast<size_t>(width) * height * getBlockBytes(format);
+	}
+
+	std::vector<uint8_t> NYKTX2::write(VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels){
+		NYLogger::checkAssert(getBlockBytes(format) != 0, "NYKTX2::write() unsupported format");
+		bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_BC1_RGB_SRGB_BLOCK || format == VK_FORMAT_BC1_RGBA_SRGB_BLOCK ||
+			format == VK_FORMAT_BC3_SRGB_BLOCK || format == VK_FORMAT_BC7_SRGB_BLOCK;
+		//alpha is linear even in srgb images
+		uint32_t alphaType = dfChannelAlpha | (srgb ? dfSampleLinear : 0);
+
+		//one basic data format descriptor block, samples are {bit offset, bit count, channel type, upper}
+		uint32_t model;
+		std::vector<std::array<uint32_t, 4>> samples;
+		switch (format) {
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			model = dfModelRGBSDA;
+			samples = { { 0, 8, 0, 255 }, { 8, 8, 1, 255 }, { 16, 8, 2, 255 }, { 24, 8, alphaType, 255 } };
+			break;
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			model = dfModelBC1A;
+			samples = { { 0, 64, 0, UINT32_MAX } };
+			break;
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			model = dfModelBC1A;
+			samples = { { 0, 64, 1, UINT32_MAX } };
+			break;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			model = dfModelBC3;
+			samples = { { 0, 64, alphaType, UINT32_MAX }, { 64, 64, 0, UINT32_MAX } };
+			break;
+		case VK_FORMAT_BC4_UNORM_BLOCK:
+			model = dfModelBC4;
+			samples = { { 0, 64, 0, UINT32_MAX } };
+			break;
+		default:
+			model = dfModelBC7;
+			samples = { { 0, 128, 0, UINT32_MAX } };
+			break;
+		}
+		uint32_t blockDimension = isBlockCompressed(format) ? 3 : 0;
+		std::vector<uint32_t> dfd;
+		dfd.push_back(0);//total size, filled in below
+		dfd.push_back(0);//khronos vendor, basic descriptor type
+		dfd.push_back(2 | ((24 + 16 * static_cast<uint32_t>(samples.size())) << 16));//version 1.3, block size
+		dfd.push_back(model | (dfPrimariesBT709 << 8) | ((srgb ? dfTransferSRGB : dfTransferLinear) << 16));
+		dfd.push_back(blockDimension | (blockDimension << 8));
+		dfd.push_back(getBlockBytes(format));
+		dfd.push_back(0);
+		for (auto& sample : samples) {
+			dfd.push_back(sample[0] | ((sample[1] - 1) << 16) | (sample[2] << 24));
+			dfd.push_back(0);
+			dfd.push_back(0);
+			dfd.push_back(sample[3]);
+		}
+		dfd[0] = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+		KTX2Header header{};
+		memcpy(header.identifier, ktx2Identifier, sizeof(ktx2Identifier));
+		header.vkFormat = static_cast<uint32_t>(format);
+		header.typeSize = 1;
+		header.pixelWidth = width;
+		header.pixelHeight = height;
+		header.faceCount = 1;
+		header.levelCount = static_cast<uint32_t>(levels.size());
+		header.dfdByteOffset = static_cast<uint32_t>(sizeof(header) + levels.size() * sizeof(KTX2LevelIndex));
+		header.dfdByteLength = dfd[0];
+
+		//level data goes after the descriptor, smallest level first
+		std::vector<KTX2LevelIndex> levelIndex(levels.size());
+		size_t offset = header.dfdByteOffset + header.dfdByteLength;
+		for (size_t level = levels.size(); level-- > 0;) {
+			offset = (offset + levelAlignment - 1) / levelAlignment * levelAlignment;
+			levelIndex[level].byteOffset = offset;
+			levelIndex[level].byteLength = levels[level].size();
+			levelIndex[level].uncompressedByteLength = levels[level].size();
+			offset += levels[level].size();
+		}
+
+		std::vector<uint8_t> file(offset, 0);
+		memcpy(file.data(), &header, sizeof(header));
+		memcpy(file.data() + sizeof(header), levelIndex.data(), levelIndex.size() * sizeof(KTX2LevelIndex));
+		memcpy(file.data() + header.dfdByteOffset, dfd.data(), header.dfdByteLength);
+		for (size_t level = 0; level < levels.size(); level++) {
+			memcpy(file.data() + levelIndex[level].byteOffset, levels[level].data(), levels[level].size());
+		}
+		return file;
+	}
+}
\ No newline at end of file
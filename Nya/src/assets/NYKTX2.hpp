@@ -0,0 +1,52 @@
+#pragma once
+#include "pch.hpp"
+
+/*
+reader and writer for the subset of ktx2 the cooker produces and NYTexture loads
+-one 2d image, no array layers or cube faces, no supercompression
+-levels are stored smallest first like the spec wants, the level index lists them largest first
+-every level starts on a 16 byte boundary so it can be copied to staging as is
+only the formats below are accepted, anything else is left to stb
+*/
+
+namespace Nya {
+	class NYKTX2 {
+	public:
+		struct Level {
+			const uint8_t* data;
+			size_t size;
+			uint32_t width;
+			uint32_t height;
+		};
+
+		//reads the whole file and parses it, false and a warning if it isn't a ktx2 this can load
+		bool load(const std::string& path);
+		//parses a container that's already in memory, which has to outlive this and its levels
+		bool parse(const uint8_t* data, size_t size);
+
+		VkFormat getFormat() { return format; }
+		uint32_t getWidth() { return width; }
+		uint32_t getHeight() { return height; }
+		//level 0 first
+		const std::vector<Level>& getLevels() { return levels; }
+
+		//only checks the identifier, for telling ktx2 data apart from other images
+		static bool isKTX2(const uint8_t* data, size_t size);
+		//bytes per 4x4 block, or per texel for the uncompressed formats. 0 if the format isn't supported
+		static uint32_t getBlockBytes(VkFormat format);
+		static bool isBlockCompressed(VkFormat format);
+		//tightly packed size of one level
+		static size_t getLevelSize(VkFormat format, uint32_t width, uint32_t height);
+		//serializes levels, level 0 first, into a ktx2 container with a matching data format descriptor
+		static std::vector<uint8_t> write(VkFormat format, uint32_t width, uint32_t height, const std::vector<std::vector<uint8_t>>& levels);
+
+	private:
+		//only set when load() read the file itself
+		std::vector<uint8_t> fileData;
+
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<Level> levels;
+	};
+}
\ No newline at end of file
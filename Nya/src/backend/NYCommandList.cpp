@@ -0,0 +1,47 @@
+#include "pch.hpp"
+#include "NYCommandList.hpp"
+
+namespace Nya {
+	NYCommandList::NYCommandList(vk::CommandBuffer _commandBuffer, vk::Extent2D _extent)
+		:commandBuffer(_commandBuffer), extent(_extent) {
+	}
+
+	NYCommandList::~NYCommandList() {
+	}
+
+	void NYCommandList::bindPipeline(NYPipeline& pipeline) {
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.getPipeline());
+	}
+
+	void NYCommandList::pushConstants(NYPipeline& pipeline, void* pushData, uint32_t size) {
+		commandBuffer.pushConstants(pipeline.getLayout(), vk::ShaderStageFlagBits::eVertex, 0, size, pushData);
+	}
+
+	void NYCommandList::bindDescriptorSet(NYPipeline& pipeline, vk::DescriptorSet& set, uint32_t setIndex, vk::ArrayProxy<const uint32_t> const& dynamicOffsets) {
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.getLayout(), setIndex, set, dynamicOffsets);
+	}
+
+	void NYCommandList::setViewport(glm::vec4 viewport) {
+		vk::Viewport vkViewport(viewport.x * extent.width, viewport.y * extent.height, viewport.z * extent.width, viewport.w * extent.height, 0.0f, 1.0f);
+		vk::Rect2D scissor(vk::Offset2D(static_cast<int32_t>(vkViewport.x), static_cast<int32_t>(vkViewport.y)),
+			vk::Extent2D(static_cast<uint32_t>(vkViewport.width), static_cast<uint32_t>(vkViewport.height)));
+
+		commandBuffer.setViewport(0, vkViewport);
+		commandBuffer.setScissor(0, scissor);
+	}
+
+	void NYCommandList::bindInstanceBuffers(VkBuffer& vertexBuffer, VkBuffer& instanceBuffer, VkBuffer& indexBuffer, vk::DeviceSize instanceOffset) {
+		std::array<vk::Buffer, 2> vertexBuffers = { static_cast<vk::Buffer>(vertexBuffer), static_cast<vk::Buffer>(instanceBuffer) };
+		std::array<vk::DeviceSize, 2> offsets = { 0, instanceOffset };
+		commandBuffer.bindVertexBuffers(0, vertexBuffers, offsets);
+		commandBuffer.bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
+	}
+
+	void NYCommandList::drawInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstInstance) {
+		commandBuffer.drawIndexed(indexCount, instanceCount, 0, 0, firstInstance);
+	}
+
+	void NYCommandList::drawIndexedIndirect(VkBuffer& indirectBuffer, vk::DeviceSize offset, uint32_t drawCount) {
+		commandBuffer.drawIndexedIndirect(indirectBuffer, offset, drawCount, sizeof(VkDrawIndexedIndirectCommand));
+	}
+}
\ No newline at end of file
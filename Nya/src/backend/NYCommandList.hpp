@@ -0,0 +1,32 @@
+#pragma once
+#include "pch.hpp"
+#include "NYPipeline.hpp"
+
+namespace Nya {
+	//records graphics commands into a command buffer, the renderer hands these out for the frame's primary buffer
+	//and for secondary buffers recorded on worker threads, it doesn't own the command buffer
+	class NYCommandList {
+	public:
+		NYCommandList(vk::CommandBuffer _commandBuffer, vk::Extent2D _extent);
+		~NYCommandList();
+
+		vk::CommandBuffer& getCommandBuffer() { return commandBuffer; }
+
+		void bindPipeline(NYPipeline& pipeline);
+		void pushConstants(NYPipeline& pipeline, void* pushData, uint32_t size);
+		void bindDescriptorSet(NYPipeline& pipeline, vk::DescriptorSet& set, uint32_t setIndex,
+			vk::ArrayProxy<const uint32_t> const& dynamicOffsets = nullptr);
+		//viewport is normalized to the extent, xy = offset, zw = size, the scissor matches it
+		void setViewport(glm::vec4 viewport);
+
+		//binds the shared geometry and the instance buffer once so every batch is a single draw
+		void bindInstanceBuffers(VkBuffer& vertexBuffer, VkBuffer& instanceBuffer, VkBuffer& indexBuffer, vk::DeviceSize instanceOffset = 0);
+		void drawInstanced(uint32_t indexCount, uint32_t instanceCount, uint32_t firstInstance);
+		//draw parameters are read from a buffer written on the gpu
+		void drawIndexedIndirect(VkBuffer& indirectBuffer, vk::DeviceSize offset, uint32_t drawCount);
+
+	private:
+		vk::CommandBuffer commandBuffer;
+		vk::Extent2D extent;
+	};
+}
\ No newline at end of file
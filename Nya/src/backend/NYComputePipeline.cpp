@@ -0,0 +1,63 @@
+#include "pch.hpp"
+#include "NYComputePipeline.hpp"
+#include "logging/NYLogger.hpp"
+
+namespace Nya {
+	NYComputePipeline::NYComputePipeline(NYRenderDevice& _renderDevice, NYShader& _shader, NYDescriptorSetLayout& _descLayout, uint32_t _pushConstantSize)
+		:renderDevice(_renderDevice), shader(_shader), descLayout(_descLayout), pushConstantSize(_pushConstantSize) {
+		NYLogger::checkAssert(shader.isCompute(), "NYComputePipeline needs an NYShader made from a compute shader");
+		NYLogger::checkAssert(descLayout.isBuilt(), "NYDescriptorSetLayout must be built before passing as parameter");
+		createPipelineLayout();
+		createPipeline();
+	}
+
+	NYComputePipeline::~NYComputePipeline(){
+		renderDevice.getDevice().destroyPipelineLayout(pipelineLayout);
+		renderDevice.getDevice().destroyPipeline(pipeline);
+
+		NYLogger::logTrace("NYComputePipeline destroyed");
+	}
+
+	void NYComputePipeline::createPipelineLayout(){
+		vk::PushConstantRange range;
+		range.offset = 0;
+		range.size = pushConstantSize;
+		range.stageFlags = vk::ShaderStageFlagBits::eCompute;
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo(vk::PipelineLayoutCreateFlags(),
+														1,
+														&descLayout.getLayout(),//pSetLayouts
+														pushConstantSize > 0 ? 1 : 0,//pushConstantRangeCount
+														&range);//pPushConstantRanges
+
+		pipelineLayout = renderDevice.getDevice().createPipelineLayout(pipelineLayoutInfo);
+	}
+
+	void NYComputePipeline::createPipeline(){
+		std::unique_lock<std::mutex> moduleLock = shader.lockModules();
+		pipeline = buildPipeline(shader.getComputeModule());
+		NYLogger::logTrace("NYComputePipeline created");
+	}
+
+	vk::Pipeline NYComputePipeline::buildPipeline(vk::ShaderModule computeModule){
+		vk::PipelineShaderStageCreateInfo stageInfo(vk::PipelineShaderStageCreateFlags(),
+			vk::ShaderStageFlagBits::eCompute,
+			computeModule,
+			"main");
+
+		vk::ComputePipelineCreateInfo pipelineInfo(vk::PipelineCreateFlags(),
+												   stageInfo,
+												   pipelineLayout);
+
+		return renderDevice.createComputePipeline(pipelineInfo);
+	}
+
+	void NYComputePipeline::swapPipeline(vk::Pipeline newPipeline){
+		vk::Pipeline oldPipeline = pipeline;
+		vk::Device device = renderDevice.getDevice();
+		renderDevice.deferRelease(renderDevice.getSubmittedValue(), [device, oldPipeline]() {
+			device.destroyPipeline(oldPipeline);
+		});
+		pipeline = newPipeline;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYDescriptorSetLayout.hpp"
+#include "NYShader.hpp"
+
+/*
+This class is supposed to wrap a compute vk::Pipeline, the compute counterpart of NYPipeline
+*/
+
+namespace Nya {
+	class NYComputePipeline {
+	public:
+		NYComputePipeline(NYComputePipeline const&) = delete;
+		NYComputePipeline& operator=(NYComputePipeline const&) = delete;
+
+		//pushConstantSize can be 0 if the shader doesn't use push constants
+		NYComputePipeline(NYRenderDevice& _renderDevice, NYShader& _shader, NYDescriptorSetLayout& _descLayout, uint32_t _pushConstantSize);
+		~NYComputePipeline();
+
+		//getters
+		vk::Pipeline& getPipeline() { return pipeline; }
+		vk::PipelineLayout& getLayout() { return pipelineLayout; }
+		vk::DescriptorSetLayout& getDescriptorSetLayout() { return descLayout.getLayout(); }
+		NYShader& getShader() { return shader; }
+
+		//hot reload, same as NYPipeline's
+		vk::Pipeline buildPipeline(vk::ShaderModule computeModule);
+		void swapPipeline(vk::Pipeline newPipeline);
+
+	private:
+		void createPipelineLayout();
+		void createPipeline();
+
+		NYRenderDevice& renderDevice;
+		NYShader& shader;
+		NYDescriptorSetLayout& descLayout;
+
+		uint32_t pushConstantSize;
+
+		vk::PipelineLayout pipelineLayout;
+		vk::Pipeline pipeline;
+	};
+}
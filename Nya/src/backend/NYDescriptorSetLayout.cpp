@@ -11,7 +11,7 @@ namespace Nya {
 		renderDevice.getDevice().destroyDescriptorSetLayout(layout);
 	}
 
-	void NYDescriptorSetLayout::addBinding(vk::DescriptorType type, uint32_t count, vk::ShaderStageFlags shaderStages){
+	void NYDescriptorSetLayout::addBinding(vk::DescriptorType type, uint32_t count, vk::ShaderStageFlags shaderStages, vk::DescriptorBindingFlags flags){
 		NYLogger::checkAssert(!build, "Can't add binding after calling buildLayout()");
 
 		vk::DescriptorSetLayoutBinding& binding = bindings.emplace_back();
@@ -20,6 +20,9 @@ namespace Nya {
 		binding.descriptorCount = count;
 		binding.stageFlags = shaderStages;
 
+		bindingFlags.push_back(flags);
+		if (flags & vk::DescriptorBindingFlagBits::eUpdateAfterBind) { updateAfterBind = true; }
+
 		bindingIndex++;
 	}
 
@@ -33,14 +36,6 @@ namespace Nya {
 
 		createPoolSize();
 
-		//make it so that we are able to change the descriptor data after it has been bound once, allowing for things like texture swapping
-		std::vector<vk::DescriptorBindingFlags> bindingFlags;
-		bindingFlags.resize(bindings.size());
-
-		for (auto& flag : bindingFlags) {
-			flag = vk::DescriptorBindingFlagBits::eUpdateAfterBind;
-		}
-
 		vk::DescriptorSetLayoutBindingFlagsCreateInfo flagsInfo;
 		flagsInfo.bindingCount = bindings.size();
 		flagsInfo.pBindingFlags = bindingFlags.data();
@@ -48,7 +43,9 @@ namespace Nya {
 		vk::DescriptorSetLayoutCreateInfo createInfo{};
 		createInfo.setBindings(bindings);
 		createInfo.pNext = &flagsInfo;
-		createInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+		if (updateAfterBind) {
+			createInfo.flags = vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool;
+		}
 		
 		layout = renderDevice.getDevice().createDescriptorSetLayout(createInfo);
 		build = true;
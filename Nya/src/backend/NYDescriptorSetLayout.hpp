@@ -14,11 +14,15 @@ namespace Nya{
 
 
 		vk::DescriptorSetLayout& getLayout(){return layout;}
-		void addBinding(vk::DescriptorType type, uint32_t count, vk::ShaderStageFlags shaderStages);
+		//bindings are update after bind by default so their data can change after the set has been bound, allowing for things like texture swapping
+		void addBinding(vk::DescriptorType type, uint32_t count, vk::ShaderStageFlags shaderStages,
+			vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::eUpdateAfterBind);
 		vk::DescriptorType getType(uint32_t bindingIndex);
 		void buildLayout();
 		std::vector<vk::DescriptorPoolSize>& getPoolSizes(uint32_t numSets);
 		bool isBuilt() { return build; }
+		//pools that sets of this layout are allocated from need the update after bind flag if this is true
+		bool isUpdateAfterBind() { return updateAfterBind; }
 	private:
 
 		void createPoolSize();
@@ -26,6 +30,7 @@ namespace Nya{
 		NYRenderDevice& renderDevice;
 
 		std::vector<vk::DescriptorSetLayoutBinding> bindings;
+		std::vector<vk::DescriptorBindingFlags> bindingFlags;
 		vk::DescriptorSetLayoutCreateInfo layoutInfo;
 		vk::DescriptorSetLayout layout;
 		std::vector<vk::DescriptorPoolSize> poolSizes;
@@ -33,5 +38,6 @@ namespace Nya{
 		uint32_t bindingIndex = 0;
 
 		bool build = false;
+		bool updateAfterBind = false;
 	};
 }
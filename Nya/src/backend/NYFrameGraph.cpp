@@ -0,0 +1,564 @@
+#include "pch.hpp"
+#include "NYFrameGraph.hpp"
+#include "logging/NYLogger.hpp"
+
+namespace Nya {
+	NYFrameGraph::NYFrameGraph(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain)
+		:renderDevice(_renderDevice), swapchain(_swapchain) {
+	}
+
+	NYFrameGraph::~NYFrameGraph() {
+		for (auto& group : groups) {
+			for (auto& framebuffer : group.framebuffers) {
+				renderDevice.getDevice().destroyFramebuffer(framebuffer);
+			}
+		}
+
+		for (auto& resource : resources) {
+			if (resource.view) {
+				renderDevice.getDevice().destroyImageView(resource.view);
+			}
+			if (resource.image != VK_NULL_HANDLE) {
+				vmaDestroyImage(renderDevice.getAllocator(), resource.image, resource.allocation);
+			}
+		}
+	}
+
+	NYFrameGraph::Resource NYFrameGraph::importSwapchain(const std::string& name) {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can't be modified after it's compiled");
+		ResourceInfo& resource = resources.emplace_back();
+		resource.name = name;
+		resource.swapchain = true;
+		resource.output = true;
+		resource.transient = false;
+		resource.format = swapchain.getSwapchainFormat();
+		return static_cast<Resource>(resources.size() - 1);
+	}
+
+	NYFrameGraph::Resource NYFrameGraph::createImage(const std::string& name, vk::Format format, float scale) {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can't be modified after it's compiled");
+		ResourceInfo& resource = resources.emplace_back();
+		resource.name = name;
+		resource.format = format;
+		resource.scale = scale;
+		return static_cast<Resource>(resources.size() - 1);
+	}
+
+	void NYFrameGraph::markOutput(Resource resource) {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can't be modified after it's compiled");
+		resources[resource].output = true;
+	}
+
+	NYFrameGraph::Pass NYFrameGraph::addPass(const std::string& name, std::function<void(PassContext&)> record) {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can't be modified after it's compiled");
+		NYLogger::checkAssert(static_cast<bool>(record), "NYFrameGraph passes need a record function");
+		PassInfo& pass = passes.emplace_back();
+		pass.name = name;
+		pass.record = record;
+		return static_cast<Pass>(passes.size() - 1);
+	}
+
+	void NYFrameGraph::addUse(Pass pass, Resource resource, Access access, bool clear, glm::vec4 clearValue) {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can't be modified after it's compiled");
+		NYLogger::checkAssert(pass < passes.size() && resource < resources.size(), "NYFrameGraph pass or resource handle is invalid");
+		//swapchain images are only made with color attachment usage
+		NYLogger::checkAssert(access == Access::eColorWrite || !resources[resource].swapchain, "NYFrameGraph swapchain images can only be written");
+		for (auto& use : passes[pass].uses) {
+			NYLogger::checkAssert(use.resource != resource, "NYFrameGraph passes can only use a resource once");
+		}
+
+		Use use;
+		use.resource = resource;
+		use.access = access;
+		use.clear = clear;
+		use.clearValue.color = vk::ClearColorValue(std::array<float, 4>{ clearValue.x, clearValue.y, clearValue.z, clearValue.w });
+		passes[pass].uses.push_back(use);
+	}
+
+	void NYFrameGraph::writeColor(Pass pass, Resource resource) {
+		addUse(pass, resource, Access::eColorWrite, false, glm::vec4(0.0f));
+	}
+
+	void NYFrameGraph::clearColor(Pass pass, Resource resource, glm::vec4 clearValue) {
+		addUse(pass, resource, Access::eColorWrite, true, clearValue);
+	}
+
+	void NYFrameGraph::readAttachment(Pass pass, Resource resource) {
+		addUse(pass, resource, Access::eInputRead, false, glm::vec4(0.0f));
+	}
+
+	void NYFrameGraph::readTexture(Pass pass, Resource resource) {
+		addUse(pass, resource, Access::eSampledRead, false, glm::vec4(0.0f));
+	}
+
+	void NYFrameGraph::setContents(Pass pass, vk::SubpassContents contents) {
+		passes[pass].contents = contents;
+	}
+
+	vk::Extent2D NYFrameGraph::getExtent(Resource resource) {
+		vk::Extent2D extent = swapchain.getSwapchainExtent();
+		float scale = resources[resource].scale;
+		return vk::Extent2D(std::max(static_cast<uint32_t>(extent.width * scale), 1u), std::max(static_cast<uint32_t>(extent.height * scale), 1u));
+	}
+
+	void NYFrameGraph::compile() {
+		NYLogger::checkAssert(!compiled, "NYFrameGraph can only be compiled once");
+		cullPasses();
+		buildGroups();
+		createRenderPasses();
+		createImages();
+		createFramebuffers();
+		compiled = true;
+
+		NYLogger::logTrace("NYFrameGraph compiled %zu passes into %zu render passes", passes.size(), groups.size());
+	}
+
+	void NYFrameGraph::resize() {
+		NYLogger::checkAssert(compiled, "NYFrameGraph must be compiled before it's resized");
+
+		std::vector<vk::Framebuffer> oldFramebuffers;
+		for (auto& group : groups) {
+			oldFramebuffers.insert(oldFramebuffers.end(), group.framebuffers.begin(), group.framebuffers.end());
+			group.framebuffers.clear();
+			//every attachment of a group is the same size, so any of them gives the new render area
+			group.extent = getExtent(group.attachments[0]);
+		}
+
+		struct OldImage {
+			VkImage image;
+			VmaAllocation allocation;
+			vk::ImageView view;
+		};
+		std::vector<OldImage> oldImages;
+		for (auto& resource : resources) {
+			if (resource.image == VK_NULL_HANDLE) {
+				continue;
+			}
+			oldImages.push_back({ resource.image, resource.allocation, resource.view });
+			resource.image = VK_NULL_HANDLE;
+			resource.allocation = VK_NULL_HANDLE;
+			resource.view = nullptr;
+		}
+
+		vk::Device device = renderDevice.getDevice();
+		VmaAllocator allocator = renderDevice.getAllocator();
+		renderDevice.deferRelease(renderDevice.getSubmittedValue(), [device, allocator, oldFramebuffers, oldImages]() {
+			for (auto& framebuffer : oldFramebuffers) {
+				device.destroyFramebuffer(framebuffer);
+			}
+			for (auto& oldImage : oldImages) {
+				device.destroyImageView(oldImage.view);
+				vmaDestroyImage(allocator, oldImage.image, oldImage.allocation);
+			}
+		});
+
+		createImages();
+		createFramebuffers();
+	}
+
+	void NYFrameGraph::cullPasses() {
+		//walk backwards from the outputs, a pass is kept if it writes something a later pass or an output still needs
+		std::vector<bool> needed(resources.size(), false);
+		for (size_t i = 0; i < resources.size(); i++) {
+			needed[i] = resources[i].output;
+		}
+
+		for (size_t i = passes.size(); i-- > 0;) {
+			PassInfo& pass = passes[i];
+			pass.culled = true;
+			for (auto& use : pass.uses) {
+				if (use.access == Access::eColorWrite && needed[use.resource]) {
+					pass.culled = false;
+				}
+			}
+
+			if (pass.culled) {
+				NYLogger::logTrace("NYFrameGraph culled pass %s, nothing uses what it writes", pass.name.c_str());
+				continue;
+			}
+
+			//a clear throws away whatever was written before, anything else depends on it
+			for (auto& use : pass.uses) {
+				needed[use.resource] = !(use.access == Access::eColorWrite && use.clear);
+			}
+		}
+	}
+
+	void NYFrameGraph::buildGroups() {
+		for (Pass p = 0; p < passes.size(); p++) {
+			PassInfo& pass = passes[p];
+			if (pass.culled) {
+				continue;
+			}
+
+			//the attachments of a pass decide its render area, so they all have to be the same size
+			vk::Extent2D extent;
+			bool hasAttachment = false;
+			for (auto& use : pass.uses) {
+				if (use.access == Access::eSampledRead) {
+					continue;
+				}
+				vk::Extent2D useExtent = getExtent(use.resource);
+				NYLogger::checkAssert(!hasAttachment || useExtent == extent, "NYFrameGraph attachments of a pass must all be the same size");
+				extent = useExtent;
+				hasAttachment = true;
+			}
+			NYLogger::checkAssert(hasAttachment, "NYFrameGraph passes need at least one attachment");
+
+			//sampling needs the whole image to be finished, which can't happen inside the render pass writing it
+			bool merge = !groups.empty() && groups.back().extent == extent;
+			if (merge) {
+				for (auto& use : pass.uses) {
+					for (Pass other : groups.back().passes) {
+						for (auto& otherUse : passes[other].uses) {
+							if (otherUse.resource == use.resource && (use.access == Access::eSampledRead || otherUse.access == Access::eSampledRead)) {
+								merge = false;
+							}
+						}
+					}
+				}
+			}
+
+			if (!merge) {
+				groups.emplace_back().extent = extent;
+			}
+
+			Group& group = groups.back();
+			pass.group = static_cast<uint32_t>(groups.size() - 1);
+			pass.subpass = static_cast<uint32_t>(group.passes.size());
+			group.passes.push_back(p);
+			group.name += (group.name.empty() ? "" : "+") + pass.name;
+
+			for (auto& use : pass.uses) {
+				if (use.access == Access::eSampledRead) {
+					continue;
+				}
+				if (std::find(group.attachments.begin(), group.attachments.end(), use.resource) == group.attachments.end()) {
+					group.attachments.push_back(use.resource);
+					group.usesSwapchain |= resources[use.resource].swapchain;
+				}
+			}
+		}
+	}
+
+	void NYFrameGraph::createRenderPasses() {
+		//state of every image between render passes
+		std::vector<bool> hasContents(resources.size(), false);
+		std::vector<vk::ImageLayout> layouts(resources.size(), vk::ImageLayout::eUndefined);
+
+		for (uint32_t g = 0; g < groups.size(); g++) {
+			Group& group = groups[g];
+			group.renderPass = std::make_unique<NYRenderPass>(renderDevice);
+
+			uint32_t subpassCount = static_cast<uint32_t>(group.passes.size());
+			uint32_t attachmentCount = static_cast<uint32_t>(group.attachments.size());
+			auto attachmentIndex = [&](Resource resource) {
+				return static_cast<uint32_t>(std::distance(group.attachments.begin(), std::find(group.attachments.begin(), group.attachments.end(), resource)));
+			};
+
+			//subpass references, they're pointed to by the render pass until it's built
+			std::vector<std::vector<vk::AttachmentReference>> colorRefs(subpassCount);
+			std::vector<std::vector<vk::AttachmentReference>> inputRefs(subpassCount);
+			std::vector<std::vector<uint32_t>> preserveRefs(subpassCount);
+			std::vector<std::vector<bool>> referenced(subpassCount, std::vector<bool>(attachmentCount, false));
+			std::vector<uint32_t> firstSubpass(attachmentCount, UINT32_MAX);
+			std::vector<uint32_t> lastSubpass(attachmentCount, 0);
+			std::vector<const Use*> firstUses(attachmentCount, nullptr);
+
+			for (uint32_t s = 0; s < subpassCount; s++) {
+				for (auto& use : passes[group.passes[s]].uses) {
+					if (use.access == Access::eSampledRead) {
+						continue;
+					}
+					uint32_t a = attachmentIndex(use.resource);
+					if (use.access == Access::eColorWrite) {
+						colorRefs[s].push_back(vk::AttachmentReference(a, vk::ImageLayout::eColorAttachmentOptimal));
+					}
+					else {
+						inputRefs[s].push_back(vk::AttachmentReference(a, vk::ImageLayout::eShaderReadOnlyOptimal));
+					}
+					referenced[s][a] = true;
+					if (firstSubpass[a] == UINT32_MAX) {
+						firstSubpass[a] = s;
+						firstUses[a] = &use;
+					}
+					lastSubpass[a] = s;
+				}
+			}
+
+			//attachments
+			std::vector<bool> stored(attachmentCount, false);
+			for (uint32_t a = 0; a < attachmentCount; a++) {
+				Resource r = group.attachments[a];
+				ResourceInfo& resource = resources[r];
+
+				//the first use after this render pass decides whether the contents have to survive it and the layout to leave it in
+				const Use* nextUse = nullptr;
+				for (uint32_t later = g + 1; later < groups.size() && !nextUse; later++) {
+					for (Pass p : groups[later].passes) {
+						for (auto& use : passes[p].uses) {
+							if (use.resource == r && !nextUse) {
+								nextUse = &use;
+							}
+						}
+					}
+				}
+				bool contentsNeeded = resource.output || (nextUse && !(nextUse->access == Access::eColorWrite && nextUse->clear));
+
+				vk::AttachmentLoadOp loadOp = vk::AttachmentLoadOp::eDontCare;
+				if (firstUses[a]->access == Access::eColorWrite && firstUses[a]->clear) {
+					loadOp = vk::AttachmentLoadOp::eClear;
+				}
+				else if (hasContents[r]) {
+					loadOp = vk::AttachmentLoadOp::eLoad;
+				}
+				vk::AttachmentStoreOp storeOp = contentsNeeded ? vk::AttachmentStoreOp::eStore : vk::AttachmentStoreOp::eDontCare;
+
+				vk::ImageLayout initialLayout = loadOp == vk::AttachmentLoadOp::eLoad ? layouts[r] : vk::ImageLayout::eUndefined;
+				vk::ImageLayout finalLayout = vk::ImageLayout::eColorAttachmentOptimal;
+				if (resource.swapchain && !nextUse) {
+					finalLayout = swapchain.getFinalLayout();
+				}
+				else if (nextUse && nextUse->access == Access::eSampledRead) {
+					finalLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+				}
+
+				group.renderPass->addAttachment(resource.format, loadOp, storeOp, initialLayout, finalLayout);
+				group.clearValues.push_back(loadOp == vk::AttachmentLoadOp::eClear ? firstUses[a]->clearValue : vk::ClearValue());
+
+				if (loadOp == vk::AttachmentLoadOp::eLoad || storeOp == vk::AttachmentStoreOp::eStore) {
+					resource.transient = false;
+				}
+				stored[a] = storeOp == vk::AttachmentStoreOp::eStore;
+				hasContents[r] = stored[a];
+				layouts[r] = finalLayout;
+			}
+
+			//attachments used before and after a subpass that doesn't touch them have to be preserved through it
+			for (uint32_t s = 0; s < subpassCount; s++) {
+				for (uint32_t a = 0; a < attachmentCount; a++) {
+					if (!referenced[s][a] && firstSubpass[a] < s && s < lastSubpass[a]) {
+						preserveRefs[s].push_back(a);
+					}
+				}
+				group.renderPass->addSubpass(colorRefs[s], inputRefs[s], nullptr, &preserveRefs[s]);
+			}
+
+			//dependencies, merged per subpass pair
+			std::vector<vk::SubpassDependency> dependencies;
+			auto dependency = [&](uint32_t src, uint32_t dst) -> vk::SubpassDependency& {
+				for (auto& existing : dependencies) {
+					if (existing.srcSubpass == src && existing.dstSubpass == dst) {
+						return existing;
+					}
+				}
+				vk::SubpassDependency& added = dependencies.emplace_back();
+				added.srcSubpass = src;
+				added.dstSubpass = dst;
+				//inside the render pass every access is to the same pixel
+				if (src != VK_SUBPASS_EXTERNAL && dst != VK_SUBPASS_EXTERNAL) {
+					added.dependencyFlags = vk::DependencyFlagBits::eByRegion;
+				}
+				return added;
+			};
+
+			std::vector<uint32_t> lastWriter(attachmentCount, UINT32_MAX);
+			std::vector<uint32_t> lastReader(attachmentCount, UINT32_MAX);
+			for (uint32_t s = 0; s < subpassCount; s++) {
+				for (auto& use : passes[group.passes[s]].uses) {
+					//sampled images were written by an earlier render pass
+					if (use.access == Access::eSampledRead) {
+						vk::SubpassDependency& external = dependency(VK_SUBPASS_EXTERNAL, s);
+						external.srcStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+						external.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+						external.dstStageMask |= vk::PipelineStageFlagBits::eFragmentShader;
+						external.dstAccessMask |= vk::AccessFlagBits::eShaderRead;
+						continue;
+					}
+
+					uint32_t a = attachmentIndex(use.resource);
+					bool write = use.access == Access::eColorWrite;
+					vk::PipelineStageFlags dstStage = write ? vk::PipelineStageFlagBits::eColorAttachmentOutput : vk::PipelineStageFlagBits::eFragmentShader;
+					vk::AccessFlags dstAccess = write ? vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite : vk::AccessFlags(vk::AccessFlagBits::eInputAttachmentRead);
+
+					//the first use waits on whatever used the image before this render pass, including earlier frames
+					if (firstSubpass[a] == s) {
+						vk::SubpassDependency& external = dependency(VK_SUBPASS_EXTERNAL, s);
+						external.srcStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput | vk::PipelineStageFlagBits::eFragmentShader;
+						external.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+						external.dstStageMask |= dstStage;
+						external.dstAccessMask |= dstAccess;
+					}
+					if (lastWriter[a] != UINT32_MAX) {
+						vk::SubpassDependency& readAfterWrite = dependency(lastWriter[a], s);
+						readAfterWrite.srcStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+						readAfterWrite.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+						readAfterWrite.dstStageMask |= dstStage;
+						readAfterWrite.dstAccessMask |= dstAccess;
+					}
+					if (write && lastReader[a] != UINT32_MAX) {
+						vk::SubpassDependency& writeAfterRead = dependency(lastReader[a], s);
+						writeAfterRead.srcStageMask |= vk::PipelineStageFlagBits::eFragmentShader;
+						writeAfterRead.dstStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					}
+
+					if (write) {
+						lastWriter[a] = s;
+						lastReader[a] = UINT32_MAX;
+					}
+					else {
+						lastReader[a] = s;
+					}
+				}
+			}
+
+			//stored images are read or loaded by a later render pass, make the last write visible to it
+			for (uint32_t a = 0; a < attachmentCount; a++) {
+				if (stored[a] && lastWriter[a] != UINT32_MAX && !resources[group.attachments[a]].swapchain) {
+					vk::SubpassDependency& external = dependency(lastWriter[a], VK_SUBPASS_EXTERNAL);
+					external.srcStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					external.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+					external.dstStageMask |= vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					external.dstAccessMask |= vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eInputAttachmentRead |
+						vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite;
+				}
+				//the headless target is copied out after the frame, the final layout transition has to be done before that copy
+				if (stored[a] && lastWriter[a] != UINT32_MAX && resources[group.attachments[a]].swapchain && swapchain.isHeadless()) {
+					vk::SubpassDependency& external = dependency(lastWriter[a], VK_SUBPASS_EXTERNAL);
+					external.srcStageMask |= vk::PipelineStageFlagBits::eColorAttachmentOutput;
+					external.srcAccessMask |= vk::AccessFlagBits::eColorAttachmentWrite;
+					external.dstStageMask |= vk::PipelineStageFlagBits::eTransfer;
+					external.dstAccessMask |= vk::AccessFlagBits::eTransferRead;
+				}
+			}
+
+			for (auto& subpassDependency : dependencies) {
+				group.renderPass->addDependency(subpassDependency);
+			}
+			group.renderPass->build();
+		}
+	}
+
+	void NYFrameGraph::createImages() {
+		for (auto& pass : passes) {
+			if (pass.culled) {
+				continue;
+			}
+			for (auto& use : pass.uses) {
+				switch (use.access) {
+				case Access::eColorWrite: resources[use.resource].usage |= vk::ImageUsageFlagBits::eColorAttachment; break;
+				case Access::eInputRead: resources[use.resource].usage |= vk::ImageUsageFlagBits::eInputAttachment; break;
+				case Access::eSampledRead: resources[use.resource].usage |= vk::ImageUsageFlagBits::eSampled; break;
+				}
+			}
+		}
+
+		for (Resource r = 0; r < resources.size(); r++) {
+			ResourceInfo& resource = resources[r];
+			//swapchain images already exist and images only culled passes used don't need to
+			if (resource.swapchain || !resource.usage) {
+				continue;
+			}
+
+			vk::Extent2D extent = getExtent(r);
+			vk::ImageCreateInfo imageInfo;
+			imageInfo.imageType = vk::ImageType::e2D;
+			imageInfo.extent = vk::Extent3D(extent.width, extent.height, 1);
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.format = resource.format;
+			imageInfo.tiling = vk::ImageTiling::eOptimal;
+			imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+			imageInfo.usage = resource.usage;
+			imageInfo.sharingMode = vk::SharingMode::eExclusive;
+			imageInfo.samples = vk::SampleCountFlagBits::e1;
+
+			VmaAllocationCreateInfo allocInfo{};
+			allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+			VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+			if (resource.transient) {
+				//on tilers the image can live in tile memory only, desktop gpus usually have no lazily allocated memory
+				//and fall through to a regular allocation
+				imageInfo.usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+				VmaAllocationCreateInfo lazyAllocInfo{};
+				lazyAllocInfo.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+				auto vkImageInfo = static_cast<VkImageCreateInfo>(imageInfo);
+				result = vmaCreateImage(renderDevice.getAllocator(), &vkImageInfo, &lazyAllocInfo, &resource.image, &resource.allocation, nullptr);
+			}
+			if (result != VK_SUCCESS) {
+				renderDevice.createImage(resource.image, static_cast<VkImageCreateInfo>(imageInfo), allocInfo, resource.allocation);
+			}
+
+			vk::ImageViewCreateInfo viewInfo;
+			viewInfo.image = resource.image;
+			viewInfo.viewType = vk::ImageViewType::e2D;
+			viewInfo.format = resource.format;
+			viewInfo.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+			resource.view = renderDevice.getDevice().createImageView(viewInfo);
+		}
+	}
+
+	void NYFrameGraph::createFramebuffers() {
+		for (auto& group : groups) {
+			size_t framebufferCount = group.usesSwapchain ? swapchain.numSwapchainImages() : 1;
+			group.framebuffers.resize(framebufferCount);
+
+			for (uint32_t i = 0; i < framebufferCount; i++) {
+				std::vector<vk::ImageView> views;
+				for (Resource r : group.attachments) {
+					views.push_back(resources[r].swapchain ? *swapchain.getImageView_Ptr(i) : resources[r].view);
+				}
+
+				vk::FramebufferCreateInfo createInfo(vk::FramebufferCreateFlags(), group.renderPass->getRenderpass(), views,
+					group.extent.width, group.extent.height, 1);
+				group.framebuffers[i] = renderDevice.getDevice().createFramebuffer(createInfo);
+			}
+		}
+	}
+
+	void NYFrameGraph::execute(vk::CommandBuffer& commandBuffer, uint32_t imageIndex, NYGPUProfiler* profiler) {
+		NYLogger::checkAssert(compiled, "NYFrameGraph must be compiled before it's executed");
+
+		for (auto& group : groups) {
+			uint32_t scope = profiler ? profiler->beginScope(commandBuffer, group.name.c_str()) : UINT32_MAX;
+			vk::Framebuffer framebuffer = group.framebuffers[group.usesSwapchain ? imageIndex : 0];
+			group.renderPass->begin(commandBuffer, framebuffer, group.extent, group.clearValues, passes[group.passes[0]].contents);
+
+			for (uint32_t s = 0; s < group.passes.size(); s++) {
+				PassInfo& pass = passes[group.passes[s]];
+				if (s > 0) {
+					group.renderPass->nextSubpass(commandBuffer, pass.contents);
+				}
+
+				PassContext context{ commandBuffer, group.renderPass->getRenderpass(), s, framebuffer, group.extent };
+				pass.record(context);
+			}
+
+			group.renderPass->end(commandBuffer);
+			if (profiler) {
+				profiler->endScope(commandBuffer, scope);
+			}
+		}
+	}
+
+	NYRenderPass& NYFrameGraph::getRenderPass(Pass pass) {
+		NYLogger::checkAssert(compiled && !passes[pass].culled, "NYFrameGraph::getRenderPass() needs a compiled graph and a pass that wasn't culled");
+		return *groups[passes[pass].group].renderPass;
+	}
+
+	uint32_t NYFrameGraph::getSubpass(Pass pass) {
+		NYLogger::checkAssert(compiled && !passes[pass].culled, "NYFrameGraph::getSubpass() needs a compiled graph and a pass that wasn't culled");
+		return passes[pass].subpass;
+	}
+
+	bool NYFrameGraph::isCulled(Pass pass) {
+		NYLogger::checkAssert(compiled, "NYFrameGraph::isCulled() needs a compiled graph");
+		return passes[pass].culled;
+	}
+
+	vk::ImageView NYFrameGraph::getImageView(Resource resource) {
+		NYLogger::checkAssert(compiled && !resources[resource].swapchain, "NYFrameGraph::getImageView() needs a compiled graph and an image owned by it");
+		return resources[resource].view;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,144 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYSwapchain.hpp"
+#include "NYRenderPass.hpp"
+#include "NYGPUProfiler.hpp"
+
+namespace Nya {
+	//declarative description of the frame, passes say which images they write and read and compile() works out the rest:
+	//-passes whose results never reach an output are culled
+	//-consecutive passes of the same size that only read each other per pixel are merged into subpasses of one render pass
+	//-load/store ops, layouts and subpass dependencies come from how each image is used before and after a render pass
+	//-images that never leave their render pass are transient and lazily allocated where the device supports it
+	class NYFrameGraph {
+	public:
+		using Resource = uint32_t;
+		using Pass = uint32_t;
+
+		//what a pass records into, renderPass/subpass/framebuffer are there for secondary command buffer inheritance
+		struct PassContext {
+			vk::CommandBuffer commandBuffer;
+			vk::RenderPass renderPass;
+			uint32_t subpass;
+			vk::Framebuffer framebuffer;
+			vk::Extent2D extent;
+		};
+
+		NYFrameGraph(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain);
+		~NYFrameGraph();
+
+		NYFrameGraph(NYFrameGraph const&) = delete;
+		NYFrameGraph& operator=(NYFrameGraph const&) = delete;
+
+		//the swapchain image of the frame, always an output and presented after its last pass
+		Resource importSwapchain(const std::string& name);
+		//image owned by the graph, scale is relative to the swapchain extent
+		Resource createImage(const std::string& name, vk::Format format, float scale = 1.0f);
+		//keeps the passes writing an image alive even if no pass reads it
+		void markOutput(Resource resource);
+
+		//passes run in the order they're added
+		Pass addPass(const std::string& name, std::function<void(PassContext&)> record);
+		//color attachments are bound in the order they're declared, location 0 first
+		//writeColor() keeps what an earlier pass wrote this frame, nothing is carried over from the last frame, so the first
+		//write of a frame has to cover the whole image or use clearColor(), which discards the contents
+		void writeColor(Pass pass, Resource resource);
+		void clearColor(Pass pass, Resource resource, glm::vec4 clearValue);
+		//reads the same pixel another pass wrote as an input attachment, doesn't stop the passes from merging
+		void readAttachment(Pass pass, Resource resource);
+		//samples the image anywhere, the writer has to finish first so it ends up in an earlier render pass
+		void readTexture(Pass pass, Resource resource);
+		//can be changed between frames, passes recording secondary command buffers need eSecondaryCommandBuffers
+		void setContents(Pass pass, vk::SubpassContents contents);
+
+		void compile();
+		bool isCompiled() { return compiled; }
+		//remakes the graph's images and framebuffers after the swapchain changed size, the old ones are released once the
+		//frames using them are done. render passes are kept, so pipelines made for them stay valid
+		//views handed out by getImageView() change, so descriptors sampling them have to be written again
+		void resize();
+		//records every render pass, imageIndex picks the swapchain image
+		//with a profiler each render pass is timed as one scope named after the passes merged into it
+		void execute(vk::CommandBuffer& commandBuffer, uint32_t imageIndex, NYGPUProfiler* profiler = nullptr);
+
+		//only valid after compile(), pipelines for a pass are made with its render pass and subpass
+		NYRenderPass& getRenderPass(Pass pass);
+		uint32_t getSubpass(Pass pass);
+		bool isCulled(Pass pass);
+		//for descriptors of passes that sample the image
+		vk::ImageView getImageView(Resource resource);
+
+	private:
+		enum class Access : uint8_t {
+			eColorWrite,
+			eInputRead,
+			eSampledRead
+		};
+
+		struct Use {
+			Resource resource;
+			Access access;
+			bool clear;
+			vk::ClearValue clearValue;
+		};
+
+		struct PassInfo {
+			std::string name;
+			std::function<void(PassContext&)> record;
+			vk::SubpassContents contents = vk::SubpassContents::eInline;
+			std::vector<Use> uses;
+
+			bool culled = false;
+			uint32_t group = UINT32_MAX;
+			uint32_t subpass = 0;
+		};
+
+		struct ResourceInfo {
+			std::string name;
+			bool swapchain = false;
+			bool output = false;
+			vk::Format format;
+			float scale = 1.0f;
+
+			vk::ImageUsageFlags usage;
+			//never loaded, stored or sampled, so it only has to exist inside one render pass
+			bool transient = true;
+			VkImage image = VK_NULL_HANDLE;
+			VmaAllocation allocation = VK_NULL_HANDLE;
+			vk::ImageView view;
+		};
+
+		//consecutive passes merged into one render pass
+		struct Group {
+			std::vector<Pass> passes;
+			std::vector<Resource> attachments;
+			std::vector<vk::ClearValue> clearValues;
+			vk::Extent2D extent;
+			std::unique_ptr<NYRenderPass> renderPass;
+			//one per swapchain image if the swapchain is one of the attachments
+			std::vector<vk::Framebuffer> framebuffers;
+			bool usesSwapchain = false;
+			//pass names joined with '+', for profiling
+			std::string name;
+		};
+
+		void addUse(Pass pass, Resource resource, Access access, bool clear, glm::vec4 clearValue);
+		vk::Extent2D getExtent(Resource resource);
+
+		void cullPasses();
+		void buildGroups();
+		void createRenderPasses();
+		void createImages();
+		void createFramebuffers();
+
+		NYRenderDevice& renderDevice;
+		NYSwapchain& swapchain;
+
+		std::vector<PassInfo> passes;
+		std::vector<ResourceInfo> resources;
+		std::vector<Group> groups;
+
+		bool compiled = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#include "pch.hpp"
+#include "NYFrameRingBuffer.hpp"
+#include "logging/NYLogger.hpp"
+
+namespace Nya {
+	NYFrameRingBuffer::NYFrameRingBuffer(NYRenderDevice& _renderDevice, vk::DeviceSize _regionSize)
+		:renderDevice(_renderDevice), regionSize(_regionSize) {
+		vk::PhysicalDeviceLimits limits = renderDevice.getPhysicalDevice().getProperties().limits;
+		uniformAlignment = limits.minUniformBufferOffsetAlignment;
+		storageAlignment = limits.minStorageBufferOffsetAlignment;
+
+		createBuffer();
+	}
+
+	NYFrameRingBuffer::~NYFrameRingBuffer(){
+		for (auto& retired : retiredBuffers) {
+			vmaDestroyBuffer(renderDevice.getAllocator(), retired.buffer, retired.allocation);
+		}
+		vmaDestroyBuffer(renderDevice.getAllocator(), buffer, allocation);
+	}
+
+	void NYFrameRingBuffer::createBuffer(){
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		std::array<uint32_t, 1> queueFamilyIndices = { renderDevice.getGraphicsQueueFamilyIndex() };
+
+		vk::BufferCreateInfo bufferInfo;
+		bufferInfo.setQueueFamilyIndices(queueFamilyIndices);
+		bufferInfo.usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eIndexBuffer |
+			vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer;
+		//one extra region at the end so a dynamic descriptor with getBindRange() as its range stays inside the buffer at any offset
+		bufferInfo.size = regionSize * (MAX_FRAMES_IN_FLIGHT + 1);
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+		VmaAllocationInfo allocationInfo;
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &buffer, &allocation, &allocationInfo);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create frame ring buffer");
+
+		mappedMem = static_cast<uint8_t*>(allocationInfo.pMappedData);
+		generation++;
+	}
+
+	void NYFrameRingBuffer::beginFrame(uint32_t _frameIndex){
+		frameIndex = _frameIndex;
+		head = 0;
+	}
+
+	void NYFrameRingBuffer::flushFrame(){
+		if (head == 0) { return; }
+		vmaFlushAllocation(renderDevice.getAllocator(), allocation, regionSize * frameIndex, head);
+	}
+
+	void NYFrameRingBuffer::frameSubmitted(uint64_t submitValue){
+		VmaAllocator allocator = renderDevice.getAllocator();
+		for (auto& retired : retiredBuffers) {
+			renderDevice.deferRelease(submitValue, [allocator, retired]() {
+				vmaDestroyBuffer(allocator, retired.buffer, retired.allocation);
+			});
+		}
+		retiredBuffers.clear();
+	}
+
+	NYFrameRingBuffer::Allocation NYFrameRingBuffer::allocate(vk::DeviceSize size, vk::DeviceSize alignment){
+		//region starts are multiples of the region size, which is kept a multiple of every alignment used
+		vk::DeviceSize offset = (head + alignment - 1) / alignment * alignment;
+
+		if (offset + size > regionSize) {
+			//everything handed out this frame stays valid in the old buffer, so only later allocations move over
+			flushFrame();
+			retiredBuffers.push_back({ buffer, allocation });
+
+			while (regionSize < size) { regionSize *= 2; }
+			regionSize *= 2;
+			createBuffer();
+			NYLogger::logTrace("NYFrameRingBuffer grown to %llu bytes per frame", static_cast<unsigned long long>(regionSize));
+
+			head = 0;
+			offset = 0;
+		}
+
+		head = offset + size;
+
+		Allocation result;
+		result.buffer = buffer;
+		result.offset = regionSize * frameIndex + offset;
+		result.data = mappedMem + result.offset;
+		result.size = size;
+		return result;
+	}
+}
\ No newline at end of file
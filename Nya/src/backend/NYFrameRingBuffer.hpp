@@ -0,0 +1,76 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "defines.hpp"
+
+/*
+per frame linear allocator for dynamic gpu data
+-one persistently mapped host visible buffer split into MAX_FRAMES_IN_FLIGHT regions
+-allocations are bump pointer writes into the current frame's region, handed out with the offset to bind or use as a dynamic offset
+-a frame's region is reset when the frame begins again, after the gpu has finished the frame that last used it
+*/
+
+namespace Nya {
+	class NYFrameRingBuffer {
+	public:
+		struct Allocation {
+			void* data;
+			VkBuffer buffer;
+			vk::DeviceSize offset;//from the start of the buffer, can be used as a dynamic offset
+			vk::DeviceSize size;
+		};
+
+		NYFrameRingBuffer(NYRenderDevice& _renderDevice, vk::DeviceSize _regionSize = 4 * 1024 * 1024);
+		~NYFrameRingBuffer();
+
+		NYFrameRingBuffer(NYFrameRingBuffer const&) = delete;
+		NYFrameRingBuffer& operator=(NYFrameRingBuffer const&) = delete;
+
+		//called by the renderer once the frame's previous submission has been waited on
+		void beginFrame(uint32_t frameIndex);
+		//flushes everything written this frame, called by the renderer before submitting
+		void flushFrame();
+		//called by the renderer with the timeline value the frame was submitted with, buffers retired
+		//during the frame are released once it's reached
+		void frameSubmitted(uint64_t submitValue);
+
+		Allocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+		Allocation allocateUniform(vk::DeviceSize size) { return allocate(size, uniformAlignment); }
+		Allocation allocateStorage(vk::DeviceSize size) { return allocate(size, storageAlignment); }
+
+		//for laying out arrays of dynamic uniform or storage blocks inside one allocation
+		vk::DeviceSize getUniformAlignment() { return uniformAlignment; }
+		vk::DeviceSize getStorageAlignment() { return storageAlignment; }
+
+		//descriptors of dynamic bindings into the ring should use this as their range, it's valid at any offset
+		VkBuffer& getBuffer() { return buffer; }
+		vk::DeviceSize getBindRange() { return regionSize; }
+		//changes whenever the buffer is reallocated, descriptors pointing at the old buffer need to be rewritten
+		uint32_t getGeneration() { return generation; }
+
+	private:
+		void createBuffer();
+
+		NYRenderDevice& renderDevice;
+
+		vk::DeviceSize regionSize;
+		vk::DeviceSize uniformAlignment;
+		vk::DeviceSize storageAlignment;
+
+		VkBuffer buffer;
+		VmaAllocation allocation;
+		uint8_t* mappedMem = nullptr;
+
+		uint32_t frameIndex = 0;
+		vk::DeviceSize head = 0;//offset into the current frame's region
+		uint32_t generation = 0;
+
+		//buffers replaced by a bigger one this frame, handed to the render device's deferred releases once the frame is submitted
+		//frames submitted earlier signal lower values, so they're covered too
+		struct RetiredBuffer {
+			VkBuffer buffer;
+			VmaAllocation allocation;
+		};
+		std::vector<RetiredBuffer> retiredBuffers;
+	};
+}
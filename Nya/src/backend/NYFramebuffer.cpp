@@ -2,13 +2,23 @@
 #include "NYFramebuffer.hpp"
 
 namespace Nya {
-	NYFramebuffer::NYFramebuffer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain, NYRenderPass& _renderPass)
-		:renderDevice(_renderDevice), renderPass(_renderPass), swapchain(_swapchain) {
+	NYFramebuffer::NYFramebuffer(NYRenderDevice& _renderDevice, vk::Extent2D _extent)
+		:renderDevice(_renderDevice), extent(_extent) {
 
 	}
 
 	NYFramebuffer::~NYFramebuffer(){
+		for (auto& attachment : attachments) {
+			renderDevice.getDevice().destroyImageView(attachment.imageView);
+			vmaDestroyImage(renderDevice.getAllocator(), attachment.image, attachment.imageAlloc);
+		}
+	}
 
+	uint32_t NYFramebuffer::addColorAttachment(vk::Format format, vk::ImageUsageFlags usageFlags) {
+		NYFramebufferAttachment attachment;
+		createFramebufferAttachment(attachment, format, usageFlags | vk::ImageUsageFlagBits::eColorAttachment, extent.width, extent.height);
+		attachments.push_back(attachment);
+		return static_cast<uint32_t>(attachments.size() - 1);
 	}
 
 	void NYFramebuffer::createFramebufferAttachment(NYFramebufferAttachment& framebufferAttachment, vk::Format format, vk::ImageUsageFlags usageFlags, int width, int height){
@@ -25,12 +35,13 @@ namespace Nya {
 
 		imageInfo.usage = usageFlags;
 
-		VmaAllocationCreateInfo allocInfo;
+		VmaAllocationCreateInfo allocInfo{};
 		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 		
 		renderDevice.createImage(framebufferAttachment.image, static_cast<VkImageCreateInfo>(imageInfo), allocInfo, framebufferAttachment.imageAlloc);
 
 		vk::ImageViewCreateInfo viewInfo;
+		viewInfo.viewType = vk::ImageViewType::e2D;
 		viewInfo.format = format;
 		viewInfo.image = framebufferAttachment.image;
 		viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
@@ -39,6 +50,7 @@ namespace Nya {
 		viewInfo.subresourceRange.baseMipLevel = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
+		framebufferAttachment.format = format;
 		framebufferAttachment.imageView = renderDevice.getDevice().createImageView(viewInfo);
 	}
 }
\ No newline at end of file
@@ -1,13 +1,13 @@
 #pragma once
 #include "pch.hpp"
-#include "NYRenderPass.hpp"
 #include "backend/NYRenderDevice.hpp"
-#include "NYSwapchain.hpp"
 
 namespace Nya {
+	//offscreen render target, owns the images drawn into when there's no window to present to
+	//the vk::Framebuffer over them is made by whoever builds the render pass, the frame graph does it for swapchain imports
 	class NYFramebuffer {
 	public:
-		NYFramebuffer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain,  NYRenderPass& _renderPass);
+		NYFramebuffer(NYRenderDevice& _renderDevice, vk::Extent2D _extent);
 		~NYFramebuffer();
 
 		NYFramebuffer(NYFramebuffer const&) = delete;
@@ -17,15 +17,19 @@ namespace Nya {
 			VkImage image;
 			VkImageView imageView;
 			VmaAllocation imageAlloc;
+			vk::Format format;
 		};
 
+		//adds an attachment the size of the framebuffer and returns its index
+		uint32_t addColorAttachment(vk::Format format, vk::ImageUsageFlags usageFlags);
+		NYFramebufferAttachment& getAttachment(uint32_t index) { return attachments[index]; }
+		vk::Extent2D getExtent() { return extent; }
+
 		void createFramebufferAttachment(NYFramebufferAttachment& framebufferAttachment, vk::Format format, vk::ImageUsageFlags usageFlags, int width, int height);
 	private:
-		NYRenderPass& renderPass;
 		NYRenderDevice& renderDevice;
-		NYSwapchain& swapchain;
+		vk::Extent2D extent;
 
 		std::vector<NYFramebufferAttachment> attachments;
-		vk::Framebuffer framebuffer;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "pch.hpp"
+#include "NYGPUProfiler.hpp"
+#include "logging/NYLogger.hpp"
+
+namespace Nya {
+	NYGPUProfiler::NYGPUProfiler(NYRenderDevice& _renderDevice, uint32_t _maxScopesPerFrame)
+		:renderDevice(_renderDevice), maxScopesPerFrame(_maxScopesPerFrame) {
+		vk::PhysicalDeviceLimits limits = renderDevice.getPhysicalDevice().getProperties().limits;
+		uint32_t validBits = renderDevice.getPhysicalDevice().getQueueFamilyProperties()[renderDevice.getGraphicsQueueFamilyIndex()].timestampValidBits;
+		supported = validBits > 0 && limits.timestampPeriod > 0.0f;
+		if (!supported) {
+			NYLogger::logWarning("NYGPUProfiler: the graphics queue doesn't support timestamps, gpu timings are off");
+			return;
+		}
+		timestampPeriod = limits.timestampPeriod;
+		timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+		vk::QueryPoolCreateInfo poolInfo;
+		poolInfo.queryType = vk::QueryType::eTimestamp;
+		poolInfo.queryCount = maxScopesPerFrame * 2;
+		for (auto& frame : frames) {
+			frame.pool = renderDevice.getDevice().createQueryPool(poolInfo);
+		}
+		results.resize(maxScopesPerFrame * 2);
+	}
+
+	NYGPUProfiler::~NYGPUProfiler(){
+		for (auto& frame : frames) {
+			renderDevice.getDevice().destroyQueryPool(frame.pool);
+		}
+	}
+
+	void NYGPUProfiler::beginFrame(vk::CommandBuffer& commandBuffer, uint32_t _frameIndex){
+		if (!supported) { return; }
+		frameIndex = _frameIndex;
+		readResults(frameIndex);
+
+		Frame& frame = frames[frameIndex];
+		commandBuffer.resetQueryPool(frame.pool, 0, maxScopesPerFrame * 2);
+		frame.scopes.clear();
+		frame.usedQueries = 0;
+	}
+
+	uint32_t NYGPUProfiler::beginScope(vk::CommandBuffer& commandBuffer, const char* name){
+		if (!supported) { return UINT32_MAX; }
+		Frame& frame = frames[frameIndex];
+
+		uint32_t scope;
+		uint32_t query;
+		{
+			std::lock_guard<std::mutex> lock(scopeMutex);
+			if (frame.usedQueries + 2 > maxScopesPerFrame * 2) {
+				return UINT32_MAX;
+			}
+			query = frame.usedQueries;
+			frame.usedQueries += 2;
+			scope = static_cast<uint32_t>(frame.scopes.size());
+			frame.scopes.push_back({ name, query, false });
+		}
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, frame.pool, query);
+		return scope;
+	}
+
+	void NYGPUProfiler::endScope(vk::CommandBuffer& commandBuffer, uint32_t scope){
+		if (scope == UINT32_MAX) { return; }
+		Frame& frame = frames[frameIndex];
+
+		uint32_t query;
+		{
+			std::lock_guard<std::mutex> lock(scopeMutex);
+			frame.scopes[scope].ended = true;
+			query = frame.scopes[scope].firstQuery + 1;
+		}
+		commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, frame.pool, query);
+	}
+
+	void NYGPUProfiler::readResults(uint32_t index){
+		Frame& frame = frames[index];
+		if (frame.usedQueries == 0) { return; }
+
+		//the frame's timeline value has been waited on, so this doesn't wait, it only fails if the frame was never submitted
+		VkResult result = vkGetQueryPoolResults(renderDevice.getDevice(), frame.pool, 0, frame.usedQueries,
+			frame.usedQueries * sizeof(uint64_t), results.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS) { return; }
+
+		//same named scopes add up, the totals line up with stats
+		frameTotals.assign(stats.size(), -1.0f);
+		for (auto& scope : frame.scopes) {
+			if (!scope.ended) { continue; }
+			uint64_t begin = results[scope.firstQuery] & timestampMask;
+			uint64_t end = results[scope.firstQuery + 1] & timestampMask;
+			float ms = end > begin ? static_cast<float>(end - begin) * timestampPeriod / 1000000.0f : 0.0f;
+
+			size_t s = 0;
+			while (s < stats.size() && strcmp(stats[s].name, scope.name) != 0) { s++; }
+			if (s == stats.size()) {
+				ScopeStats scopeStats;
+				scopeStats.name = scope.name;
+				stats.push_back(scopeStats);
+				histories.emplace_back();
+				frameTotals.push_back(-1.0f);
+			}
+			frameTotals[s] = std::max(frameTotals[s], 0.0f) + ms;
+		}
+
+		for (size_t s = 0; s < stats.size(); s++) {
+			if (frameTotals[s] < 0.0f) { continue; }
+
+			History& history = histories[s];
+			history.samples[history.head] = frameTotals[s];
+			history.head = (history.head + 1) % historySize;
+			history.count = std::min(history.count + 1, historySize);
+
+			ScopeStats& scopeStats = stats[s];
+			scopeStats.lastMs = frameTotals[s];
+			scopeStats.minMs = std::numeric_limits<float>::max();
+			scopeStats.maxMs = 0.0f;
+			float sum = 0.0f;
+			for (uint32_t i = 0; i < history.count; i++) {
+				scopeStats.minMs = std::min(scopeStats.minMs, history.samples[i]);
+				scopeStats.maxMs = std::max(scopeStats.maxMs, history.samples[i]);
+				sum += history.samples[i];
+			}
+			scopeStats.avgMs = sum / history.count;
+			scopeStats.samples++;
+		}
+	}
+
+	void NYGPUProfiler::drawDebugUI(){
+		if (!ImGui::CollapsingHeader("GPU timings")) { return; }
+		if (!supported) {
+			ImGui::Text("Timestamps unsupported on the graphics queue");
+			return;
+		}
+
+		if (ImGui::BeginTable("gpu scopes", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+			ImGui::TableSetupColumn("Scope");
+			ImGui::TableSetupColumn("Last ms");
+			ImGui::TableSetupColumn("Min ms");
+			ImGui::TableSetupColumn("Avg ms");
+			ImGui::TableSetupColumn("Max ms");
+			ImGui::TableHeadersRow();
+			for (auto& scope : stats) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::Text("%s", scope.name);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.lastMs);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.minMs);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.avgMs);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", scope.maxMs);
+			}
+			ImGui::EndTable();
+		}
+
+		if (ImGui::Button("Export CSV")) {
+			exportCSV("gpu_timings.csv");
+		}
+	}
+
+	bool NYGPUProfiler::exportCSV(const char* path){
+		std::ofstream file(path);
+		if (!file.is_open()) {
+			NYLogger::logWarning("NYGPUProfiler: couldn't open %s", path);
+			return false;
+		}
+
+		file << "scope,last_ms,min_ms,avg_ms,max_ms,samples\n";
+		for (auto& scope : stats) {
+			file << scope.name << "," << scope.lastMs << "," << scope.minMs << "," << scope.avgMs << "," << scope.maxMs << "," << scope.samples << "\n";
+		}
+		NYLogger::logInfo("gpu timings written to %s", path);
+		return true;
+	}
+
+	void NYGPUProfiler::logStats(){
+		for (auto& scope : stats) {
+			NYLogger::logInfo("gpu %s: min %.3f ms, avg %.3f ms, max %.3f ms", scope.name, scope.minMs, scope.avgMs, scope.maxMs);
+		}
+	}
+}
\ No newline at end of file
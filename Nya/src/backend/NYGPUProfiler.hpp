@@ -0,0 +1,89 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "defines.hpp"
+
+/*
+gpu timings from timestamp queries
+-one query pool per frame in flight, scopes take two timestamps out of the current frame's pool
+-a frame's results are read when its slot comes around again, the renderer has already waited for it by then
+ so reading never stalls, timings show up MAX_FRAMES_IN_FLIGHT - 1 frames late
+-scopes with the same name in one frame are summed, stats are min/avg/max over the last historySize frames
+*/
+
+namespace Nya {
+	class NYGPUProfiler {
+	public:
+		NYGPUProfiler(NYRenderDevice& _renderDevice, uint32_t _maxScopesPerFrame = 256);
+		~NYGPUProfiler();
+
+		NYGPUProfiler(NYGPUProfiler const&) = delete;
+		NYGPUProfiler& operator=(NYGPUProfiler const&) = delete;
+
+		//false if the graphics queue can't write timestamps, every call is a no op then
+		bool isSupported() { return supported; }
+
+		//reads back the results the slot's last frame wrote and resets its pool, has to be recorded outside of a render pass
+		//before any scope of the frame, the renderer does it in beginFrame()
+		void beginFrame(vk::CommandBuffer& commandBuffer, uint32_t frameIndex);
+
+		//name has to outlive the profiler, string literals are expected
+		//safe to call from several threads recording different command buffers of the same frame
+		//returns UINT32_MAX once the frame is out of queries, endScope() ignores that
+		uint32_t beginScope(vk::CommandBuffer& commandBuffer, const char* name);
+		void endScope(vk::CommandBuffer& commandBuffer, uint32_t scope);
+
+		struct ScopeStats {
+			const char* name;
+			float lastMs = 0.0f;
+			float minMs = 0.0f;
+			float avgMs = 0.0f;
+			float maxMs = 0.0f;
+			uint32_t samples = 0;
+		};
+		//in the order scopes were first seen
+		std::vector<ScopeStats>& getStats() { return stats; }
+
+		//table of every scope, called inside the renderer's debug window
+		void drawDebugUI();
+		//one row per scope with the header scope,last_ms,min_ms,avg_ms,max_ms,samples, samples counts the frames the scope was timed in
+		bool exportCSV(const char* path);
+		void logStats();
+
+	private:
+		void readResults(uint32_t frameIndex);
+		void addSample(const char* name, float ms);
+
+		NYRenderDevice& renderDevice;
+		uint32_t maxScopesPerFrame;
+		bool supported = false;
+		//nanoseconds per tick
+		float timestampPeriod = 1.0f;
+		uint64_t timestampMask = ~0ull;
+
+		struct Scope {
+			const char* name;
+			uint32_t firstQuery;
+			bool ended;
+		};
+		struct Frame {
+			vk::QueryPool pool;
+			std::vector<Scope> scopes;
+			uint32_t usedQueries = 0;
+		};
+		std::array<Frame, MAX_FRAMES_IN_FLIGHT> frames;
+		uint32_t frameIndex = 0;
+		std::mutex scopeMutex;
+
+		static constexpr uint32_t historySize = 240;
+		struct History {
+			std::array<float, historySize> samples;
+			uint32_t head = 0;
+			uint32_t count = 0;
+		};
+		std::vector<ScopeStats> stats;
+		std::vector<History> histories;
+		std::vector<uint64_t> results;
+		std::vector<float> frameTotals;
+	};
+}
\ No newline at end of file
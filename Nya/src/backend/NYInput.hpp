@@ -2,7 +2,7 @@
 #include "pch.hpp"
 
 namespace Nya {
-	static class NYInput {
+	class NYInput {
 	public:
 		NYInput();
 		~NYInput();
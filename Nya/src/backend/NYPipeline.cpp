@@ -4,9 +4,12 @@
 #include "NYRenderpass.hpp"
 
 namespace Nya {
-	NYPipeline::NYPipeline(NYRenderDevice& _renderDevice, NYPipelineConfig& _pipelineConfig, NYShader& _shader, NYDescriptorSetLayout& _descLayout, NYRenderPass& _renderPass)
-		:renderDevice(_renderDevice), pipelineConfig(_pipelineConfig), shader(_shader), descLayout(_descLayout), renderPass(_renderPass) {
-		NYLogger::checkAssert(descLayout.isBuilt(), "NYDescriptorSetLayout must be built before passing as parameter");
+	NYPipeline::NYPipeline(NYRenderDevice& _renderDevice, NYPipelineConfig& _pipelineConfig, NYShader& _shader, std::vector<NYDescriptorSetLayout*> _descLayouts, NYRenderPass& _renderPass)
+		:renderDevice(_renderDevice), shader(_shader), descLayouts(_descLayouts), renderPass(_renderPass) {
+		for (auto descLayout : descLayouts) {
+			NYLogger::checkAssert(descLayout->isBuilt(), "NYDescriptorSetLayout must be built before passing as parameter");
+		}
+		copyConfig(_pipelineConfig);
 		createPipelineResources();
 		createPipeline();
 	}
@@ -15,29 +18,22 @@ namespace Nya {
 
 		renderDevice.getDevice().destroyPipelineLayout(pipelineLayout);
 
-		renderDevice.getDevice().destroyRenderPass(offscreenPass);
-		renderDevice.getDevice().destroyRenderPass(compositePass);
-
 		renderDevice.getDevice().destroyPipeline(pipeline);
 
 		NYLogger::logTrace("NYPipeline destroyed");
 	}
 
-	void NYPipeline::createPipelineResources(){
-		//make the shaderStages
-		vk::PipelineShaderStageCreateInfo vertShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
-			vk::ShaderStageFlagBits::eVertex,
-			shader.getVertexModule(),
-			"main");
-
-		vk::PipelineShaderStageCreateInfo fragShaderStageInfo(vk::PipelineShaderStageCreateFlags(),
-			vk::ShaderStageFlagBits::eFragment,
-			shader.getFragmentModule(),
-			"main");
-
-		shaderStages[0] = vertShaderStageInfo;
-		shaderStages[1] = fragShaderStageInfo;
+	void NYPipeline::copyConfig(NYPipelineConfig& config){
+		pipelineConfig = config;
+		//the vertex input state only points at its descriptions, which usually live on the caller's stack
+		vk::PipelineVertexInputStateCreateInfo& vertexInput = pipelineConfig.vertexInputStateInfo;
+		bindingDescs.assign(vertexInput.pVertexBindingDescriptions, vertexInput.pVertexBindingDescriptions + vertexInput.vertexBindingDescriptionCount);
+		attribDescs.assign(vertexInput.pVertexAttributeDescriptions, vertexInput.pVertexAttributeDescriptions + vertexInput.vertexAttributeDescriptionCount);
+		vertexInput.setVertexBindingDescriptions(bindingDescs);
+		vertexInput.setVertexAttributeDescriptions(attribDescs);
+	}
 
+	void NYPipeline::createPipelineResources(){
 		//gonna use the pipeline config to make viewport state
 		viewportStateInfo = vk::PipelineViewportStateCreateInfo(vk::PipelineViewportStateCreateFlags(),
 																									1,//no of viewports
@@ -55,16 +51,17 @@ namespace Nya {
 																										  &pipelineConfig.colorBlendAttachment,
 																										  blendConstants);
 
-		vk::PushConstantRange range;
-		range.offset = 0;
-		range.size = sizeof(NYSprite::PushData);
-		range.stageFlags = vk::ShaderStageFlagBits::eVertex;
+		dynamicStateInfo = vk::PipelineDynamicStateCreateInfo(vk::PipelineDynamicStateCreateFlags(), pipelineConfig.dynamicStates);
+
+		for (auto descLayout : descLayouts) {
+			setLayouts.push_back(descLayout->getLayout());
+		}
 
 		pipelineLayoutInfo = vk::PipelineLayoutCreateInfo(vk::PipelineLayoutCreateFlags(),
-														  1,
-														  &descLayout.getLayout(),//pSetLayouts
-														  1,//pushConstantRangeCount
-														  &range);//pPushConstantRanges
+														  setLayouts.size(),
+														  setLayouts.data(),//pSetLayouts
+														  pipelineConfig.pushConstantRange.size > 0 ? 1 : 0,//pushConstantRangeCount
+														  &pipelineConfig.pushConstantRange);//pPushConstantRanges
 
 		//create the pipeline layout using its info from pipelineConfig
 		pipelineLayout = renderDevice.getDevice().createPipelineLayout(pipelineLayoutInfo);
@@ -72,6 +69,17 @@ namespace Nya {
 	}
 
 	void NYPipeline::createPipeline(){
+		std::unique_lock<std::mutex> moduleLock = shader.lockModules();
+		pipeline = buildPipeline(shader.getVertexModule(), shader.getFragmentModule());
+		NYLogger::logTrace("NYPipeline created");
+	}
+
+	vk::Pipeline NYPipeline::buildPipeline(vk::ShaderModule vertexModule, vk::ShaderModule fragmentModule){
+		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages = {
+			vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eVertex, vertexModule, "main"),
+			vk::PipelineShaderStageCreateInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eFragment, fragmentModule, "main")
+		};
+
 		vk::GraphicsPipelineCreateInfo pipelineInfo = vk::GraphicsPipelineCreateInfo(vk::PipelineCreateFlags(),//flags
 																					2,//no of shader stages
 																					shaderStages.data(),//stages
@@ -83,19 +91,28 @@ namespace Nya {
 																					&pipelineConfig.multisampleStateInfo,//multisample state
 																					nullptr,							//depth stencil state
 																					&colorBlendStateInfo,				//color blend state
-																					nullptr,							//dynamic state
+																					&dynamicStateInfo,					//dynamic state
 																					pipelineLayout,						//layout
 																					renderPass.getRenderpass(),							//renderpass
-																					0,									//subpass
+																					pipelineConfig.subpass,				//subpass
 																					nullptr,							//base pipeline handle
 																					-1);								//base pipeline index
 
-		pipeline = (renderDevice.getDevice().createGraphicsPipeline(nullptr, pipelineInfo)).value;
-		NYLogger::logTrace("NYPipeline created");
+		return renderDevice.createGraphicsPipeline(pipelineInfo);
+	}
+
+	void NYPipeline::swapPipeline(vk::Pipeline newPipeline){
+		vk::Pipeline oldPipeline = pipeline;
+		vk::Device device = renderDevice.getDevice();
+		renderDevice.deferRelease(renderDevice.getSubmittedValue(), [device, oldPipeline]() {
+			device.destroyPipeline(oldPipeline);
+		});
+		pipeline = newPipeline;
 	}
 
 	void NYPipeline::createDefaultPipelineConfig(NYPipelineConfig& config, NYSwapchain& swapchain,
-		std::array<vk::VertexInputBindingDescription, 1>& bindingDesc, std::array<vk::VertexInputAttributeDescription, 2>& attribDesc){
+		vk::ArrayProxyNoTemporaries<const vk::VertexInputBindingDescription> const& bindingDesc,
+		vk::ArrayProxyNoTemporaries<const vk::VertexInputAttributeDescription> const& attribDesc){
 		//this will create config for default rendering
 
 		config.vertexInputStateInfo = vk::PipelineVertexInputStateCreateInfo(vk::PipelineVertexInputStateCreateFlags(),
@@ -110,6 +127,9 @@ namespace Nya {
 		
 		config.viewport = vk::Viewport(0.0f, 0.0f, swapchainExtent.width, swapchainExtent.height, 0.0f, 1.0f);
 		config.scissor = vk::Rect2D(vk::Offset2D(0.0f, 0.0f), swapchainExtent);
+		//set per camera while recording
+		config.dynamicStates = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
+		config.pushConstantRange = vk::PushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, 0);
 
 		config.rasterizerStateInfo = vk::PipelineRasterizationStateCreateInfo(vk::PipelineRasterizationStateCreateFlags(),
 																			  false,//depthClampEnable
@@ -145,4 +165,24 @@ namespace Nya {
 
 		config.swapchainFormat = swapchain.getSwapchainFormat();
 	}
+
+	void NYPipeline::setBlendMode(NYPipelineConfig& config, NYBlendMode blendMode) {
+		switch (blendMode) {
+		case NYBlendMode::eOpaque:
+			config.colorBlendAttachment.blendEnable = false;
+			break;
+		case NYBlendMode::eAlpha:
+			config.colorBlendAttachment.blendEnable = true;
+			config.colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+			config.colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+			break;
+		case NYBlendMode::eAdditive:
+			config.colorBlendAttachment.blendEnable = true;
+			config.colorBlendAttachment.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+			config.colorBlendAttachment.dstColorBlendFactor = vk::BlendFactor::eOne;
+			break;
+		default:
+			NYLogger::checkAssert(false, "Invalid blend mode passed to NYPipeline::setBlendMode()");
+		}
+	}
 }
\ No newline at end of file
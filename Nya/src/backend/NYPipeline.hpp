@@ -6,6 +6,7 @@
 #include "NYDescriptorSetLayout.hpp"
 #include "NYShader.hpp"
 #include "NYRenderPass.hpp"
+#include "defines.hpp"
 
 /*
 This class is supposed to wrap the vk::Pipeline class
@@ -22,6 +23,12 @@ namespace Nya {
 		vk::PipelineMultisampleStateCreateInfo multisampleStateInfo;
 		vk::PipelineColorBlendAttachmentState colorBlendAttachment;
 		vk::Format swapchainFormat;
+		//viewport and scissor are dynamic in the default config, so the baked ones above are ignored
+		std::vector<vk::DynamicState> dynamicStates;
+		//size 0 means the pipeline has no push constants
+		vk::PushConstantRange pushConstantRange;
+		//subpass of the render pass the pipeline is used in, frame graph passes can end up merged into any subpass
+		uint32_t subpass = 0;
 	};
 
 	class NYPipeline {
@@ -30,26 +37,40 @@ namespace Nya {
 		NYPipeline& operator=(NYPipeline const&) = delete;
 
 
-		//config must remain defined and valid until pipeline is created
-		NYPipeline(NYRenderDevice& _renderDevice, NYPipelineConfig& _pipelineConfig, NYShader& _shader, NYDescriptorSetLayout& _descLayout, NYRenderPass& _renderPass);
+		//the config and the vertex descriptions it points at are copied, so hot reloads can build the pipeline again later
+		//descLayouts are in set order, the first one is set 0
+		NYPipeline(NYRenderDevice& _renderDevice, NYPipelineConfig& _pipelineConfig, NYShader& _shader, std::vector<NYDescriptorSetLayout*> _descLayouts, NYRenderPass& _renderPass);
 		~NYPipeline();
 
+		//the binding and attribute descriptions are referenced by the config, so they must outlive it
 		static void createDefaultPipelineConfig(NYPipelineConfig& config, NYSwapchain& swapchain,
-			std::array<vk::VertexInputBindingDescription, 1>& bindingDesc, std::array<vk::VertexInputAttributeDescription, 2>& attribDesc);
+			vk::ArrayProxyNoTemporaries<const vk::VertexInputBindingDescription> const& bindingDesc,
+			vk::ArrayProxyNoTemporaries<const vk::VertexInputAttributeDescription> const& attribDesc);
+		//overwrites the config's color blend attachment, the default config uses alpha blending
+		static void setBlendMode(NYPipelineConfig& config, NYBlendMode blendMode);
 
 		//getters
 		vk::Pipeline& getPipeline() { return pipeline; }
 		NYRenderPass& getRenderPass() { return renderPass; }
-		vk::DescriptorSetLayout& getDescriptorSetLayout() { return descLayout.getLayout(); }
+		vk::DescriptorSetLayout& getDescriptorSetLayout(uint32_t set) { return descLayouts[set]->getLayout(); }
 		vk::PipelineLayout& getLayout() { return pipelineLayout; }
+		NYShader& getShader() { return shader; }
+
+		//hot reload, builds a pipeline with the same state and layout out of other modules, safe to call off the render thread
+		vk::Pipeline buildPipeline(vk::ShaderModule vertexModule, vk::ShaderModule fragmentModule);
+		//swaps in a pipeline from buildPipeline() between frames, the old one is destroyed once the frames using it are done
+		void swapPipeline(vk::Pipeline newPipeline);
 
 	private:
+		void copyConfig(NYPipelineConfig& config);
 		void createPipelineResources();
 		void createPipeline();
 
 		NYRenderDevice& renderDevice;
 
-		NYPipelineConfig& pipelineConfig;
+		NYPipelineConfig pipelineConfig;
+		std::vector<vk::VertexInputBindingDescription> bindingDescs;
+		std::vector<vk::VertexInputAttributeDescription> attribDescs;
 		vk::PipelineLayoutCreateInfo pipelineLayoutInfo;
 
 		NYShader& shader;
@@ -58,15 +79,14 @@ namespace Nya {
 		vk::PipelineLayout pipelineLayout;
 		vk::PipelineViewportStateCreateInfo viewportStateInfo;
 		vk::PipelineColorBlendStateCreateInfo colorBlendStateInfo;
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
+		vk::PipelineDynamicStateCreateInfo dynamicStateInfo;
+		std::vector<vk::DescriptorSetLayout> setLayouts;
 
 
 		vk::Pipeline pipeline;
 
 		NYRenderPass& renderPass;
-		vk::RenderPass offscreenPass;
-		vk::RenderPass compositePass;
 
-		NYDescriptorSetLayout& descLayout;
+		std::vector<NYDescriptorSetLayout*> descLayouts;
 	};
 }
@@ -0,0 +1,419 @@
+#include "pch.hpp"
+#include "NYPipelineLibrary.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+#include "utils/NYHash.hpp"
+
+namespace Nya {
+	namespace {
+		const uint32_t recordMagic = 0x4c50594e;//"NYPL"
+		//bump when the serialized config changes
+		const uint32_t recordVersion = 2;
+
+		template<typename T>
+		void writeValue(std::vector<uint8_t>& data, const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "only plain values can be serialized");
+			const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+			data.insert(data.end(), bytes, bytes + sizeof(T));
+		}
+		template<typename T>
+		void writeArray(std::vector<uint8_t>& data, const T* values, uint32_t count) {
+			writeValue(data, count);
+			for (uint32_t i = 0; i < count; i++) {
+				writeValue(data, values[i]);
+			}
+		}
+
+		template<typename T>
+		bool readValue(const std::vector<uint8_t>& data, size_t& offset, T& value) {
+			if (offset + sizeof(T) > data.size()) {
+				return false;
+			}
+			memcpy(&value, data.data() + offset, sizeof(T));
+			offset += sizeof(T);
+			return true;
+		}
+		template<typename T>
+		bool readArray(const std::vector<uint8_t>& data, size_t& offset, std::vector<T>& values) {
+			uint32_t count = 0;
+			if (!readValue(data, offset, count) || offset + count * sizeof(T) > data.size()) {
+				return false;
+			}
+			values.resize(count);
+			for (uint32_t i = 0; i < count; i++) {
+				readValue(data, offset, values[i]);
+			}
+			return true;
+		}
+
+		void writeString(std::ofstream& file, const std::string& string) {
+			uint32_t size = static_cast<uint32_t>(string.size());
+			file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+			file.write(string.data(), size);
+		}
+		bool readString(std::ifstream& file, std::string& string) {
+			uint32_t size = 0;
+			//anything longer is a corrupt record, not a name or a path
+			if (!file.read(reinterpret_cast<char*>(&size), sizeof(size)) || size > 4096) {
+				return false;
+			}
+			string.resize(size);
+			return static_cast<bool>(file.read(string.data(), size));
+		}
+	}
+
+	NYPipelineLibrary::NYPipelineLibrary(NYRenderDevice& _renderDevice, NYShaderWatcher& _shaderWatcher, uint32_t threadCount)
+		:renderDevice(_renderDevice), shaderWatcher(_shaderWatcher) {
+		for (uint32_t i = 0; i < std::max(threadCount, 1u); i++) {
+			threads.emplace_back(&NYPipelineLibrary::compileLoop, this);
+		}
+	}
+
+	NYPipelineLibrary::~NYPipelineLibrary(){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		workReady.notify_all();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+
+		saveRecord();
+		for (std::unique_ptr<Entry>& entry : entries) {
+			if (entry->pipeline) {
+				shaderWatcher.unwatch(*entry->pipeline);
+			}
+		}
+	}
+
+	void NYPipelineLibrary::registerTarget(const std::string& name, std::vector<NYDescriptorSetLayout*> descLayouts, NYRenderPass& renderPass){
+		std::lock_guard<std::mutex> lock(mutex);
+		NYLogger::checkAssert(findTarget(name) == nullptr, "NYPipelineLibrary target names have to be unique");
+		for (NYDescriptorSetLayout* descLayout : descLayouts) {
+			NYLogger::checkAssert(descLayout->isBuilt(), "NYDescriptorSetLayout must be built before passing as parameter");
+		}
+		targets.push_back(std::make_unique<Target>(Target{ name, descLayouts, &renderPass }));
+	}
+
+	void NYPipelineLibrary::registerShader(NYShader& shader){
+		std::lock_guard<std::mutex> lock(mutex);
+		if (std::find(shaders.begin(), shaders.end(), &shader) == shaders.end()) {
+			shaders.push_back(&shader);
+		}
+	}
+
+	NYPipelineLibrary::Handle NYPipelineLibrary::request(NYPipelineConfig& config, NYShader& shader, const std::string& targetName){
+		std::vector<uint8_t> configData;
+		size_t compatSize = 0;
+		writeConfig(config, configData, compatSize);
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Target* target = findTarget(targetName);
+		NYLogger::checkAssert(target != nullptr, "Pipeline requested for a target that wasn't registered, call NYPipelineLibrary::registerTarget()");
+		if (std::find(shaders.begin(), shaders.end(), &shader) == shaders.end()) {
+			shaders.push_back(&shader);
+		}
+
+		requests++;
+		size_t entryCount = entries.size();
+		Handle handle = addEntry(configData, compatSize, shader, *target);
+		if (entries.size() == entryCount) {
+			deduplicated++;
+		}
+		return handle;
+	}
+
+	bool NYPipelineLibrary::isReady(Handle handle){
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries[handle]->ready;
+	}
+
+	void NYPipelineLibrary::wait(Handle handle){
+		std::unique_lock<std::mutex> lock(mutex);
+		Entry& entry = *entries[handle];
+		pipelineReady.wait(lock, [&entry]() { return entry.ready; });
+	}
+
+	NYPipeline& NYPipelineLibrary::get(Handle handle){
+		std::unique_lock<std::mutex> lock(mutex);
+		Entry& entry = *entries[handle];
+		bool waited = false;
+		while (true) {
+			if (entry.ready) {
+				return *entry.pipeline;
+			}
+			for (std::unique_ptr<Entry>& other : entries) {
+				if (other->ready && other->compatKey == entry.compatKey) {
+					fallbacks++;
+					return *other->pipeline;
+				}
+			}
+			if (!waited) {
+				blockingWaits++;
+				waited = true;
+			}
+			pipelineReady.wait(lock);
+		}
+	}
+
+	void NYPipelineLibrary::prewarm(const std::string& path){
+		NY_PROFILE_ZONE("prewarm pipelines");
+		std::lock_guard<std::mutex> lock(mutex);
+		recordPath = path;
+
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			NYLogger::logTrace("no pipeline record at %s, starting a new one", path.c_str());
+			return;
+		}
+		uint32_t header[3] = {};
+		if (!file.read(reinterpret_cast<char*>(header), sizeof(header)) || header[0] != recordMagic || header[1] != recordVersion) {
+			NYLogger::logWarning("pipeline record %s is from another version, starting a new one", path.c_str());
+			return;
+		}
+
+		uint32_t queued = 0;
+		uint32_t skipped = 0;
+		for (uint32_t i = 0; i < header[2]; i++) {
+			std::string targetName;
+			uint32_t sourceCount = 0;
+			if (!readString(file, targetName) || !file.read(reinterpret_cast<char*>(&sourceCount), sizeof(sourceCount)) || sourceCount > 8) {
+				NYLogger::logWarning("pipeline record %s is truncated", path.c_str());
+				break;
+			}
+			std::vector<std::string> sourcePaths(sourceCount);
+			bool complete = true;
+			for (std::string& sourcePath : sourcePaths) {
+				complete = complete && readString(file, sourcePath);
+			}
+			std::string recordedData;
+			complete = complete && readString(file, recordedData);
+			if (!complete) {
+				NYLogger::logWarning("pipeline record %s is truncated", path.c_str());
+				break;
+			}
+
+			//pipelines of targets or shaders this run doesn't have are dropped from the record
+			Target* target = findTarget(targetName);
+			NYShader* shader = findShader(sourcePaths);
+			NYPipelineConfig config;
+			std::vector<vk::VertexInputBindingDescription> bindingDescs;
+			std::vector<vk::VertexInputAttributeDescription> attribDescs;
+			if (!target || !shader || !readConfig(std::vector<uint8_t>(recordedData.begin(), recordedData.end()), config, bindingDescs, attribDescs)) {
+				skipped++;
+				continue;
+			}
+
+			//written out again rather than used as is, so it hashes the same as a request for the same config
+			std::vector<uint8_t> configData;
+			size_t compatSize = 0;
+			writeConfig(config, configData, compatSize);
+			size_t entryCount = entries.size();
+			addEntry(configData, compatSize, *shader, *target);
+			if (entries.size() > entryCount) {
+				queued++;
+			}
+		}
+		prewarmed += queued;
+		NYLogger::logInfo("prewarming %u pipelines recorded in %s, %u skipped", queued, path.c_str(), skipped);
+	}
+
+	void NYPipelineLibrary::logStats(){
+		std::lock_guard<std::mutex> lock(mutex);
+		uint32_t readyCount = 0;
+		for (std::unique_ptr<Entry>& entry : entries) {
+			readyCount += entry->ready ? 1 : 0;
+		}
+		NYLogger::logInfo("pipeline library: %u of %zu pipelines ready (%u prewarmed), %u requests (%u deduplicated), %u fallbacks, %u blocking waits",
+			readyCount, entries.size(), prewarmed, requests, deduplicated, fallbacks, blockingWaits);
+	}
+
+	NYPipelineLibrary::Handle NYPipelineLibrary::addEntry(std::vector<uint8_t>& configData, size_t compatSize, NYShader& shader, Target& target){
+		//the shader and target stand in for the modules, layouts and render pass, they're fixed for as long as the library lives
+		//and hot reloads swap modules under the same pipelines
+		NYHash compatHash;
+		compatHash.addValue(&target);
+		compatHash.addBytes(configData.data(), compatSize);
+
+		NYHash hash;
+		hash.addValue(compatHash.get());
+		hash.addValue(&shader);
+		hash.addBytes(configData.data() + compatSize, configData.size() - compatSize);
+		uint64_t key = hash.get();
+
+		auto found = handles.find(key);
+		if (found != handles.end()) {
+			return found->second;
+		}
+
+		std::unique_ptr<Entry> entry = std::make_unique<Entry>();
+		entry->key = key;
+		entry->compatKey = compatHash.get();
+		entry->configData = configData;
+		entry->shader = &shader;
+		entry->target = &target;
+
+		Handle handle = static_cast<Handle>(entries.size());
+		entries.push_back(std::move(entry));
+		handles[key] = handle;
+		queue.push_back(handle);
+		workReady.notify_one();
+		return handle;
+	}
+
+	NYPipelineLibrary::Target* NYPipelineLibrary::findTarget(const std::string& name){
+		for (std::unique_ptr<Target>& target : targets) {
+			if (target->name == name) {
+				return target.get();
+			}
+		}
+		return nullptr;
+	}
+
+	NYShader* NYPipelineLibrary::findShader(const std::vector<std::string>& sourcePaths){
+		for (NYShader* shader : shaders) {
+			if (shader->getSourcePaths() == sourcePaths) {
+				return shader;
+			}
+		}
+		return nullptr;
+	}
+
+	void NYPipelineLibrary::compileLoop(){
+		NY_PROFILE_THREAD("pipeline compiler");
+		std::unique_lock<std::mutex> lock(mutex);
+		while (true) {
+			workReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+			if (stopping) {
+				return;
+			}
+			Entry& entry = *entries[queue.front()];
+			queue.pop_front();
+
+			//nothing reads the pipeline until it's marked ready
+			lock.unlock();
+			compile(entry);
+			lock.lock();
+
+			entry.ready = true;
+			pipelineReady.notify_all();
+		}
+	}
+
+	void NYPipelineLibrary::compile(Entry& entry){
+		NY_PROFILE_ZONE("compile pipeline");
+		NYPipelineConfig config;
+		std::vector<vk::VertexInputBindingDescription> bindingDescs;
+		std::vector<vk::VertexInputAttributeDescription> attribDescs;
+		readConfig(entry.configData, config, bindingDescs, attribDescs);
+
+		entry.pipeline = std::make_unique<NYPipeline>(renderDevice, config, *entry.shader, entry.target->descLayouts, *entry.target->renderPass);
+		shaderWatcher.watch(*entry.pipeline);
+	}
+
+	void NYPipelineLibrary::saveRecord(){
+		if (recordPath.empty()) {
+			return;
+		}
+		//written next to the old one and swapped in, like the pipeline cache
+		std::string tempPath = recordPath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				NYLogger::logWarning("couldn't write the pipeline record to %s", tempPath.c_str());
+				return;
+			}
+			uint32_t header[3] = { recordMagic, recordVersion, static_cast<uint32_t>(entries.size()) };
+			file.write(reinterpret_cast<const char*>(header), sizeof(header));
+			for (std::unique_ptr<Entry>& entry : entries) {
+				writeString(file, entry->target->name);
+				std::vector<std::string> sourcePaths = entry->shader->getSourcePaths();
+				uint32_t sourceCount = static_cast<uint32_t>(sourcePaths.size());
+				file.write(reinterpret_cast<const char*>(&sourceCount), sizeof(sourceCount));
+				for (std::string& sourcePath : sourcePaths) {
+					writeString(file, sourcePath);
+				}
+				writeString(file, std::string(entry->configData.begin(), entry->configData.end()));
+			}
+		}
+		std::error_code error;
+		std::filesystem::rename(tempPath, recordPath, error);
+		if (error) {
+			NYLogger::logWarning("couldn't replace the pipeline record %s", recordPath.c_str());
+			return;
+		}
+		NYLogger::logTrace("%zu pipelines recorded to %s", entries.size(), recordPath.c_str());
+	}
+
+	void NYPipelineLibrary::writeConfig(NYPipelineConfig& config, std::vector<uint8_t>& data, size_t& compatSize){
+		data.clear();
+		//what a stand in pipeline has to share, everything bound around the draw stays valid with it
+		vk::PipelineVertexInputStateCreateInfo& vertexInput = config.vertexInputStateInfo;
+		writeArray(data, vertexInput.pVertexBindingDescriptions, vertexInput.vertexBindingDescriptionCount);
+		writeArray(data, vertexInput.pVertexAttributeDescriptions, vertexInput.vertexAttributeDescriptionCount);
+		writeArray(data, config.dynamicStates.data(), static_cast<uint32_t>(config.dynamicStates.size()));
+		writeValue(data, config.pushConstantRange);
+		writeValue(data, config.subpass);
+		compatSize = data.size();
+
+		writeValue(data, config.inputAssemblyInfo.topology);
+		writeValue(data, config.inputAssemblyInfo.primitiveRestartEnable);
+		//dynamic ones are set per draw, leaving the extent they were made at out keeps resizes from looking like new pipelines
+		auto isDynamic = [&](vk::DynamicState state) {
+			return std::find(config.dynamicStates.begin(), config.dynamicStates.end(), state) != config.dynamicStates.end();
+		};
+		writeValue(data, isDynamic(vk::DynamicState::eViewport) ? vk::Viewport() : config.viewport);
+		writeValue(data, isDynamic(vk::DynamicState::eScissor) ? vk::Rect2D() : config.scissor);
+
+		vk::PipelineRasterizationStateCreateInfo& rasterizer = config.rasterizerStateInfo;
+		writeValue(data, rasterizer.depthClampEnable);
+		writeValue(data, rasterizer.rasterizerDiscardEnable);
+		writeValue(data, rasterizer.polygonMode);
+		writeValue(data, rasterizer.cullMode);
+		writeValue(data, rasterizer.frontFace);
+		writeValue(data, rasterizer.depthBiasEnable);
+		writeValue(data, rasterizer.depthBiasConstantFactor);
+		writeValue(data, rasterizer.depthBiasClamp);
+		writeValue(data, rasterizer.depthBiasSlopeFactor);
+		writeValue(data, rasterizer.lineWidth);
+
+		vk::PipelineMultisampleStateCreateInfo& multisample = config.multisampleStateInfo;
+		NYLogger::checkAssert(multisample.pSampleMask == nullptr, "NYPipelineLibrary doesn't support sample masks");
+		writeValue(data, multisample.rasterizationSamples);
+		writeValue(data, multisample.sampleShadingEnable);
+		writeValue(data, multisample.minSampleShading);
+		writeValue(data, multisample.alphaToCoverageEnable);
+		writeValue(data, multisample.alphaToOneEnable);
+
+		writeValue(data, config.colorBlendAttachment);
+		writeValue(data, config.swapchainFormat);
+	}
+
+	bool NYPipelineLibrary::readConfig(const std::vector<uint8_t>& data, NYPipelineConfig& config,
+		std::vector<vk::VertexInputBindingDescription>& bindingDescs, std::vector<vk::VertexInputAttributeDescription>& attribDescs){
+		size_t offset = 0;
+		bool valid = readArray(data, offset, bindingDescs) && readArray(data, offset, attribDescs) && readArray(data, offset, config.dynamicStates)
+			&& readValue(data, offset, config.pushConstantRange) && readValue(data, offset, config.subpass);
+		config.vertexInputStateInfo.setVertexBindingDescriptions(bindingDescs);
+		config.vertexInputStateInfo.setVertexAttributeDescriptions(attribDescs);
+
+		valid = valid && readValue(data, offset, config.inputAssemblyInfo.topology) && readValue(data, offset, config.inputAssemblyInfo.primitiveRestartEnable)
+			&& readValue(data, offset, config.viewport) && readValue(data, offset, config.scissor);
+
+		vk::PipelineRasterizationStateCreateInfo& rasterizer = config.rasterizerStateInfo;
+		valid = valid && readValue(data, offset, rasterizer.depthClampEnable) && readValue(data, offset, rasterizer.rasterizerDiscardEnable)
+			&& readValue(data, offset, rasterizer.polygonMode) && readValue(data, offset, rasterizer.cullMode)
+			&& readValue(data, offset, rasterizer.frontFace) && readValue(data, offset, rasterizer.depthBiasEnable)
+			&& readValue(data, offset, rasterizer.depthBiasConstantFactor) && readValue(data, offset, rasterizer.depthBiasClamp)
+			&& readValue(data, offset, rasterizer.depthBiasSlopeFactor) && readValue(data, offset, rasterizer.lineWidth);
+
+		vk::PipelineMultisampleStateCreateInfo& multisample = config.multisampleStateInfo;
+		valid = valid && readValue(data, offset, multisample.rasterizationSamples) && readValue(data, offset, multisample.sampleShadingEnable)
+			&& readValue(data, offset, multisample.minSampleShading) && readValue(data, offset, multisample.alphaToCoverageEnable)
+			&& readValue(data, offset, multisample.alphaToOneEnable);
+
+		valid = valid && readValue(data, offset, config.colorBlendAttachment) && readValue(data, offset, config.swapchainFormat);
+		return valid && offset == data.size();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYPipeline.hpp"
+#include "NYShader.hpp"
+#include "NYShaderWatcher.hpp"
+#include "NYRenderPass.hpp"
+#include "NYDescriptorSetLayout.hpp"
+
+namespace Nya {
+	//every graphics pipeline the game uses, deduplicated and compiled in the background
+	//pipelines are keyed on a hash of the whole config, the shader, the descriptor layouts and the render pass, so requesting
+	//the same one twice hands back the same handle. requests return straight away and are compiled on the library's own threads,
+	//until one is done get() returns a finished pipeline that's compatible with it (same layouts, render pass, subpass and
+	//vertex input) so the frame can still be drawn without hitching
+	//what a session requested is saved and compiled ahead of time on the next run by prewarm()
+	class NYPipelineLibrary {
+	public:
+		typedef uint32_t Handle;
+
+		NYPipelineLibrary(NYRenderDevice& _renderDevice, NYShaderWatcher& _shaderWatcher, uint32_t threadCount = 2);
+		~NYPipelineLibrary();
+
+		NYPipelineLibrary(NYPipelineLibrary const&) = delete;
+		NYPipelineLibrary& operator=(NYPipelineLibrary const&) = delete;
+
+		//what pipelines are built against besides their config and shader, the render pass has to be built already
+		//registered under a name so pipelines recorded in an earlier session can find it again
+		void registerTarget(const std::string& name, std::vector<NYDescriptorSetLayout*> descLayouts, NYRenderPass& renderPass);
+		//shaders are found again by their source paths, request() registers the shader it's given too
+		void registerShader(NYShader& shader);
+
+		//the config is copied, so it doesn't need to outlive the call
+		Handle request(NYPipelineConfig& config, NYShader& shader, const std::string& targetName);
+		bool isReady(Handle handle);
+		void wait(Handle handle);
+		//the pipeline if it's done, otherwise a finished compatible one. only blocks when nothing compatible is done yet,
+		//which only happens for the first pipeline of its kind
+		NYPipeline& get(Handle handle);
+
+		//queues every pipeline recorded at path whose target and shader are registered, and records this session's
+		//pipelines to the same path when the library is destroyed. a missing file just starts a new record
+		void prewarm(const std::string& path);
+
+		void logStats();
+
+	private:
+		struct Target {
+			std::string name;
+			std::vector<NYDescriptorSetLayout*> descLayouts;
+			NYRenderPass* renderPass;
+		};
+
+		struct Entry {
+			uint64_t key;
+			//pipelines with the same compatibility key can stand in for each other
+			uint64_t compatKey;
+			//serialized config, rebuilt on the compile thread and saved for prewarming
+			std::vector<uint8_t> configData;
+			NYShader* shader;
+			Target* target;
+			std::unique_ptr<NYPipeline> pipeline;
+			bool ready = false;
+		};
+
+		Handle addEntry(std::vector<uint8_t>& configData, size_t compatSize, NYShader& shader, Target& target);
+		Target* findTarget(const std::string& name);
+		NYShader* findShader(const std::vector<std::string>& sourcePaths);
+		void compileLoop();
+		void compile(Entry& entry);
+		void saveRecord();
+
+		//the config is written compatibility relevant state first, compatSize is how many bytes of it that is
+		static void writeConfig(NYPipelineConfig& config, std::vector<uint8_t>& data, size_t& compatSize);
+		//the vertex descriptions the config points at are read into bindingDescs and attribDescs
+		static bool readConfig(const std::vector<uint8_t>& data, NYPipelineConfig& config,
+			std::vector<vk::VertexInputBindingDescription>& bindingDescs, std::vector<vk::VertexInputAttributeDescription>& attribDescs);
+
+		NYRenderDevice& renderDevice;
+		NYShaderWatcher& shaderWatcher;
+
+		//guards everything below, the compile threads only hold it to take work and publish results
+		std::mutex mutex;
+		std::condition_variable workReady;
+		std::condition_variable pipelineReady;
+		//entries never move once added, handles index into this
+		std::vector<std::unique_ptr<Entry>> entries;
+		std::unordered_map<uint64_t, Handle> handles;
+		std::deque<Handle> queue;
+		std::vector<std::unique_ptr<Target>> targets;
+		std::vector<NYShader*> shaders;
+		std::string recordPath;
+		bool stopping = false;
+
+		uint32_t requests = 0;
+		uint32_t deduplicated = 0;
+		uint32_t prewarmed = 0;
+		uint32_t fallbacks = 0;
+		uint32_t blockingWaits = 0;
+
+		std::vector<std::thread> threads;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define VMA_IMPLEMENTATION
 #include "vk_mem_alloc.h"
 #include "NYRenderDevice.hpp"
+#include "NYTextureStreamer.hpp"
 #include "../logging/NYLogger.hpp"
 
 #ifdef NY_DEBUG
@@ -28,7 +29,9 @@
 	}
 #endif
 namespace Nya {
-	NYRenderDevice::NYRenderDevice(NYRenderDeviceCreateInfo& _createInfo, NYWindow& _window):window(_window) {
+	NYRenderDevice::NYRenderDevice(NYRenderDeviceCreateInfo& _createInfo, NYWindow* _window)
+		:window(_window), headless(_createInfo.headless), pipelineCachePath(_createInfo.pipelineCachePath ? _createInfo.pipelineCachePath : "") {
+		NYLogger::checkAssert(headless || window, "NYRenderDevice needs a window unless it's headless");
 		createInstance(_createInfo.appName, _createInfo.appVersion);
 #ifdef NY_DEBUG
 		createDebugMessenger();
@@ -36,14 +39,31 @@ namespace Nya {
 		createDevice();
 		createVmaAllocator();
 		createCommandPool();
+		createTimeline();
+		createPipelineCache();
+		uploadContext = std::make_unique<NYUploadContext>(*this, NYUploadContext::Queue::eGraphics);
+		textureStreamer = std::make_unique<NYTextureStreamer>(*this);
 		NYLogger::logTrace("NYRenderDevice created");
 	}
 
 	NYRenderDevice::~NYRenderDevice(){
+		//everything still waiting on the timeline is safe to release once the device is idle
+		device.waitIdle();
+		for (auto& deferred : deferredReleases) {
+			deferred.release();
+		}
+		deferredReleases.clear();
+		textureStreamer.reset();
+		uploadContext.reset();
+		savePipelineCache();
+		device.destroyPipelineCache(pipelineCache);
+		device.destroySemaphore(graphicsTimeline);
 		device.destroyCommandPool(commandPool, nullptr);
 		vmaDestroyAllocator(allocator);
 		device.destroy();
-		vkDestroySurfaceKHR(static_cast<VkInstance>(instance), surface, nullptr);
+		if (surface != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(static_cast<VkInstance>(instance), surface, nullptr);
+		}
 #ifndef NDEBUG
 		instance.destroyDebugUtilsMessengerEXT(debugUtilsMessenger);
 #endif
@@ -51,6 +71,19 @@ namespace Nya {
 		NYLogger::logTrace("NYRenderDevice destroyed");
 	}
 
+	NYWindow& NYRenderDevice::getWindow() {
+		NYLogger::checkAssert(window, "headless NYRenderDevice has no window");
+		return *window;
+	}
+
+	NYTextureStreamer& NYRenderDevice::getTextureStreamer() {
+		return *textureStreamer;
+	}
+
+	NYUploadContext& NYRenderDevice::getUploadContext() {
+		return *uploadContext;
+	}
+
 	bool NYRenderDevice::checkLayers(std::vector<const char*> const& layers) {
 		std::vector<vk::LayerProperties> properties = vk::enumerateInstanceLayerProperties();
 		//iterate through all the elements of the vector of layer names
@@ -88,11 +121,14 @@ namespace Nya {
 		);
 		std::vector<const char*> layers;
 
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-		std::vector<const char*> extensionNames(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		//headless devices never make a surface, so they don't need any of glfw's extensions
+		std::vector<const char*> extensionNames;
+		if (!headless) {
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensionNames.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		//if debugging is enabled use the validation layers and extensions
 #ifdef NY_DEBUG
@@ -111,7 +147,10 @@ namespace Nya {
 												  extensionNames.data()
 												 );
 		instance = vk::createInstance(instanceCreateInfo);
-		VkResult err = glfwCreateWindowSurface(static_cast<VkInstance>(instance), window.getHandlePointer(), NULL, &surface);
+		if (headless) {
+			return;
+		}
+		VkResult err = glfwCreateWindowSurface(static_cast<VkInstance>(instance), window->getHandlePointer(), NULL, &surface);
 
 		NYLogger::checkAssert(err == VK_SUCCESS, "failed to create window surface");
 	}
@@ -140,13 +179,28 @@ namespace Nya {
 		//TODO:pick the best gpu on hand
 		//get the first compatible gpu
 		physicalDevice = instance.enumeratePhysicalDevices().front();
-		vk::PhysicalDeviceFeatures features;
+		vk::PhysicalDeviceFeatures supportedFeatures = physicalDevice.getFeatures();
+		vk::PhysicalDeviceFeatures& features = enabledFeatures;
 		features.fillModeNonSolid = true;
 		features.samplerAnisotropy = true;
+		//optional, cooked ktx2 textures in bc formats need it
+		features.textureCompressionBC = supportedFeatures.textureCompressionBC;
+		//optional, indirect draws that don't start at instance 0 need it
+		features.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
 
 		vk::PhysicalDeviceDescriptorIndexingFeatures descFeatures;
 		descFeatures.descriptorBindingSampledImageUpdateAfterBind = true;
 		descFeatures.descriptorBindingUniformBufferUpdateAfterBind = true;
+		//needed for the bindless texture table
+		descFeatures.descriptorBindingPartiallyBound = true;
+		descFeatures.descriptorBindingUpdateUnusedWhilePending = true;
+		descFeatures.runtimeDescriptorArray = true;
+		descFeatures.shaderSampledImageArrayNonUniformIndexing = true;
+
+		//frame pacing, upload tracking and deferred releases all wait on one timeline semaphore
+		vk::PhysicalDeviceTimelineSemaphoreFeatures timelineFeatures;
+		timelineFeatures.timelineSemaphore = true;
+		descFeatures.pNext = &timelineFeatures;
 
 	
 		//print device name and api version from the properties
@@ -165,18 +219,32 @@ namespace Nya {
 			[](vk::QueueFamilyProperties const& qfp)
 			{ return qfp.queueFlags & vk::QueueFlagBits::eGraphics; });
 
-		//now check for present queue
-		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++) {
-			if (physicalDevice.getSurfaceSupportKHR(i, surface)) { presentQueueFamilyIndex = i; }
-		}
-
 		//get its index
 		graphicsQueueFamilyIndex = std::distance(queueFamilyProperties.begin(), graphicsQueueIter);
 
+		//now check for present queue, nothing is presented when headless so it's just the graphics queue
+		if (headless) {
+			presentQueueFamilyIndex = graphicsQueueFamilyIndex;
+		}
+		for (uint32_t i = 0; i < queueFamilyProperties.size() && !headless; i++) {
+			if (physicalDevice.getSurfaceSupportKHR(i, surface)) { presentQueueFamilyIndex = i; }
+		}
+
 		NYLogger::checkAssert(graphicsQueueFamilyIndex.has_value(), "couldn't find a graphics queue");
 
 		NYLogger::checkAssert(presentQueueFamilyIndex.has_value(), "couldn't find a present queue");
 
+		//a family that can only transfer is usually the gpu's copy engine, uploads run on it alongside rendering
+		for (uint32_t i = 0; i < queueFamilyProperties.size(); i++) {
+			vk::QueueFlags flags = queueFamilyProperties[i].queueFlags;
+			if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute))) {
+				transferQueueFamilyIndex = i;
+				break;
+			}
+		}
+		NYLogger::logInfo(transferQueueFamilyIndex.has_value() ? "uploads go through transfer queue family %u" : "no transfer only queue family, uploads go through the graphics queue",
+			transferQueueFamilyIndex.value_or(0));
+
 		// create a Device
 		float queuePriority = 0.0f;
 		/*there can be 2 cases here :
@@ -185,47 +253,37 @@ namespace Nya {
 		
 		2)other one is that they aren't the same, in which case we make 2 DeviceQueueCreateInfos and pass them as an array*/
 
-		//check for swapchain support
-		std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		//check for swapchain support, headless devices don't have one
+		std::vector<const char*> deviceExtensions;
+		if (!headless) {
+			deviceExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+		}
 		NYLogger::checkAssert(checkExtensionSupport(deviceExtensions), "Failed to find support for swapchain");
 
 		//enable the swapchain device extension
 
-		if (graphicsQueueFamilyIndex != presentQueueFamilyIndex) {
-			vk::DeviceQueueCreateInfo graphicsQueueCreateInfo(vk::DeviceQueueCreateFlags(),
-				graphicsQueueFamilyIndex.value(),
-				1, &queuePriority);
-
-			vk::DeviceQueueCreateInfo presentQueueCreateInfo(vk::DeviceQueueCreateFlags(),
-				presentQueueFamilyIndex.value(),
-				1, &queuePriority);
-
-			std::array<vk::DeviceQueueCreateInfo, 2> queueInfos = { graphicsQueueCreateInfo, presentQueueCreateInfo };
-
-			vk::DeviceCreateInfo createInfo;
-			createInfo.pNext = &descFeatures;
-			createInfo.setPEnabledExtensionNames(deviceExtensions);
-			createInfo.pEnabledFeatures = &features;
-			createInfo.setQueueCreateInfos(queueInfos);
-
-			device = physicalDevice.createDevice(vk::DeviceCreateInfo(vk::DeviceCreateFlags(), queueInfos));
+		//one queue per distinct family, graphics and present are often the same one
+		std::set<uint32_t> queueFamilies = { graphicsQueueFamilyIndex.value(), presentQueueFamilyIndex.value() };
+		if (transferQueueFamilyIndex.has_value()) {
+			queueFamilies.insert(transferQueueFamilyIndex.value());
 		}
-		else {
-			vk::DeviceQueueCreateInfo graphicsQueueCreateInfo(vk::DeviceQueueCreateFlags(),
-				graphicsQueueFamilyIndex.value(),
-				1, &queuePriority);
-
-			vk::DeviceCreateInfo createInfo;
-			createInfo.pNext = &descFeatures;
-			createInfo.setPEnabledExtensionNames(deviceExtensions);
-			createInfo.pEnabledFeatures = &features;
-			createInfo.pQueueCreateInfos = &graphicsQueueCreateInfo;
-			createInfo.setQueueCreateInfoCount(1);
-
-			device = physicalDevice.createDevice(createInfo);
+		std::vector<vk::DeviceQueueCreateInfo> queueInfos;
+		for (uint32_t family : queueFamilies) {
+			queueInfos.push_back(vk::DeviceQueueCreateInfo(vk::DeviceQueueCreateFlags(), family, 1, &queuePriority));
 		}
+
+		vk::DeviceCreateInfo createInfo;
+		createInfo.pNext = &descFeatures;
+		createInfo.setPEnabledExtensionNames(deviceExtensions);
+		createInfo.pEnabledFeatures = &features;
+		createInfo.setQueueCreateInfos(queueInfos);
+
+		device = physicalDevice.createDevice(createInfo);
 		graphicsQueue = device.getQueue(graphicsQueueFamilyIndex.value(), 0);
 		presentQueue = device.getQueue(presentQueueFamilyIndex.value(), 0);
+		if (transferQueueFamilyIndex.has_value()) {
+			transferQueue = device.getQueue(transferQueueFamilyIndex.value(), 0);
+		}
 	}
 
 	void NYRenderDevice::createVmaAllocator(){
@@ -248,6 +306,189 @@ namespace Nya {
 		commandPool = device.createCommandPool(createInfo, nullptr);
 	}
 
+	void NYRenderDevice::createTimeline(){
+		vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, 0);
+		vk::SemaphoreCreateInfo createInfo;
+		createInfo.pNext = &typeInfo;
+
+		graphicsTimeline = device.createSemaphore(createInfo);
+	}
+
+	void NYRenderDevice::createPipelineCache(){
+		std::vector<char> data;
+		std::ifstream file(pipelineCachePath, std::ios::binary | std::ios::ate);
+		if (!pipelineCachePath.empty() && file.is_open()) {
+			data.resize(static_cast<size_t>(file.tellg()));
+			file.seekg(0);
+			file.read(data.data(), data.size());
+		}
+
+		//the driver is supposed to reject caches that aren't its own, but not all of them do it gracefully,
+		//so the header is checked against this device before anything is handed over
+		vk::PhysicalDeviceProperties props = physicalDevice.getProperties();
+		VkPipelineCacheHeaderVersionOne header{};
+		bool valid = data.size() >= sizeof(header);
+		if (valid) {
+			memcpy(&header, data.data(), sizeof(header));
+			valid = header.headerSize >= sizeof(header) && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+				header.vendorID == props.vendorID && header.deviceID == props.deviceID &&
+				memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		}
+		if (!data.empty() && !valid) {
+			NYLogger::logWarning("pipeline cache %s was made by another device or driver, starting cold", pipelineCachePath.c_str());
+		}
+
+		vk::PipelineCacheCreateInfo createInfo;
+		if (valid) {
+			createInfo.initialDataSize = data.size();
+			createInfo.pInitialData = data.data();
+		}
+		pipelineCache = device.createPipelineCache(createInfo);
+		pipelineCacheWarm = valid;
+		if (valid) {
+			NYLogger::logTrace("pipeline cache loaded from %s (%zu bytes)", pipelineCachePath.c_str(), data.size());
+		}
+	}
+
+	void NYRenderDevice::savePipelineCache(){
+		if (pipelineCachePath.empty()) {
+			return;
+		}
+		std::vector<uint8_t> data = device.getPipelineCacheData(pipelineCache);
+
+		//written next to the old one and swapped in, so a crash halfway through can't leave a truncated cache behind
+		std::string tempPath = pipelineCachePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				NYLogger::logWarning("couldn't write the pipeline cache to %s", tempPath.c_str());
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(data.data()), data.size());
+		}
+		std::error_code error;
+		std::filesystem::rename(tempPath, pipelineCachePath, error);
+		if (error) {
+			NYLogger::logWarning("couldn't replace the pipeline cache %s", pipelineCachePath.c_str());
+			return;
+		}
+		NYLogger::logTrace("pipeline cache saved to %s (%zu bytes)", pipelineCachePath.c_str(), data.size());
+	}
+
+	vk::Pipeline NYRenderDevice::createGraphicsPipeline(vk::GraphicsPipelineCreateInfo& pipelineInfo){
+		auto start = std::chrono::steady_clock::now();
+		auto result = device.createGraphicsPipeline(pipelineCache, pipelineInfo);
+		NYLogger::checkAssert(result.result == vk::Result::eSuccess, "failed to create graphics pipeline");
+		float millis = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> lock(pipelineStatsMutex);
+		pipelineCreationMillis += millis;
+		pipelinesCreated++;
+		return result.value;
+	}
+
+	vk::Pipeline NYRenderDevice::createComputePipeline(vk::ComputePipelineCreateInfo& pipelineInfo){
+		auto start = std::chrono::steady_clock::now();
+		auto result = device.createComputePipeline(pipelineCache, pipelineInfo);
+		NYLogger::checkAssert(result.result == vk::Result::eSuccess, "failed to create compute pipeline");
+		float millis = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::lock_guard<std::mutex> lock(pipelineStatsMutex);
+		pipelineCreationMillis += millis;
+		pipelinesCreated++;
+		return result.value;
+	}
+
+	void NYRenderDevice::logPipelineStats(){
+		NYLogger::logInfo("%u pipelines created in %.2f ms with a %s pipeline cache", pipelinesCreated, pipelineCreationMillis,
+			pipelineCacheWarm ? "warm" : "cold");
+	}
+
+	uint64_t NYRenderDevice::submitGraphics(vk::ArrayProxy<const vk::CommandBuffer> const& commandBuffers,
+		vk::ArrayProxy<const vk::Semaphore> const& waitSemaphores, vk::ArrayProxy<const vk::PipelineStageFlags> const& waitStages,
+		vk::ArrayProxy<const vk::Semaphore> const& signalSemaphores, vk::ArrayProxy<const uint64_t> const& waitValues){
+		NYLogger::checkAssert(waitSemaphores.size() == waitStages.size(), "NYRenderDevice::submitGraphics() needs a wait stage per wait semaphore");
+		NYLogger::checkAssert(waitValues.empty() || waitValues.size() == waitSemaphores.size(), "NYRenderDevice::submitGraphics() needs a wait value per wait semaphore");
+		std::lock_guard<std::mutex> lock(submitMutex);
+		uint64_t value = ++submittedValue;
+
+		//the timeline goes after the caller's binary semaphores, whose values are ignored
+		std::vector<vk::Semaphore> signals(signalSemaphores.begin(), signalSemaphores.end());
+		signals.push_back(graphicsTimeline);
+		std::vector<uint64_t> signalValues(signals.size(), 0);
+		signalValues.back() = value;
+		std::vector<uint64_t> timelineWaitValues(waitValues.begin(), waitValues.end());
+		timelineWaitValues.resize(waitSemaphores.size(), 0);
+
+		vk::TimelineSemaphoreSubmitInfo timelineInfo;
+		timelineInfo.setWaitSemaphoreValues(timelineWaitValues);
+		timelineInfo.setSignalSemaphoreValues(signalValues);
+
+		vk::SubmitInfo submitInfo;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = waitSemaphores.size();
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		submitInfo.commandBufferCount = commandBuffers.size();
+		submitInfo.pCommandBuffers = commandBuffers.data();
+		submitInfo.setSignalSemaphores(signals);
+
+		graphicsQueue.submit(1, &submitInfo, VK_NULL_HANDLE);
+		return value;
+	}
+
+	vk::Result NYRenderDevice::present(vk::PresentInfoKHR& presentInfo){
+		std::lock_guard<std::mutex> lock(submitMutex);
+		//the pointer overload hands back out of date instead of throwing, the renderer recreates the swapchain on it
+		return presentQueue.presentKHR(&presentInfo);
+	}
+
+	bool NYRenderDevice::isValueReached(uint64_t value){
+		if (value <= completedValue) {
+			return true;
+		}
+		uint64_t current = device.getSemaphoreCounterValue(graphicsTimeline);
+		//other threads may have read a later value in the meantime, only ever move it forward
+		uint64_t known = completedValue;
+		while (current > known && !completedValue.compare_exchange_weak(known, current)) {}
+		return value <= current;
+	}
+
+	void NYRenderDevice::waitForValue(uint64_t value){
+		if (isValueReached(value)) {
+			return;
+		}
+		vk::SemaphoreWaitInfo waitInfo;
+		waitInfo.setSemaphores(graphicsTimeline);
+		waitInfo.setValues(value);
+		auto result = device.waitSemaphores(waitInfo, UINT64_MAX);
+		NYLogger::checkAssert(result == vk::Result::eSuccess, "failed to wait on the graphics timeline");
+		isValueReached(value);
+	}
+
+	void NYRenderDevice::deferRelease(uint64_t value, std::function<void()> release){
+		std::lock_guard<std::mutex> lock(releaseMutex);
+		deferredReleases.push_back({ value, std::move(release) });
+	}
+
+	void NYRenderDevice::collectReleases(){
+		std::vector<std::function<void()>> ready;
+		{
+			std::lock_guard<std::mutex> lock(releaseMutex);
+			for (size_t i = 0; i < deferredReleases.size();) {
+				if (isValueReached(deferredReleases[i].value)) {
+					ready.push_back(std::move(deferredReleases[i].release));
+					deferredReleases[i] = std::move(deferredReleases.back());
+					deferredReleases.pop_back();
+					continue;
+				}
+				i++;
+			}
+		}
+		//run outside the lock so releases can defer more work
+		for (auto& release : ready) {
+			release();
+		}
+	}
+
 	vk::CommandBuffer NYRenderDevice::beginSingleTimeCommandBuffers(){
 		//utility function used to create single use command buffers 
 
@@ -263,16 +504,22 @@ namespace Nya {
 
 	void NYRenderDevice::endSingleTimeCommandBuffers(vk::CommandBuffer commandBuffer){
 		commandBuffer.end();
-		vk::SubmitInfo submitInfo;
-		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		
-		graphicsQueue.submit(1, &submitInfo, VK_NULL_HANDLE);
-		graphicsQueue.waitIdle();
+		//only waits for this submission instead of the whole queue, frames in flight keep going
+		waitForValue(submitGraphics(commandBuffer));
 
 		device.freeCommandBuffers(commandPool, 1, &commandBuffer);
 	}
 
+	uint64_t NYRenderDevice::submitSingleTimeCommandBuffers(vk::CommandBuffer commandBuffer, vk::Semaphore waitTimeline, uint64_t waitValue, vk::PipelineStageFlags waitStage){
+		commandBuffer.end();
+		uint64_t value = waitTimeline ? submitGraphics(commandBuffer, waitTimeline, waitStage, nullptr, waitValue) : submitGraphics(commandBuffer);
+
+		deferRelease(value, [this, commandBuffer]() {
+			device.freeCommandBuffers(commandPool, 1, &commandBuffer);
+		});
+		return value;
+	}
+
 	void NYRenderDevice::createImage(VkImage& Image, const VkImageCreateInfo& ImageInfo, const VmaAllocationCreateInfo& AllocInfo, VmaAllocation& Allocation){
 		auto result = vmaCreateImage(allocator, &ImageInfo, &AllocInfo, &Image, &Allocation, nullptr);
 		NYLogger::checkAssert(result == VK_SUCCESS, "Failed to create image");
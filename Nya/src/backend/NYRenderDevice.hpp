@@ -14,6 +14,9 @@ This class is supposed to the encapsulate the functionality of the following thi
 */
 
 namespace Nya {
+	class NYTextureStreamer;
+	class NYUploadContext;
+
 	class NYRenderDevice {
 	public:
 		NYRenderDevice(NYRenderDevice const&) = delete;
@@ -22,11 +25,15 @@ namespace Nya {
 		struct NYRenderDeviceCreateInfo {
 			const char* appName;
 			uint32_t appVersion;
+			//no window, surface or swapchain extension, rendering goes to offscreen targets and is never presented
+			//lets it run on machines without a display like ci boxes with a software implementation
+			bool headless = false;
+			//loaded on creation and written back on destruction, empty keeps the cache in memory only
+			const char* pipelineCachePath = "pipeline_cache.bin";
 		};
 
-		NYRenderDevice(NYRenderDeviceCreateInfo& _createInfo, NYWindow& _window);
-		/*taking a reference as i only need it to be valid during creation and wouldn't mind
-		it being invalid after creation when it runs out of scope*/
+		//the window can only be null for headless devices
+		NYRenderDevice(NYRenderDeviceCreateInfo& _createInfo, NYWindow* _window);
 		~NYRenderDevice();
 
 		//getters
@@ -35,15 +42,59 @@ namespace Nya {
 		VmaAllocator getAllocator() { return allocator; }
 		VkSurfaceKHR& getSurface() { return surface; }
 		vk::PhysicalDevice& getPhysicalDevice() { return physicalDevice; }
-		NYWindow& getWindow() { return window; }
+		NYWindow& getWindow();
+		bool isHeadless() { return headless; }
 		uint32_t getPresentQueueFamilyIndex() { return presentQueueFamilyIndex.value(); }
 		uint32_t getGraphicsQueueFamilyIndex() { return graphicsQueueFamilyIndex.value(); }
 		vk::Queue getGraphicsQueue() { return graphicsQueue; }
 		vk::Queue getPresentQueue() { return presentQueue; }
+		//a queue family that can only do transfers, gpus without one upload through the graphics queue
+		bool hasTransferQueue() { return transferQueueFamilyIndex.has_value(); }
+		uint32_t getTransferQueueFamilyIndex() { return transferQueueFamilyIndex.value(); }
+		vk::Queue getTransferQueue() { return transferQueue; }
+		//batches texture uploads onto the transfer queue, see NYTextureStreamer
+		NYTextureStreamer& getTextureStreamer();
+		//batches uploads on the graphics queue, the renderer submits it ahead of every frame
+		NYUploadContext& getUploadContext();
+		//features the device was created with, optional ones are only on if the gpu supports them
+		vk::PhysicalDeviceFeatures& getEnabledFeatures() { return enabledFeatures; }
+
+		//graphics queue timeline, every submission to the graphics queue goes through submitGraphics() and signals the next value
+		//of one timeline semaphore, so "is this work done" is always "has the timeline reached N"
+		//waitValues are for timeline wait semaphores, 0 for binary ones, and can be left empty when they're all binary
+		uint64_t submitGraphics(vk::ArrayProxy<const vk::CommandBuffer> const& commandBuffers,
+			vk::ArrayProxy<const vk::Semaphore> const& waitSemaphores = nullptr, vk::ArrayProxy<const vk::PipelineStageFlags> const& waitStages = nullptr,
+			vk::ArrayProxy<const vk::Semaphore> const& signalSemaphores = nullptr, vk::ArrayProxy<const uint64_t> const& waitValues = nullptr);
+		//presents share the submit lock since the present queue can be the graphics queue
+		//out of date and suboptimal are returned rather than treated as errors
+		vk::Result present(vk::PresentInfoKHR& presentInfo);
+		//value the latest submission will signal, 0 before anything is submitted
+		uint64_t getSubmittedValue() { return submittedValue; }
+		//doesn't block
+		bool isValueReached(uint64_t value);
+		void waitForValue(uint64_t value);
+		//runs release once the timeline reaches value, from the next collectReleases() after that
+		void deferRelease(uint64_t value, std::function<void()> release);
+		//runs every release whose value has been reached, the renderer calls it once a frame
+		void collectReleases();
+
+		//every pipeline in the engine is made through these so they all go through the device's pipeline cache
+		//safe to call from any thread, hot reloads build pipelines off the render thread
+		vk::Pipeline createGraphicsPipeline(vk::GraphicsPipelineCreateInfo& pipelineInfo);
+		vk::Pipeline createComputePipeline(vk::ComputePipelineCreateInfo& pipelineInfo);
+		//for pipelines made outside the engine, like imgui's
+		vk::PipelineCache getPipelineCache() { return pipelineCache; }
+		//logs how many pipelines were created and how long it took, with whether the cache was loaded from disk
+		void logPipelineStats();
 
 		//utilities
 		vk::CommandBuffer beginSingleTimeCommandBuffers();
+		//submits and waits for just this submission to finish
 		void endSingleTimeCommandBuffers(vk::CommandBuffer commandBuffer);
+		//submits without waiting, returns the value the work is done at, the command buffer is freed after that
+		//with a waitTimeline the gpu holds the submission at waitStage until that timeline reaches waitValue
+		uint64_t submitSingleTimeCommandBuffers(vk::CommandBuffer commandBuffer, vk::Semaphore waitTimeline = nullptr, uint64_t waitValue = 0,
+			vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands);
 		void createImage(VkImage& Image, const VkImageCreateInfo& ImageInfo, const VmaAllocationCreateInfo& AllocInfo, VmaAllocation& Allocation);
 	private:
 
@@ -55,6 +106,9 @@ namespace Nya {
 		void createDevice();
 		void createVmaAllocator();
 		void createCommandPool();
+		void createTimeline();
+		void createPipelineCache();
+		void savePipelineCache();
 
 		//check functions
 		bool checkLayers(std::vector<const char*> const& layers);
@@ -67,23 +121,52 @@ namespace Nya {
 		const char* engineName = "Nya";
 		const uint32_t enginerVer = VK_MAKE_VERSION(1, 0, 0);
 
-		//window class referenc
-		NYWindow& window;
+		//window class pointer, null when headless
+		NYWindow* window;
+		bool headless;
 
 		//private vulkan handles
 		vk::Instance instance;
 		vk::PhysicalDevice physicalDevice;
 		vk::Device device;
-		VkSurfaceKHR surface;
+		VkSurfaceKHR surface = VK_NULL_HANDLE;
 		vk::Queue graphicsQueue;
 		vk::Queue presentQueue;
+		vk::Queue transferQueue;
 		vk::CommandPool commandPool;
 
+		std::unique_ptr<NYUploadContext> uploadContext;
+		std::unique_ptr<NYTextureStreamer> textureStreamer;
+
+		std::string pipelineCachePath;
+		vk::PipelineCache pipelineCache;
+		//true if the cache was loaded from a file made by this device and driver
+		bool pipelineCacheWarm = false;
+		uint32_t pipelinesCreated = 0;
+		float pipelineCreationMillis = 0.0f;
+		std::mutex pipelineStatsMutex;
+
+		vk::Semaphore graphicsTimeline;
+		uint64_t submittedValue = 0;
+		//last value read back from the gpu, saves asking again for values already known to be reached
+		std::atomic<uint64_t> completedValue = 0;
+		std::mutex submitMutex;
+
+		struct DeferredRelease {
+			uint64_t value;
+			std::function<void()> release;
+		};
+		std::vector<DeferredRelease> deferredReleases;
+		std::mutex releaseMutex;
+
+		vk::PhysicalDeviceFeatures enabledFeatures;
+
 		//vulkan memory allocator
 		VmaAllocator allocator;
 
 		//necessary variables
 		std::optional<uint32_t> graphicsQueueFamilyIndex = 0;
 		std::optional<uint32_t> presentQueueFamilyIndex = 0;
+		std::optional<uint32_t> transferQueueFamilyIndex;
 	};
 }
@@ -29,7 +29,7 @@ namespace Nya {
 		attachments.push_back(attachment);
 	}
 
-	void NYRenderPass::addSubpass(std::vector<vk::AttachmentReference>& colorAttachments, std::vector<vk::AttachmentReference>& inputAttachments, vk::AttachmentReference* depthAttachment){
+	void NYRenderPass::addSubpass(std::vector<vk::AttachmentReference>& colorAttachments, std::vector<vk::AttachmentReference>& inputAttachments, vk::AttachmentReference* depthAttachment, std::vector<uint32_t>* preserveAttachments){
 		NYLogger::checkAssert(!built, "NYRenderPass can't be modified after it's built");
 
 		vk::SubpassDescription subpass;
@@ -42,6 +42,9 @@ namespace Nya {
 		if (depthAttachment != nullptr) {
 			subpass.setPDepthStencilAttachment(depthAttachment);
 		}
+		if (preserveAttachments != nullptr && preserveAttachments->size() != 0) {
+			subpass.setPreserveAttachments(*preserveAttachments);
+		}
 		subpasses.push_back(subpass);
 	}
 
@@ -62,18 +65,20 @@ namespace Nya {
 		built = true;
 	}
 
-	void NYRenderPass::begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, glm::vec4 clearColor){
-		NYLogger::checkAssert(built, "Can't begin render pass without building it");
-		vk::RenderPassBeginInfo renderPassBeginInfo;
-		renderPassBeginInfo.setFramebuffer(frameBuffer);
-		renderPassBeginInfo.setClearValueCount(1);
-
+	void NYRenderPass::begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, glm::vec4 clearColor, vk::SubpassContents contents){
 		vk::ClearValue clearValue;
 		std::array<float, 4> _color = { clearColor.x, clearColor.y, clearColor.z, clearColor.w };
 		vk::ClearColorValue clearColorVal(_color);
 		clearValue.color = clearColorVal;
-		std::array<vk::ClearValue, 1> clearValues = { clearValue };
+		std::vector<vk::ClearValue> clearValues = { clearValue };
+
+		begin(commandBuffer, frameBuffer, extent, clearValues, contents);
+	}
 
+	void NYRenderPass::begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, std::vector<vk::ClearValue>& clearValues, vk::SubpassContents contents) {
+		NYLogger::checkAssert(built, "Can't begin render pass without building it");
+		vk::RenderPassBeginInfo renderPassBeginInfo;
+		renderPassBeginInfo.setFramebuffer(frameBuffer);
 		renderPassBeginInfo.setClearValues(clearValues);
 		renderPassBeginInfo.setRenderPass(renderPass);
 
@@ -83,10 +88,15 @@ namespace Nya {
 
 		renderPassBeginInfo.setRenderArea(renderArea);
 
-		commandBuffer.beginRenderPass(renderPassBeginInfo, vk::SubpassContents::eInline);
+		commandBuffer.beginRenderPass(renderPassBeginInfo, contents);
 		start = true;
 	}
 
+	void NYRenderPass::nextSubpass(vk::CommandBuffer& commandBuffer, vk::SubpassContents contents) {
+		NYLogger::checkAssert(start, "Can't move to the next subpass without beginning the render pass");
+		commandBuffer.nextSubpass(contents);
+	}
+
 	void NYRenderPass::end(vk::CommandBuffer& commandBuffer) {
 		NYLogger::checkAssert(start, "Can't end a render pass without beginning it");
 		commandBuffer.endRenderPass();
@@ -17,11 +17,19 @@ namespace Nya {
 			return renderPass; }
 
 		void addAttachment(vk::Format format, vk::AttachmentLoadOp loadOp, vk::AttachmentStoreOp storeOp, vk::ImageLayout initialLayout, vk::ImageLayout finalLayout);
-		void addSubpass(std::vector<vk::AttachmentReference>& colorAttachments, std::vector<vk::AttachmentReference>& inputAttachments, vk::AttachmentReference* depthAttachment);
+		//the references are pointed to, not copied, so they must stay alive until build()
+		void addSubpass(std::vector<vk::AttachmentReference>& colorAttachments, std::vector<vk::AttachmentReference>& inputAttachments, vk::AttachmentReference* depthAttachment,
+			std::vector<uint32_t>* preserveAttachments = nullptr);
 		void addDependency(vk::SubpassDependency dependency);
 
 		void build();
-		void begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, glm::vec4 clearColor);
+		uint32_t getSubpassCount() { return static_cast<uint32_t>(subpasses.size()); }
+		void begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, glm::vec4 clearColor,
+			vk::SubpassContents contents = vk::SubpassContents::eInline);
+		//one clear value per attachment, the ones for attachments that aren't cleared are ignored
+		void begin(vk::CommandBuffer& commandBuffer, vk::Framebuffer frameBuffer, vk::Extent2D extent, std::vector<vk::ClearValue>& clearValues,
+			vk::SubpassContents contents = vk::SubpassContents::eInline);
+		void nextSubpass(vk::CommandBuffer& commandBuffer, vk::SubpassContents contents = vk::SubpassContents::eInline);
 		void end(vk::CommandBuffer& commandBuffer);
 
 	private:
@@ -1,14 +1,17 @@
 #include "pch.hpp"
 #include "NYRenderer.hpp"
+#include "NYTextureStreamer.hpp"
+#include "NYUploadContext.hpp"
 #include "systems/NYRenderingSystem.hpp"
 #include "logging/NYLogger.hpp"
 #include "utils/NYTimer.hpp"
 #include "glm/gtc/type_ptr.hpp"
 #include "defines.hpp"
+#include "utils/NYProfiler.hpp"
 
 namespace Nya {
-	NYRenderer::NYRenderer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain)
-		:renderDevice(_renderDevice), swapchain(_swapchain), deviceHandle(_renderDevice.getDevice()) {
+	NYRenderer::NYRenderer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain, NYThreadPool& _threadPool)
+		:renderDevice(_renderDevice), swapchain(_swapchain), threadPool(_threadPool), deviceHandle(_renderDevice.getDevice()) {
 		//create a separate command pool for all rendering commands
 		//make it resetable to reuse command buffers
 		vk::CommandPoolCreateInfo poolInfo(
@@ -25,6 +28,12 @@ namespace Nya {
 		commandBuffers = renderDevice.getDevice().allocateCommandBuffers(allocInfo);
 
 		createSyncObjects();
+		createWorkerCommandPools();
+
+		if (!renderDevice.isHeadless()) {
+			guiDevice = std::make_unique<NYGUIDevice>(renderDevice, swapchain);
+			shaderWatcher.start();
+		}
 	}
 
 	NYRenderer::~NYRenderer(){
@@ -32,34 +41,40 @@ namespace Nya {
 		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			deviceHandle.destroySemaphore(imageAvailableSemaphores[i]);
 			deviceHandle.destroySemaphore(renderFinishedSemaphores[i]);
-			deviceHandle.destroyFence(inFlightFences[i]);
 		}
-		
-		deviceHandle.destroyCommandPool(commandPool);
-	}
 
-	void NYRenderer::createOffscreenFramebufferResources()
-	{
+		//destroying a pool frees its command buffers
+		for (auto& worker : workerCommands) {
+			deviceHandle.destroyCommandPool(worker.pool);
+		}
+		deviceHandle.destroyCommandPool(commandPool);
 	}
 
 	void NYRenderer::createSyncObjects(){
 		imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
 		renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
 
+		//only acquire and present use binary semaphores, frame pacing waits on the render device's timeline
 		vk::SemaphoreCreateInfo semaphoreInfo;
-		vk::FenceCreateInfo fenceInfo;
-		fenceInfo.setFlags(vk::FenceCreateFlagBits::eSignaled);
 
 		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
 			imageAvailableSemaphores[i] = deviceHandle.createSemaphore(semaphoreInfo);
 			renderFinishedSemaphores[i] = deviceHandle.createSemaphore(semaphoreInfo);
-			inFlightFences[i] = deviceHandle.createFence(fenceInfo);
 		}
 
 
 	}
 
+	void NYRenderer::createWorkerCommandPools() {
+		//transient since everything in them is re-recorded every frame, they're reset whole instead of per buffer
+		vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eTransient, renderDevice.getGraphicsQueueFamilyIndex());
+
+		workerCommands.resize(MAX_FRAMES_IN_FLIGHT * threadPool.getWorkerCount());
+		for (auto& worker : workerCommands) {
+			worker.pool = deviceHandle.createCommandPool(poolInfo);
+		}
+	}
+
 	void NYRenderer::guiCalls(){
 
 		/*{
@@ -107,75 +122,224 @@ namespace Nya {
 
 		ImGui::Begin("Debug window");
 		ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+		//the resize callback picks this up, the swapchain is remade after this frame's present
+		bool fullscreen = renderDevice.getWindow().isFullscreen();
+		if (ImGui::Checkbox("Fullscreen", &fullscreen)) {
+			renderDevice.getWindow().setFullscreen(fullscreen);
+		}
+		for (auto& callback : debugCallbacks) {
+			callback();
+		}
+		gpuProfiler.drawDebugUI();
+#ifdef NY_ENABLE_PROFILING
+		if (ImGui::Button(NY_PROFILE_IS_CAPTURING() ? "Capturing CPU trace..." : "Capture CPU trace (120 frames)")) {
+			NY_PROFILE_CAPTURE(120, "nya_trace.json");
+		}
+#endif
 		ImGui::End();
 		ImGui::Render();
 	}
 
 	void NYRenderer::acquireImageIndex() {
-		deviceHandle.waitForFences(inFlightFences[currentFrame], true, UINT64_MAX);
-		deviceHandle.resetFences(1, &inFlightFences[currentFrame]);
+		NY_PROFILE_ZONE("acquire");
+		renderDevice.waitForValue(frameValues[currentFrame]);
 
+		//there's one offscreen image per frame in flight, so the wait above already guards it
+		if (swapchain.isHeadless()) {
+			imageIndex = currentFrame;
+			return;
+		}
 
 		vk::Result result = renderDevice.getDevice().acquireNextImageKHR(swapchain.getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
-		NYLogger::checkAssert(result == vk::Result::eSuccess, "Failed to acquire image from swapchain");
-	}
-
-	void NYRenderer::pushConstants(NYPipeline& pipeline ,void* pushData, uint32_t size) {
-		commandBuffers[currentFrame].pushConstants(pipeline.getLayout(), vk::ShaderStageFlagBits::eVertex, 0, size, pushData);
+		//nothing was signaled when out of date, so the same semaphore can be used on the new swapchain
+		while (result == vk::Result::eErrorOutOfDateKHR) {
+			recreateSwapchain();
+			result = renderDevice.getDevice().acquireNextImageKHR(swapchain.getSwapchain(), UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+		}
+		NYLogger::checkAssert(result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR, "Failed to acquire image from swapchain");
+		swapchainSuboptimal = result == vk::Result::eSuboptimalKHR;
 	}
 
+	void NYRenderer::recreateSwapchain() {
+		NY_PROFILE_ZONE("recreate swapchain");
+		NYWindow& window = renderDevice.getWindow();
+		while (window.isMinimized()) {
+			glfwWaitEvents();
+		}
+		//anything the resize flagged is covered by this recreate
+		window.consumeResize();
 
-	void NYRenderer::beginRenderPass(glm::vec4 color, NYPipeline& pipeline) {
-		acquireImageIndex();
+		//no wait idle, the old swapchain and the graph's old images are released once the frames using them finish
+		swapchain.recreate();
+		frameGraph.resize();
 
-		ImGui_ImplVulkan_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
-		ImGui::NewFrame();
+		vk::Extent2D extent = swapchain.getSwapchainExtent();
+		NYLogger::logInfo("swapchain recreated at %ux%u", extent.width, extent.height);
+	}
 
-		guiCalls();
+	void NYRenderer::beginFrame() {
+		NY_PROFILE_ZONE("begin frame");
+		NYLogger::checkAssert(frameGraph.isCompiled(), "NYRenderer::compileFrameGraph() must be called before the first frame");
+		acquireImageIndex();
+		renderDevice.collectReleases();
+		//textures whose copies finished are handed to the graphics queue ahead of this frame, the ones made since last frame go out as one batch
+		NYTextureStreamer& textureStreamer = renderDevice.getTextureStreamer();
+		textureStreamer.update();
+		textureStreamer.flush();
+		shaderWatcher.applyReloads();
+		frameRing.beginFrame(currentFrame);
+
+		//the wait covers the secondaries too, so the frame's worker pools are free again
+		uint32_t workerCount = threadPool.getWorkerCount();
+		for (uint32_t i = 0; i < workerCount; i++) {
+			WorkerCommands& worker = workerCommands[currentFrame * workerCount + i];
+			if (worker.usedSecondaries > 0) {
+				deviceHandle.resetCommandPool(worker.pool);
+				worker.usedSecondaries = 0;
+			}
+		}
 
 		commandBuffers[currentFrame].reset();
 		vk::CommandBufferBeginInfo cBeginInfo;
 		commandBuffers[currentFrame].begin(cBeginInfo);
 
-		pipeline.getRenderPass().begin(commandBuffers[currentFrame], swapchain.getFrameBuffer(imageIndex), swapchain.getSwapchainExtent(), glm::vec4(0.05f, 0.05f, 0.05f, 1.0f));
+		//picks up the timings of the last frame that used this slot, so the debug window below shows them
+		gpuProfiler.beginFrame(commandBuffers[currentFrame], currentFrame);
+		frameScope = gpuProfiler.beginScope(commandBuffers[currentFrame], "frame");
+
+		if (guiDevice) {
+			ImGui_ImplVulkan_NewFrame();
+			ImGui_ImplGlfw_NewFrame();
+			ImGui::NewFrame();
+
+			guiCalls();
+		}
 	}
 
-	void NYRenderer::bindPipeline(NYPipeline& pipeline) {
-		commandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline.getPipeline());
+	void NYRenderer::bindComputePipeline(NYComputePipeline& pipeline) {
+		commandBuffers[currentFrame].bindPipeline(vk::PipelineBindPoint::eCompute, pipeline.getPipeline());
 	}
 
-	void NYRenderer::draw(VkBuffer& vertexBuffer, VkBuffer& indexBuffer, NYPipeline& pipeline, uint32_t indexCount, vk::DescriptorSet& set) {
-		std::array<vk::Buffer, 1> vertexBuffers = { static_cast<vk::Buffer>(vertexBuffer) };
-		std::array<vk::DeviceSize, 1> offsets = { 0 };
-		commandBuffers[currentFrame].bindVertexBuffers(0, vertexBuffers, offsets);
-		commandBuffers[currentFrame].bindIndexBuffer(indexBuffer, 0, vk::IndexType::eUint32);
-		commandBuffers[currentFrame].bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeline.getLayout(), 0, 1, &set, 0, nullptr);
+	void NYRenderer::bindComputeDescriptorSet(NYComputePipeline& pipeline, vk::DescriptorSet& set, uint32_t setIndex, vk::ArrayProxy<const uint32_t> const& dynamicOffsets) {
+		commandBuffers[currentFrame].bindDescriptorSets(vk::PipelineBindPoint::eCompute, pipeline.getLayout(), setIndex, set, dynamicOffsets);
+	}
 
-		commandBuffers[currentFrame].drawIndexed(indexCount, 1, 0, 0, 0);
+	void NYRenderer::pushComputeConstants(NYComputePipeline& pipeline, void* pushData, uint32_t size) {
+		commandBuffers[currentFrame].pushConstants(pipeline.getLayout(), vk::ShaderStageFlagBits::eCompute, 0, size, pushData);
 	}
 
-	void NYRenderer::endRenderPass(NYPipeline& pipeline) {
-		pipeline.getRenderPass().end(commandBuffers[currentFrame]);
-		guiDevice.recordCommands(commandBuffers[currentFrame], pipeline, imageIndex);
-		commandBuffers[currentFrame].end();
-		
-		submitCommands();
+	void NYRenderer::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) {
+		commandBuffers[currentFrame].dispatch(groupCountX, groupCountY, groupCountZ);
+	}
 
-		vk::PresentInfoKHR presentInfo;
-		presentInfo.setPSwapchains(&swapchain.getSwapchain());
-		presentInfo.setSwapchainCount(1);
-		presentInfo.setWaitSemaphoreCount(1);
-		presentInfo.setPWaitSemaphores(&renderFinishedSemaphores[currentFrame]);
-		presentInfo.setPImageIndices(&imageIndex);
+	void NYRenderer::computeToDrawBarrier() {
+		vk::MemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead;
 
-		presentQueue.presentKHR(presentInfo);
+		commandBuffers[currentFrame].pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+			vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+			vk::DependencyFlags(), barrier, nullptr, nullptr);
+	}
+
+	NYFrameGraph::Pass NYRenderer::addGUIPass(NYFrameGraph::Resource target) {
+		if (!guiDevice) {
+			return UINT32_MAX;
+		}
+		guiPass = frameGraph.addPass("gui", [this](NYFrameGraph::PassContext& context) {
+			guiDevice->recordCommands(context.commandBuffer);
+		});
+		frameGraph.writeColor(guiPass, target);
+		return guiPass;
+	}
+
+	void NYRenderer::compileFrameGraph() {
+		NYLogger::checkAssert(!guiDevice || guiPass != UINT32_MAX, "NYRenderer::addGUIPass() must be called before the frame graph is compiled");
+		frameGraph.compile();
+		if (guiDevice) {
+			guiDevice->init(frameGraph.getRenderPass(guiPass).getRenderpass(), frameGraph.getSubpass(guiPass));
+		}
+	}
+
+	void NYRenderer::executeFrameGraph() {
+		NY_PROFILE_ZONE("record");
+		frameGraph.execute(commandBuffers[currentFrame], imageIndex, &gpuProfiler);
+	}
+
+	NYCommandList NYRenderer::beginSecondary(uint32_t workerIndex, NYFrameGraph::PassContext& context) {
+		NYLogger::checkAssert(workerIndex < threadPool.getWorkerCount(), "NYRenderer::beginSecondary() called with an invalid worker index");
+		WorkerCommands& worker = workerCommands[currentFrame * threadPool.getWorkerCount() + workerIndex];
+
+		//buffers are kept across frames and only allocated when a worker needs more than it ever had
+		if (worker.usedSecondaries == worker.secondaries.size()) {
+			vk::CommandBufferAllocateInfo allocInfo(worker.pool, vk::CommandBufferLevel::eSecondary, 1);
+			worker.secondaries.push_back(deviceHandle.allocateCommandBuffers(allocInfo)[0]);
+		}
+		vk::CommandBuffer secondary = worker.secondaries[worker.usedSecondaries++];
+
+		vk::CommandBufferInheritanceInfo inheritanceInfo;
+		inheritanceInfo.renderPass = context.renderPass;
+		inheritanceInfo.subpass = context.subpass;
+		inheritanceInfo.framebuffer = context.framebuffer;
+
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+		secondary.begin(beginInfo);
+
+		return NYCommandList(secondary, context.extent);
+	}
+
+	void NYRenderer::endSecondary(NYCommandList& commandList) {
+		commandList.getCommandBuffer().end();
+	}
+
+	void NYRenderer::executeSecondaries(NYFrameGraph::PassContext& context, std::vector<vk::CommandBuffer>& secondaries) {
+		if (!secondaries.empty()) {
+			context.commandBuffer.executeCommands(secondaries);
+		}
+	}
+
+	void NYRenderer::endFrame() {
+		gpuProfiler.endScope(commandBuffers[currentFrame], frameScope);
+		commandBuffers[currentFrame].end();
+		frameRing.flushFrame();
+
+		//everything uploaded through the graphics context so far goes out in one submission ahead of the frame that may sample it
+		renderDevice.getUploadContext().submit();
+		submitCommands();
+		frameRing.frameSubmitted(frameValues[currentFrame]);
+		lastImageIndex = imageIndex;
+
+		//nothing to present to when headless
+		if (!swapchain.isHeadless()) {
+			NY_PROFILE_ZONE("present");
+			vk::PresentInfoKHR presentInfo;
+			presentInfo.setPSwapchains(&swapchain.getSwapchain());
+			presentInfo.setSwapchainCount(1);
+			presentInfo.setWaitSemaphoreCount(1);
+			presentInfo.setPWaitSemaphores(&renderFinishedSemaphores[currentFrame]);
+			presentInfo.setPImageIndices(&imageIndex);
+
+			vk::Result result = renderDevice.present(presentInfo);
+			NYLogger::checkAssert(result == vk::Result::eSuccess || result == vk::Result::eSuboptimalKHR || result == vk::Result::eErrorOutOfDateKHR, "Failed to present swapchain image");
+			if (result != vk::Result::eSuccess || swapchainSuboptimal || renderDevice.getWindow().consumeResize()) {
+				recreateSwapchain();
+			}
+		}
 
 		currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		NY_PROFILE_FRAME();
 	}
 
 	void NYRenderer::submitCommands(){
-		vk::SubmitInfo submitInfo;
+		NY_PROFILE_ZONE("submit");
+		//nothing to wait on or hand to a present when headless, the timeline is all that's needed
+		if (swapchain.isHeadless()) {
+			frameValues[currentFrame] = renderDevice.submitGraphics(commandBuffers[currentFrame]);
+			lastFrameValue = frameValues[currentFrame];
+			return;
+		}
 
 		//each semaphore in this array will be signaled when the corresponding stage in waitStages with the sameIndex is completed
 		std::array<vk::Semaphore, 1> waitSemaphores = { imageAvailableSemaphores[currentFrame]};
@@ -183,11 +347,59 @@ namespace Nya {
 		//signal semaphores are signaled when command buffers have completed execution and the rendering is complete
 		std::array<vk::Semaphore, 1> signalSemaphores = { renderFinishedSemaphores[currentFrame]};
 
-		submitInfo.setPWaitDstStageMask(waitStages.data());
-		submitInfo.setWaitSemaphores(waitSemaphores);
-		submitInfo.setCommandBuffers(commandBuffers[currentFrame]);
-		submitInfo.setSignalSemaphores(signalSemaphores);
+		frameValues[currentFrame] = renderDevice.submitGraphics(commandBuffers[currentFrame], waitSemaphores, waitStages, signalSemaphores);
+		lastFrameValue = frameValues[currentFrame];
+	}
 
-		graphicsQueue.submit(1, &submitInfo, inFlightFences[currentFrame]);
+	void NYRenderer::readback(std::vector<uint8_t>& pixels) {
+		NY_PROFILE_ZONE("readback");
+		NYLogger::checkAssert(swapchain.isHeadless(), "NYRenderer::readback() is only supported headless");
+		NYLogger::checkAssert(lastImageIndex != UINT32_MAX, "NYRenderer::readback() called before a frame was submitted");
+
+		vk::Extent2D extent = swapchain.getSwapchainExtent();
+		vk::DeviceSize size = static_cast<vk::DeviceSize>(extent.width) * extent.height * 4;
+
+		vk::BufferCreateInfo bufferInfo;
+		bufferInfo.size = size;
+		bufferInfo.usage = vk::BufferUsageFlagBits::eTransferDst;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+		auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		VkBuffer buffer;
+		VmaAllocation allocation;
+		VmaAllocationInfo allocationInfo;
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &buffer, &allocation, &allocationInfo);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create readback buffer");
+
+		//the frame graph leaves the image in transfer src layout and its render pass orders that transition before transfers,
+		//so this only has to wait for the color writes
+		vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
+		vk::ImageMemoryBarrier barrier;
+		barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+		barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+		barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+		barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = swapchain.getImage(lastImageIndex);
+		barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+		vk::BufferImageCopy region;
+		region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+		region.imageExtent = vk::Extent3D(extent.width, extent.height, 1);
+		commandBuffer.copyImageToBuffer(swapchain.getImage(lastImageIndex), vk::ImageLayout::eTransferSrcOptimal, vk::Buffer(buffer), region);
+		//the copy comes after the frame on the same queue, so waiting for it covers the frame too
+		renderDevice.endSingleTimeCommandBuffers(commandBuffer);
+
+		vmaInvalidateAllocation(renderDevice.getAllocator(), allocation, 0, VK_WHOLE_SIZE);
+		pixels.resize(size);
+		memcpy(pixels.data(), allocationInfo.pMappedData, size);
+		vmaDestroyBuffer(renderDevice.getAllocator(), buffer, allocation);
 	}
 }
\ No newline at end of file
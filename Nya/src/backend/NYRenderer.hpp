@@ -3,11 +3,19 @@
 #include "NYRenderDevice.hpp"
 #include "NYSwapchain.hpp"
 #include "NYPipeline.hpp"
+#include "NYComputePipeline.hpp"
+#include "NYFrameRingBuffer.hpp"
+#include "NYCommandList.hpp"
+#include "NYFrameGraph.hpp"
+#include "NYGPUProfiler.hpp"
 #include "NYTexture.hpp"
 #include "NYDescriptorSetLayout.hpp"
 #include "NYShader.hpp"
+#include "NYShaderWatcher.hpp"
+#include "NYPipelineLibrary.hpp"
 #include "game/NYSprite.hpp"
 #include "GUI/NYGUIDevice.hpp"
+#include "utils/NYThreadPool.hpp"
 
 namespace Nya {
 	class NYRenderer {
@@ -16,43 +24,126 @@ namespace Nya {
 		NYRenderer(NYRenderer const&) = delete;
 		NYRenderer& operator=(NYRenderer const&) = delete;
 
-		NYRenderer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain);
+		NYRenderer(NYRenderDevice& _renderDevice, NYSwapchain& _swapchain, NYThreadPool& _threadPool);
 		~NYRenderer();
 
 		uint32_t getFrameIndex() { return  currentFrame; }
-		
-		void beginRenderPass(glm::vec4 clearColor, NYPipeline& pipeline);
-		void bindPipeline(NYPipeline& pipeline);
-		void pushConstants(NYPipeline& pipeline, void* pushData, uint32_t size);
-		void draw(VkBuffer& vertexBuffer, VkBuffer& indexBuffer,  NYPipeline& pipeline, uint32_t indexCount, vk::DescriptorSet& set);
-		void endRenderPass(NYPipeline& pipeline);
+		//graphics timeline value the last endFrame() submitted, anything recorded in that frame is done once it's reached
+		uint64_t getLastFrameValue() { return lastFrameValue; }
+		//doesn't block, works for any value handed out by the render device
+		bool isValueReached(uint64_t value) { return renderDevice.isValueReached(value); }
+		//workers that record secondary command buffers run on this
+		NYThreadPool& getThreadPool() { return threadPool; }
+		//dynamic per frame data goes in here, it's reset in beginFrame() and flushed in endFrame()
+		NYFrameRingBuffer& getFrameRing() { return frameRing; }
+
+		//render passes are declared through the frame graph, see addGUIPass() and compileFrameGraph()
+		NYFrameGraph& getFrameGraph() { return frameGraph; }
+		//the gui draws over target, add it after every other pass writing target so it ends up on top
+		//headless renderers have no gui, nothing is added and UINT32_MAX is returned
+		NYFrameGraph::Pass addGUIPass(NYFrameGraph::Resource target);
+		//compiles the graph and sets up the gui for the subpass it ended up in, must be called before the first frame
+		void compileFrameGraph();
+
+		//a frame is beginFrame(), any compute work, then executeFrameGraph(), then endFrame()
+		//beginFrame() waits until the gpu is done with the frame that last used the slot, so per frame resources
+		//are free to overwrite after it returns
+		void beginFrame();
+		void endFrame();
+
+		//timestamps for the frame, render passes are timed by the frame graph and the whole frame by the renderer
+		NYGPUProfiler& getGPUProfiler() { return gpuProfiler; }
+		//scopes on the frame's primary command buffer, secondaries go through the profiler directly
+		uint32_t beginGPUScope(const char* name) { return gpuProfiler.beginScope(commandBuffers[currentFrame], name); }
+		void endGPUScope(uint32_t scope) { gpuProfiler.endScope(commandBuffers[currentFrame], scope); }
+
+		//compute work has to be recorded outside of the render pass
+		void bindComputePipeline(NYComputePipeline& pipeline);
+		void bindComputeDescriptorSet(NYComputePipeline& pipeline, vk::DescriptorSet& set, uint32_t setIndex,
+			vk::ArrayProxy<const uint32_t> const& dynamicOffsets = nullptr);
+		void pushComputeConstants(NYComputePipeline& pipeline, void* pushData, uint32_t size);
+		void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+		//makes compute shader writes visible to indirect draws and vertex input of the following render pass
+		void computeToDrawBarrier();
+
+		//records every pass of the frame graph, each pass records into the context it's given
+		void executeFrameGraph();
+		vk::Extent2D getExtent() { return swapchain.getSwapchainExtent(); }
+
+		//parallel recording, a worker thread records part of a pass into secondary buffers from its own pool
+		//workerIndex is the one given by NYThreadPool::parallelFor(), the secondaries continue the context's subpass
+		//and inherit no state, so everything they use has to be bound again
+		//the pass has to be set to eSecondaryCommandBuffers contents in the frame graph
+		NYCommandList beginSecondary(uint32_t workerIndex, NYFrameGraph::PassContext& context);
+		void endSecondary(NYCommandList& commandList);
+		//runs the secondaries in the given order inside the context's subpass
+		void executeSecondaries(NYFrameGraph::PassContext& context, std::vector<vk::CommandBuffer>& secondaries);
+
+		//headless only, waits for the last submitted frame and copies its image into pixels
+		//tightly packed rows in the swapchain's format, 4 bytes per pixel
+		void readback(std::vector<uint8_t>& pixels);
+
+		//pipelines watched here are rebuilt when their glsl changes and swapped in at the start of a frame
+		//headless renderers never start watching
+		NYShaderWatcher& getShaderWatcher() { return shaderWatcher; }
+		//graphics pipelines are requested from here and compiled in the background, they're hot reloaded through the watcher
+		NYPipelineLibrary& getPipelineLibrary() { return pipelineLibrary; }
+
+		//callbacks are called inside the debug window every frame, so systems can show their own stats and toggles
+		void addDebugCallback(std::function<void()> callback) { debugCallbacks.push_back(callback); }
 	private:
 		uint32_t currentFrame = 0;
 		uint32_t imageIndex = 0;
+		//image the last endFrame() submitted, UINT32_MAX before the first one
+		uint32_t lastImageIndex = UINT32_MAX;
+		//the acquire said the swapchain still works but no longer matches the surface, it's remade after the present
+		bool swapchainSuboptimal = false;
 
-		void createOffscreenFramebufferResources();
 		void createSyncObjects();
+		void createWorkerCommandPools();
 		void guiCalls();
 
 		void acquireImageIndex();
 		void submitCommands();
+		//remakes the swapchain and everything sized by it, waits out minimization first since a 0x0 swapchain can't exist
+		void recreateSwapchain();
 
 		NYRenderDevice& renderDevice;
 		NYSwapchain& swapchain;
+		NYThreadPool& threadPool;
 
-		NYGUIDevice guiDevice{ renderDevice, swapchain };
+		//null when headless
+		std::unique_ptr<NYGUIDevice> guiDevice;
+		NYFrameRingBuffer frameRing{ renderDevice };
+		NYGPUProfiler gpuProfiler{ renderDevice };
+		uint32_t frameScope = UINT32_MAX;
+		NYFrameGraph frameGraph{ renderDevice, swapchain };
+		NYFrameGraph::Pass guiPass = UINT32_MAX;
+		NYShaderWatcher shaderWatcher{ renderDevice };
+		NYPipelineLibrary pipelineLibrary{ renderDevice, shaderWatcher };
 
 		//getting these handles beforehand for that lil bit of extra performance
 		vk::Device& deviceHandle;
-		const vk::Queue& graphicsQueue = renderDevice.getGraphicsQueue();
-		const vk::Queue& presentQueue = renderDevice.getPresentQueue();
 
 		//renderer resources
 		vk::CommandPool commandPool;
 		std::vector<vk::CommandBuffer> commandBuffers;
 		std::vector<vk::Semaphore> imageAvailableSemaphores;
 		std::vector<vk::Semaphore> renderFinishedSemaphores;
-		std::vector<vk::Fence> inFlightFences;
-		
+		//timeline value each frame slot was last submitted with, waited on before the slot is reused
+		std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> frameValues{};
+		uint64_t lastFrameValue = 0;
+
+		//one pool per worker per frame in flight so workers never share a pool and a frame's pools
+		//can be reset as a whole once its fence is signaled, indexed frame * workerCount + worker
+		struct WorkerCommands {
+			vk::CommandPool pool;
+			std::vector<vk::CommandBuffer> secondaries;
+			uint32_t usedSecondaries = 0;
+		};
+		std::vector<WorkerCommands> workerCommands;
+
+		std::vector<std::function<void()>> debugCallbacks;
+
 	};
 }
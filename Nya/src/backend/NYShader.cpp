@@ -1,105 +1,105 @@
 #include "pch.hpp"
 #include "NYShader.hpp"
+#include "NYShaderCompiler.hpp"
 #include "logging/NYLogger.hpp"
-#include <sstream>
 
 namespace Nya {
 	NYShader::NYShader(NYRenderDevice& _renderDevice, std::string _vertexFilepath, std::string _fragmentFilepath)
 		:renderDevice(_renderDevice), fragmentFilepath(_fragmentFilepath), vertexFilepath(_vertexFilepath) {
 		compileShader();
-		readShader();
+		createModule();
+	}
+
+	NYShader::NYShader(NYRenderDevice& _renderDevice, std::string _computeFilepath)
+		:renderDevice(_renderDevice), computeFilepath(_computeFilepath) {
+		compute = true;
+		compileShader();
 		createModule();
 	}
 
 	NYShader::~NYShader(){
+		if (compute) {
+			renderDevice.getDevice().destroyShaderModule(computeShaderModule);
+			return;
+		}
 		renderDevice.getDevice().destroyShaderModule(vertexShaderModule);
 		renderDevice.getDevice().destroyShaderModule(fragmentShaderModule);
 	}
 
-	void NYShader::compileShader(){
-		//compile shader
-		std::filesystem::path workingDir = std::filesystem::current_path();
-		std::string shaderDir = workingDir.generic_string() + "/src/shaders";
-
-		std::filesystem::path shaderPath(shaderDir);
-
-		//kind of pointless but just in case
-		if (!std::filesystem::exists(shaderPath)) {
-			std::filesystem::create_directory(shaderPath);
+	std::vector<std::string> NYShader::getSourcePaths(){
+		if (compute) {
+			return { computeFilepath };
 		}
+		return { vertexFilepath, fragmentFilepath };
+	}
 
-		//vertex shader
-		std::stringstream vertexStream(vertexFilepath);
-		std::string segment;
-		std::vector<std::string> segments;
-
-		while (std::getline(vertexStream, segment, '/')) {
-			segments.push_back(segment);
+	bool NYShader::compileModules(Modules& modules){
+		if (compute) {
+			std::vector<uint32_t> computeSpirv;
+			if (!NYShaderCompiler::getSpirv({ computeFilepath }, computeSpirv)) {
+				return false;
+			}
+			modules.compute = createStageModule(computeSpirv);
+			return true;
 		}
-
-		std::string shaderName = segments.back();
-
-		vertexSpvPath = shaderDir + "/" + shaderName + ".spv";
-
-		std::string command = shaderDir + "/glslc.exe " + shaderDir + "/" + shaderName + " -o " + vertexSpvPath;
-		system(command.c_str());
-
-		segments.clear();
-		segment.clear();
-		//fragment shader
-		std::stringstream fragStream(fragmentFilepath);
-
-		while (std::getline(fragStream, segment, '/')) {
-			segments.push_back(segment);
+		std::vector<uint32_t> vertexSpirv;
+		std::vector<uint32_t> fragmentSpirv;
+		if (!NYShaderCompiler::getSpirv({ vertexFilepath }, vertexSpirv) || !NYShaderCompiler::getSpirv({ fragmentFilepath }, fragmentSpirv)) {
+			return false;
 		}
-
-		shaderName = segments.back();
-
-		fragmentSpvPath = shaderDir + "/" + shaderName + ".spv";
-
-		command = shaderDir + "/glslc.exe " + shaderDir + "/" + shaderName + " -o " + fragmentSpvPath;
-		system(command.c_str());
+		modules.vertex = createStageModule(vertexSpirv);
+		modules.fragment = createStageModule(fragmentSpirv);
+		return true;
 	}
 
-	void NYShader::readShader(){
-		std::ifstream vertFile(vertexSpvPath, std::ios::ate | std::ios::binary);
-		NYLogger::checkAssert(vertFile.is_open(), "Failed to read shader");
-
-		size_t fileSize = vertFile.tellg();
-		vertexBinary.resize(fileSize);
-		vertFile.seekg(0);
-		vertFile.read(vertexBinary.data(), fileSize);
-
-		vertFile.close();
+	void NYShader::replaceModules(Modules& modules){
+		std::lock_guard<std::mutex> lock(moduleMutex);
+		Modules oldModules{ vertexShaderModule, fragmentShaderModule, computeShaderModule };
+		destroyModules(oldModules);
+		vertexShaderModule = modules.vertex;
+		fragmentShaderModule = modules.fragment;
+		computeShaderModule = modules.compute;
+	}
 
-		std::ifstream fragFile(fragmentSpvPath, std::ios::ate | std::ios::binary);
-		NYLogger::checkAssert(fragFile.is_open(), "Failed to read shader");
+	void NYShader::destroyModules(Modules& modules){
+		//destroying a null module is a no-op, so unused stages don't need checking
+		renderDevice.getDevice().destroyShaderModule(modules.vertex);
+		renderDevice.getDevice().destroyShaderModule(modules.fragment);
+		renderDevice.getDevice().destroyShaderModule(modules.compute);
+		modules = Modules();
+	}
 
-		fileSize = fragFile.tellg();
-		fragmentBinary.resize(fileSize);
-		fragFile.seekg(0);
-		fragFile.read(fragmentBinary.data(), fileSize);
+	void NYShader::compileShader(){
+		if (compute) {
+			compileStage(computeFilepath, computeBinary);
+			return;
+		}
+		compileStage(vertexFilepath, vertexBinary);
+		compileStage(fragmentFilepath, fragmentBinary);
+	}
 
-		fragFile.close();
+	void NYShader::compileStage(std::string& filepath, std::vector<uint32_t>& binary){
+		bool compiled = NYShaderCompiler::getSpirv({ filepath }, binary);
+		NYLogger::checkAssert(compiled, "Failed to compile shader");
 	}
 
 	void NYShader::createModule(){
-		VkShaderModuleCreateInfo vertexShaderModuleInfo{};
-		vertexShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		vertexShaderModuleInfo.codeSize = vertexBinary.size();
-		vertexShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(vertexBinary.data());
-
-		vk::ShaderModuleCreateInfo vertexModuleInfo = static_cast<vk::ShaderModuleCreateInfo>(vertexShaderModuleInfo);
-
-		vertexShaderModule = renderDevice.getDevice().createShaderModule(vertexModuleInfo);
+		if (compute) {
+			computeShaderModule = createStageModule(computeBinary);
+			return;
+		}
+		vertexShaderModule = createStageModule(vertexBinary);
+		fragmentShaderModule = createStageModule(fragmentBinary);
+	}
 
-		VkShaderModuleCreateInfo fragmentShaderModuleInfo{};
-		fragmentShaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		fragmentShaderModuleInfo.codeSize = fragmentBinary.size();
-		fragmentShaderModuleInfo.pCode = reinterpret_cast<uint32_t*>(fragmentBinary.data());
+	vk::ShaderModule NYShader::createStageModule(std::vector<uint32_t>& binary){
+		VkShaderModuleCreateInfo shaderModuleInfo{};
+		shaderModuleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleInfo.codeSize = binary.size() * sizeof(uint32_t);
+		shaderModuleInfo.pCode = binary.data();
 
-		vk::ShaderModuleCreateInfo fragmentModuleInfo = static_cast<vk::ShaderModuleCreateInfo>(fragmentShaderModuleInfo);
+		vk::ShaderModuleCreateInfo moduleInfo = static_cast<vk::ShaderModuleCreateInfo>(shaderModuleInfo);
 
-		fragmentShaderModule = renderDevice.getDevice().createShaderModule(fragmentModuleInfo);
+		return renderDevice.getDevice().createShaderModule(moduleInfo);
 	}
 }
\ No newline at end of file
@@ -15,6 +15,8 @@ namespace Nya {
 	class NYShader {
 	public:
 		NYShader(NYRenderDevice& _renderDevice, std::string _vertexFilepath, std::string _fragmentFilepath);
+		//compute shaders only have the one stage
+		NYShader(NYRenderDevice& _renderDevice, std::string _computeFilepath);
 		~NYShader();
 
 		NYShader(NYShader const&) = delete;
@@ -22,24 +24,50 @@ namespace Nya {
 
 		inline vk::ShaderModule& getVertexModule() { return vertexShaderModule; }
 		inline vk::ShaderModule& getFragmentModule() { return fragmentShaderModule; }
+		inline vk::ShaderModule& getComputeModule() { return computeShaderModule; }
+		inline bool isCompute() { return compute; }
+		//the glsl files the stages are compiled from, without their includes
+		std::vector<std::string> getSourcePaths();
+
+		//hot reload, compileModules() builds modules from the current sources without touching the ones in use
+		//and is safe to call off the render thread, replaceModules() swaps them in between frames
+		struct Modules {
+			vk::ShaderModule vertex;
+			vk::ShaderModule fragment;
+			vk::ShaderModule compute;
+		};
+		//false if any stage fails to compile, nothing is created then
+		bool compileModules(Modules& modules);
+		//the old modules are destroyed, pipelines already made from them don't need them anymore
+		void replaceModules(Modules& modules);
+		//held while building a pipeline from the current modules, pipelines can be built off the render thread
+		//while a reload replaces them
+		std::unique_lock<std::mutex> lockModules() { return std::unique_lock<std::mutex>(moduleMutex); }
+		void destroyModules(Modules& modules);
 
 	private:
 		void compileShader();
-		void readShader();
 		void createModule();
 
+		//per stage helpers, the spir-v comes out of NYShaderCompiler's cache and is only compiled when the source changed
+		void compileStage(std::string& filepath, std::vector<uint32_t>& binary);
+		vk::ShaderModule createStageModule(std::vector<uint32_t>& binary);
+
 		NYRenderDevice& renderDevice;
 
+		bool compute = false;
+
 		std::string vertexFilepath;
 		std::string fragmentFilepath;
-
-		std::string vertexSpvPath;
-		std::string fragmentSpvPath;
+		std::string computeFilepath;
 
 		vk::ShaderModule vertexShaderModule;
 		vk::ShaderModule fragmentShaderModule;
+		vk::ShaderModule computeShaderModule;
+		std::mutex moduleMutex;
 
-		std::vector<char> vertexBinary;
-		std::vector<char> fragmentBinary;
+		std::vector<uint32_t> vertexBinary;
+		std::vector<uint32_t> fragmentBinary;
+		std::vector<uint32_t> computeBinary;
 	};
 }
@@ -0,0 +1,288 @@
+#include "pch.hpp"
+#include "NYShaderCompiler.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+#include "utils/NYHash.hpp"
+#include <shaderc/shaderc.hpp>
+
+namespace Nya {
+	namespace {
+		//bump when anything about how the cache is keyed or stored changes
+		const uint32_t cacheVersion = 1;
+		const uint32_t spirvMagic = 0x07230203;
+
+		const shaderc_env_version targetEnv = shaderc_env_version_vulkan_1_2;
+		const shaderc_optimization_level optimizationLevel = shaderc_optimization_level_performance;
+#ifdef NY_DEBUG
+		const bool debugInfo = true;
+#else
+		const bool debugInfo = false;
+#endif
+
+		//compiles can run on any number of threads at once through the one compiler
+		shaderc::Compiler& getCompiler() {
+			static shaderc::Compiler compiler;
+			return compiler;
+		}
+
+		bool readText(const std::string& path, std::string& text) {
+			std::ifstream file(path, std::ios::binary);
+			if (!file.is_open()) {
+				return false;
+			}
+			text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+			return true;
+		}
+
+		//includes are looked up next to the file asking for them, the same way for hashing and compiling
+		std::string resolveInclude(const std::string& requestingSource, const std::string& requestedSource) {
+			return (std::filesystem::path(requestingSource).parent_path() / requestedSource).generic_string();
+		}
+
+		//calls visit(path, text) for everything the text pulls in with #include, recursively and each file once
+		//includes that can't be opened are visited with empty text, the compile they lead to fails either way
+		void forEachInclude(const std::string& filepath, const std::string& text, std::set<std::string>& visited,
+			const std::function<void(const std::string&, const std::string&)>& visit) {
+			size_t lineStart = 0;
+			while (lineStart < text.size()) {
+				size_t lineEnd = text.find('\n', lineStart);
+				if (lineEnd == std::string::npos) {
+					lineEnd = text.size();
+				}
+				size_t i = text.find_first_not_of(" \t", lineStart);
+				if (i < lineEnd && text[i] == '#') {
+					i = text.find_first_not_of(" \t", i + 1);
+					if (i < lineEnd && text.compare(i, 7, "include") == 0) {
+						size_t open = text.find_first_of("\"<", i + 7);
+						size_t close = open < lineEnd ? text.find_first_of("\">", open + 1) : std::string::npos;
+						if (close < lineEnd) {
+							std::string includePath = resolveInclude(filepath, text.substr(open + 1, close - open - 1));
+							if (visited.insert(includePath).second) {
+								std::string includeText;
+								readText(includePath, includeText);
+								visit(includePath, includeText);
+								forEachInclude(includePath, includeText, visited, visit);
+							}
+						}
+					}
+				}
+				lineStart = lineEnd + 1;
+			}
+		}
+
+		bool getShaderKind(const std::string& filepath, shaderc_shader_kind& kind) {
+			std::string extension = std::filesystem::path(filepath).extension().string();
+			if (extension == ".vert") { kind = shaderc_vertex_shader; }
+			else if (extension == ".frag") { kind = shaderc_fragment_shader; }
+			else if (extension == ".comp") { kind = shaderc_compute_shader; }
+			else if (extension == ".geom") { kind = shaderc_geometry_shader; }
+			else if (extension == ".tesc") { kind = shaderc_tess_control_shader; }
+			else if (extension == ".tese") { kind = shaderc_tess_evaluation_shader; }
+			else { return false; }
+			return true;
+		}
+
+		class Includer : public shaderc::CompileOptions::IncluderInterface {
+		public:
+			shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override {
+				Include* include = new Include;
+				include->name = resolveInclude(requestingSource, requestedSource);
+				if (!readText(include->name, include->content)) {
+					//an empty name tells shaderc the include failed, the content is the error it reports
+					include->content = "couldn't open " + include->name;
+					include->name.clear();
+				}
+				include->result.source_name = include->name.c_str();
+				include->result.source_name_length = include->name.size();
+				include->result.content = include->content.c_str();
+				include->result.content_length = include->content.size();
+				include->result.user_data = include;
+				return &include->result;
+			}
+
+			void ReleaseInclude(shaderc_include_result* data) override {
+				delete static_cast<Include*>(data->user_data);
+			}
+
+		private:
+			struct Include {
+				std::string name;
+				std::string content;
+				shaderc_include_result result{};
+			};
+		};
+	}
+
+	bool NYShaderCompiler::getSpirv(const Source& source, std::vector<uint32_t>& spirv){
+		NY_PROFILE_ZONE("get spirv");
+		spirv.clear();
+		std::string text;
+		if (!readText(source.filepath, text)) {
+			NYLogger::logWarning("couldn't read shader %s", source.filepath.c_str());
+			failures++;
+			return false;
+		}
+
+		std::string cachePath;
+		if (!cacheDirectory.empty()) {
+			char name[32];
+			snprintf(name, sizeof(name), "%016llx.spv", static_cast<unsigned long long>(hashSource(source, text)));
+			cachePath = cacheDirectory + "/" + name;
+			if (readCached(cachePath, spirv)) {
+				cacheHits++;
+				return true;
+			}
+		}
+
+		if (!compile(source, text, spirv)) {
+			failures++;
+			return false;
+		}
+		if (!cachePath.empty()) {
+			writeCached(cachePath, spirv);
+		}
+		return true;
+	}
+
+	void NYShaderCompiler::compileAll(const std::vector<Source>& sources, NYThreadPool& threadPool){
+		NY_PROFILE_ZONE("compile shaders");
+		auto start = std::chrono::steady_clock::now();
+		uint32_t compilesBefore = compiles;
+		threadPool.parallelFor(static_cast<uint32_t>(sources.size()), [&](uint32_t taskIndex, uint32_t workerIndex) {
+			std::vector<uint32_t> spirv;
+			getSpirv(sources[taskIndex], spirv);
+		});
+		double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		NYLogger::logInfo("%zu shaders ready in %.2f ms, %u compiled", sources.size(), millis, compiles - compilesBefore);
+	}
+
+	void NYShaderCompiler::getDependencies(const std::string& filepath, std::vector<std::string>& files){
+		files.push_back(filepath);
+		std::string text;
+		if (!readText(filepath, text)) {
+			return;
+		}
+		std::set<std::string> visited;
+		forEachInclude(filepath, text, visited, [&files](const std::string& includePath, const std::string& includeText) {
+			files.push_back(includePath);
+		});
+	}
+
+	void NYShaderCompiler::setCacheDirectory(std::string directory){
+		cacheDirectory = directory;
+	}
+
+	void NYShaderCompiler::logStats(){
+		NYLogger::logInfo("shaders: %u cached, %u compiled in %.2f ms, %u failed", cacheHits.load(), compiles.load(),
+			compileMicros / 1000.0, failures.load());
+	}
+
+	uint64_t NYShaderCompiler::hashSource(const Source& source, const std::string& text){
+		NYHash hash;
+		hash.addValue(cacheVersion);
+
+		//a new compiler can produce different code from the same source
+		unsigned int spirvVersion = 0, spirvRevision = 0;
+		shaderc_get_spv_version(&spirvVersion, &spirvRevision);
+		hash.addValue(spirvVersion);
+		hash.addValue(spirvRevision);
+		hash.addValue(targetEnv);
+		hash.addValue(optimizationLevel);
+		hash.addValue(debugInfo);
+
+		hash.addString(std::filesystem::path(source.filepath).extension().string());
+		hash.addValue(static_cast<uint64_t>(source.defines.size()));
+		for (const std::string& define : source.defines) {
+			hash.addString(define);
+		}
+		hash.addString(text);
+
+		std::set<std::string> visited;
+		forEachInclude(source.filepath, text, visited, [&hash](const std::string& includePath, const std::string& includeText) {
+			hash.addString(includePath);
+			hash.addString(includeText);
+		});
+		return hash.get();
+	}
+
+	bool NYShaderCompiler::compile(const Source& source, const std::string& text, std::vector<uint32_t>& spirv){
+		NY_PROFILE_ZONE("compile shader");
+		shaderc_shader_kind kind;
+		if (!getShaderKind(source.filepath, kind)) {
+			NYLogger::logWarning("can't tell the shader stage of %s from its extension", source.filepath.c_str());
+			return false;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		shaderc::CompileOptions options;
+		options.SetTargetEnvironment(shaderc_target_env_vulkan, targetEnv);
+		options.SetOptimizationLevel(optimizationLevel);
+		if (debugInfo) {
+			options.SetGenerateDebugInfo();
+		}
+		for (const std::string& define : source.defines) {
+			size_t equals = define.find('=');
+			if (equals == std::string::npos) {
+				options.AddMacroDefinition(define);
+			}
+			else {
+				options.AddMacroDefinition(define.substr(0, equals), define.substr(equals + 1));
+			}
+		}
+		options.SetIncluder(std::make_unique<Includer>());
+
+		shaderc::SpvCompilationResult result = getCompiler().CompileGlslToSpv(text, kind, source.filepath.c_str(), options);
+		if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+			NYLogger::logWarning("failed to compile %s:\n%s", source.filepath.c_str(), result.GetErrorMessage().c_str());
+			return false;
+		}
+		spirv.assign(result.cbegin(), result.cend());
+
+		uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		compiles++;
+		compileMicros += micros;
+		NYLogger::logTrace("compiled %s in %.2f ms", source.filepath.c_str(), micros / 1000.0);
+		return true;
+	}
+
+	bool NYShaderCompiler::readCached(const std::string& path, std::vector<uint32_t>& spirv){
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+		size_t fileSize = file.tellg();
+		if (fileSize == 0 || fileSize % sizeof(uint32_t) != 0) {
+			return false;
+		}
+		spirv.resize(fileSize / sizeof(uint32_t));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(spirv.data()), fileSize);
+		//anything that isn't whole spir-v gets compiled again and overwritten
+		if (!file || spirv[0] != spirvMagic) {
+			spirv.clear();
+			return false;
+		}
+		return true;
+	}
+
+	void NYShaderCompiler::writeCached(const std::string& path, const std::vector<uint32_t>& spirv){
+		std::error_code error;
+		std::filesystem::create_directories(cacheDirectory, error);
+
+		//written to a file of its own and swapped in, so threads compiling the same shader or a crash can't leave a torn binary
+		std::string tempPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open()) {
+				NYLogger::logWarning("couldn't write the shader cache entry %s", tempPath.c_str());
+				return;
+			}
+			file.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+		}
+		std::filesystem::rename(tempPath, path, error);
+		if (error) {
+			NYLogger::logWarning("couldn't replace the shader cache entry %s", path.c_str());
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include "pch.hpp"
+#include "utils/NYThreadPool.hpp"
+
+namespace Nya {
+	//turns glsl into spir-v in process with shaderc, caching every result on disk under a hash of everything that goes into it
+	//(the source, every file it includes, the defines and the compiler options), so unchanged shaders are only ever read back
+	//the stage comes from the file extension, .vert .frag .comp .geom .tesc or .tese
+	class NYShaderCompiler {
+	public:
+		struct Source {
+			std::string filepath;
+			//"NAME" or "NAME=VALUE"
+			std::vector<std::string> defines;
+		};
+
+		//cached spir-v for the source, compiled and stored on a miss
+		//returns false and logs the compiler's errors as a warning if it doesn't compile, spirv is left empty then
+		//failing is recoverable here (hot reload keeps the old pipelines), callers that can't go on assert themselves
+		static bool getSpirv(const Source& source, std::vector<uint32_t>& spirv);
+
+		//fills the cache for all the sources at once, one compile per task on the thread pool
+		//NYShaders made from them afterwards only have to read the results back
+		static void compileAll(const std::vector<Source>& sources, NYThreadPool& threadPool);
+
+		//appends the file and everything it includes, recursively, to files. what the hot reload watches for changes
+		static void getDependencies(const std::string& filepath, std::vector<std::string>& files);
+
+		//where the compiled spir-v is kept, relative to the working directory. empty turns the disk cache off
+		static void setCacheDirectory(std::string directory);
+
+		static void logStats();
+
+	private:
+		static uint64_t hashSource(const Source& source, const std::string& text);
+		static bool compile(const Source& source, const std::string& text, std::vector<uint32_t>& spirv);
+		static bool readCached(const std::string& path, std::vector<uint32_t>& spirv);
+		static void writeCached(const std::string& path, const std::vector<uint32_t>& spirv);
+
+		static inline std::string cacheDirectory = "shader_cache";
+		static inline std::atomic<uint32_t> cacheHits{ 0 };
+		static inline std::atomic<uint32_t> compiles{ 0 };
+		static inline std::atomic<uint32_t> failures{ 0 };
+		//summed over every thread, so it can add up to more than the wall clock time
+		static inline std::atomic<uint64_t> compileMicros{ 0 };
+	};
+}
\ No newline at end of file
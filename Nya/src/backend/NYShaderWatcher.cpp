@@ -0,0 +1,210 @@
+#include "pch.hpp"
+#include "NYShaderWatcher.hpp"
+#include "NYShaderCompiler.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+
+namespace Nya {
+	NYShaderWatcher::NYShaderWatcher(NYRenderDevice& _renderDevice)
+		:renderDevice(_renderDevice) {
+	}
+
+	NYShaderWatcher::~NYShaderWatcher(){
+		stop();
+		for (Reload& reload : readyReloads) {
+			discardReload(reload);
+		}
+	}
+
+	void NYShaderWatcher::start(std::chrono::milliseconds _pollInterval){
+		if (thread.joinable()) {
+			return;
+		}
+		pollInterval = _pollInterval;
+		stopping = false;
+		thread = std::thread(&NYShaderWatcher::pollLoop, this);
+	}
+
+	void NYShaderWatcher::stop(){
+		if (!thread.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(watchMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		thread.join();
+	}
+
+	void NYShaderWatcher::watch(NYPipeline& pipeline){
+		std::lock_guard<std::mutex> lock(watchMutex);
+		getWatchedShader(pipeline.getShader()).pipelines.push_back(&pipeline);
+	}
+
+	void NYShaderWatcher::watch(NYComputePipeline& pipeline){
+		std::lock_guard<std::mutex> lock(watchMutex);
+		getWatchedShader(pipeline.getShader()).computePipelines.push_back(&pipeline);
+	}
+
+	void NYShaderWatcher::unwatch(NYPipeline& pipeline){
+		unwatchPipeline(pipeline.getShader(), &pipeline, nullptr);
+	}
+
+	void NYShaderWatcher::unwatch(NYComputePipeline& pipeline){
+		unwatchPipeline(pipeline.getShader(), nullptr, &pipeline);
+	}
+
+	void NYShaderWatcher::applyReloads(){
+		std::vector<Reload> reloads;
+		{
+			std::lock_guard<std::mutex> lock(readyMutex);
+			reloads.swap(readyReloads);
+		}
+		for (Reload& reload : reloads) {
+			for (auto& [pipeline, newPipeline] : reload.pipelines) {
+				pipeline->swapPipeline(newPipeline);
+			}
+			for (auto& [pipeline, newPipeline] : reload.computePipelines) {
+				pipeline->swapPipeline(newPipeline);
+			}
+			reload.shader->replaceModules(reload.modules);
+		}
+	}
+
+	NYShaderWatcher::WatchedShader& NYShaderWatcher::getWatchedShader(NYShader& shader){
+		auto found = std::find_if(shaders.begin(), shaders.end(), [&shader](WatchedShader& watched) { return watched.shader == &shader; });
+		if (found != shaders.end()) {
+			return *found;
+		}
+		WatchedShader watched;
+		watched.shader = &shader;
+		watched.lastWrite = getLastWrite(shader);
+		shaders.push_back(watched);
+		return shaders.back();
+	}
+
+	void NYShaderWatcher::unwatchPipeline(NYShader& shader, NYPipeline* pipeline, NYComputePipeline* computePipeline){
+		std::lock_guard<std::mutex> watchLock(watchMutex);
+		auto found = std::find_if(shaders.begin(), shaders.end(), [&shader](WatchedShader& watched) { return watched.shader == &shader; });
+		if (found == shaders.end()) {
+			return;
+		}
+		found->pipelines.erase(std::remove(found->pipelines.begin(), found->pipelines.end(), pipeline), found->pipelines.end());
+		found->computePipelines.erase(std::remove(found->computePipelines.begin(), found->computePipelines.end(), computePipeline), found->computePipelines.end());
+		bool shaderUnwatched = found->pipelines.empty() && found->computePipelines.empty();
+		if (shaderUnwatched) {
+			shaders.erase(found);
+		}
+
+		//finished reloads can't be swapped into a pipeline that's about to go, or modules into a shader that might
+		std::lock_guard<std::mutex> readyLock(readyMutex);
+		for (auto reload = readyReloads.begin(); reload != readyReloads.end();) {
+			if (reload->shader != &shader) {
+				reload++;
+				continue;
+			}
+			if (shaderUnwatched) {
+				discardReload(*reload);
+				reload = readyReloads.erase(reload);
+				continue;
+			}
+			for (auto entry = reload->pipelines.begin(); entry != reload->pipelines.end();) {
+				if (entry->first != pipeline) {
+					entry++;
+					continue;
+				}
+				renderDevice.getDevice().destroyPipeline(entry->second);
+				entry = reload->pipelines.erase(entry);
+			}
+			for (auto entry = reload->computePipelines.begin(); entry != reload->computePipelines.end();) {
+				if (entry->first != computePipeline) {
+					entry++;
+					continue;
+				}
+				renderDevice.getDevice().destroyPipeline(entry->second);
+				entry = reload->computePipelines.erase(entry);
+			}
+			reload++;
+		}
+	}
+
+	std::filesystem::file_time_type NYShaderWatcher::getLastWrite(NYShader& shader){
+		//includes are looked up again every time, so ones added by an edit are picked up from then on
+		std::vector<std::string> files;
+		for (std::string& sourcePath : shader.getSourcePaths()) {
+			NYShaderCompiler::getDependencies(sourcePath, files);
+		}
+		std::filesystem::file_time_type lastWrite = std::filesystem::file_time_type::min();
+		for (std::string& file : files) {
+			std::error_code error;
+			std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file, error);
+			if (!error) {
+				lastWrite = std::max(lastWrite, writeTime);
+			}
+		}
+		return lastWrite;
+	}
+
+	void NYShaderWatcher::pollLoop(){
+		NY_PROFILE_THREAD("shader watcher");
+		std::unique_lock<std::mutex> lock(watchMutex);
+		while (true) {
+			wake.wait_for(lock, pollInterval, [this]() { return stopping; });
+			if (stopping) {
+				return;
+			}
+			for (WatchedShader& watched : shaders) {
+				std::filesystem::file_time_type lastWrite = getLastWrite(*watched.shader);
+				if (lastWrite == watched.lastWrite) {
+					continue;
+				}
+				watched.lastWrite = lastWrite;
+				reload(watched);
+			}
+		}
+	}
+
+	void NYShaderWatcher::reload(WatchedShader& watched){
+		NY_PROFILE_ZONE("shader reload");
+		auto start = std::chrono::steady_clock::now();
+		std::vector<std::string> sourcePaths = watched.shader->getSourcePaths();
+		std::string name = sourcePaths[0];
+		for (size_t i = 1; i < sourcePaths.size(); i++) {
+			name += " + " + sourcePaths[i];
+		}
+
+		Reload reload{ watched.shader };
+		if (!watched.shader->compileModules(reload.modules)) {
+			//the compiler has already logged why
+			NYLogger::logWarning("%s failed to compile, keeping its last working pipelines", name.c_str());
+			return;
+		}
+		for (NYPipeline* pipeline : watched.pipelines) {
+			reload.pipelines.push_back({ pipeline, pipeline->buildPipeline(reload.modules.vertex, reload.modules.fragment) });
+		}
+		for (NYComputePipeline* pipeline : watched.computePipelines) {
+			reload.computePipelines.push_back({ pipeline, pipeline->buildPipeline(reload.modules.compute) });
+		}
+
+		float millis = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+		NYLogger::logInfo("reloaded %s, %zu pipelines rebuilt in %.2f ms", name.c_str(),
+			reload.pipelines.size() + reload.computePipelines.size(), millis);
+
+		std::lock_guard<std::mutex> readyLock(readyMutex);
+		readyReloads.push_back(reload);
+	}
+
+	void NYShaderWatcher::discardReload(Reload& reload){
+		vk::Device& device = renderDevice.getDevice();
+		for (auto& [pipeline, newPipeline] : reload.pipelines) {
+			device.destroyPipeline(newPipeline);
+		}
+		for (auto& [pipeline, newPipeline] : reload.computePipelines) {
+			device.destroyPipeline(newPipeline);
+		}
+		device.destroyShaderModule(reload.modules.vertex);
+		device.destroyShaderModule(reload.modules.fragment);
+		device.destroyShaderModule(reload.modules.compute);
+	}
+}
\ No newline at end of file
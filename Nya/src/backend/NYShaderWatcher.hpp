@@ -0,0 +1,76 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYShader.hpp"
+#include "NYPipeline.hpp"
+#include "NYComputePipeline.hpp"
+
+namespace Nya {
+	//hot reloads the shaders behind watched pipelines. a background thread polls their glsl sources and includes for changes,
+	//recompiles the changed shaders and builds replacement pipelines, which applyReloads() swaps in between frames
+	//a shader that fails to compile logs its errors and keeps its last working pipelines
+	class NYShaderWatcher {
+	public:
+		NYShaderWatcher(NYRenderDevice& _renderDevice);
+		~NYShaderWatcher();
+
+		NYShaderWatcher(NYShaderWatcher const&) = delete;
+		NYShaderWatcher& operator=(NYShaderWatcher const&) = delete;
+
+		//pipelines can be watched before the thread is started, nothing is polled until then
+		void start(std::chrono::milliseconds pollInterval = std::chrono::milliseconds(250));
+		void stop();
+
+		//every pipeline made from a shader is rebuilt when it changes, so all of them have to be watched
+		void watch(NYPipeline& pipeline);
+		void watch(NYComputePipeline& pipeline);
+		//pipelines destroyed before the watcher have to be unwatched first, blocks while a reload is being built
+		void unwatch(NYPipeline& pipeline);
+		void unwatch(NYComputePipeline& pipeline);
+
+		//swaps in every reload finished since the last call, the replaced pipelines are destroyed once the frames using them are done
+		//the renderer calls it in beginFrame(), nothing can be recording with the watched pipelines while it runs
+		void applyReloads();
+
+	private:
+		struct WatchedShader {
+			NYShader* shader;
+			std::vector<NYPipeline*> pipelines;
+			std::vector<NYComputePipeline*> computePipelines;
+			//newest write time of the sources and everything they include
+			std::filesystem::file_time_type lastWrite;
+		};
+
+		//a recompiled shader and the pipelines built from it, waiting for the next frame boundary
+		struct Reload {
+			NYShader* shader;
+			NYShader::Modules modules;
+			std::vector<std::pair<NYPipeline*, vk::Pipeline>> pipelines;
+			std::vector<std::pair<NYComputePipeline*, vk::Pipeline>> computePipelines;
+		};
+
+		WatchedShader& getWatchedShader(NYShader& shader);
+		//one of the pipelines is null, drops the shader too once it has no pipelines left
+		void unwatchPipeline(NYShader& shader, NYPipeline* pipeline, NYComputePipeline* computePipeline);
+		std::filesystem::file_time_type getLastWrite(NYShader& shader);
+		void pollLoop();
+		void reload(WatchedShader& watched);
+		//for reloads that never got swapped in, doesn't touch the shader since it may be gone already
+		void discardReload(Reload& reload);
+
+		NYRenderDevice& renderDevice;
+
+		//held by the watcher thread while it builds a reload, so pipelines can't be unwatched out from under it
+		std::mutex watchMutex;
+		std::vector<WatchedShader> shaders;
+
+		//only held briefly, so applyReloads() never waits on a compile
+		std::mutex readyMutex;
+		std::vector<Reload> readyReloads;
+
+		std::thread thread;
+		std::condition_variable wake;
+		std::chrono::milliseconds pollInterval{ 250 };
+		bool stopping = false;
+	};
+}
\ No newline at end of file
@@ -1,20 +1,28 @@
 #include "pch.hpp"
 #include "NYSwapchain.hpp"
 #include "logging/NYLogger.hpp"
+#include "defines.hpp"
 
 namespace Nya {
-	NYSwapchain::NYSwapchain(NYRenderDevice& _renderDevice):renderDevice(_renderDevice){
+	NYSwapchain::NYSwapchain(NYRenderDevice& _renderDevice, vk::Extent2D offscreenExtent):renderDevice(_renderDevice){
+		if (renderDevice.isHeadless()) {
+			createOffscreenTargets(offscreenExtent);
+			NYLogger::logTrace("NYSwapchain created headless");
+			return;
+		}
 		getSwapchainInfo();
 		selectParams();
-		createSwapchain();
+		createSwapchain(nullptr);
 		createImageViews();
 		NYLogger::logTrace("NYSwapchain created");
 	}
 
 	NYSwapchain::~NYSwapchain(){
-
-		for (auto frameBuffer : frameBuffers) {
-			renderDevice.getDevice().destroyFramebuffer(frameBuffer);
+		//the offscreen targets clean up their own images
+		if (isHeadless()) {
+			offscreenTargets.clear();
+			NYLogger::logTrace("NYSwapchain destroyed");
+			return;
 		}
 
 		for (auto& imgView : imageViews) {
@@ -24,6 +32,29 @@ namespace Nya {
 		NYLogger::logTrace("NYSwapchain destroyed");
 	}
 
+	void NYSwapchain::recreate(){
+		NYLogger::checkAssert(!isHeadless(), "headless NYSwapchains can't be recreated");
+		vk::SwapchainKHR oldSwapchain = swapchain;
+		std::vector<vk::ImageView> oldImageViews = imageViews;
+
+		//only the capabilities change with the window, the format and present mode stay what they were
+		getSwapchainInfo();
+		selectExtent();
+		createSwapchain(oldSwapchain);
+		createImageViews();
+		generation++;
+
+		//frames already submitted can still be rendering to or presenting the old images
+		vk::Device device = renderDevice.getDevice();
+		renderDevice.deferRelease(renderDevice.getSubmittedValue(), [device, oldSwapchain, oldImageViews]() {
+			for (auto& imgView : oldImageViews) {
+				device.destroyImageView(imgView);
+			}
+			device.destroySwapchainKHR(oldSwapchain);
+		});
+		NYLogger::logTrace("NYSwapchain recreated at %ux%u", swapchainExtent.width, swapchainExtent.height);
+	}
+
 	void NYSwapchain::getSwapchainInfo(){
 		auto surf = static_cast<vk::SurfaceKHR>(renderDevice.getSurface());
 		surfCapabilities = renderDevice.getPhysicalDevice().getSurfaceCapabilitiesKHR(surf);
@@ -44,7 +75,20 @@ namespace Nya {
 				break;
 			}
 		}
-		//now for the swapchain extent
+		selectExtent();
+
+		//now the surface format
+		
+		for (const auto& format : surfFormats) {
+			if (format.format == vk::Format::eB8G8R8A8Unorm && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
+				surfFormat = format;
+			}
+		}
+		//if it doesnt work select the first one
+		surfFormat = surfFormats[0];
+	}
+
+	void NYSwapchain::selectExtent(){
 		if (surfCapabilities.currentExtent.width != UINT32_MAX) {
 			swapchainExtent = surfCapabilities.currentExtent;
 		}
@@ -62,19 +106,9 @@ namespace Nya {
 											   surfCapabilities.minImageExtent.height,
 					                           surfCapabilities.maxImageExtent.height);
 		}
-
-		//now the surface format
-		
-		for (const auto& format : surfFormats) {
-			if (format.format == vk::Format::eB8G8R8A8Unorm && format.colorSpace == vk::ColorSpaceKHR::eSrgbNonlinear) {
-				surfFormat = format;
-			}
-		}
-		//if it doesnt work select the first one
-		surfFormat = surfFormats[0];
 	}
 
-	void NYSwapchain::createSwapchain(){
+	void NYSwapchain::createSwapchain(vk::SwapchainKHR oldSwapchain){
 
 		uint32_t imageCount = surfCapabilities.minImageCount + 1;
 		if (surfCapabilities.maxImageCount > 0 && imageCount > surfCapabilities.maxImageCount) {
@@ -101,7 +135,7 @@ namespace Nya {
 				vk::CompositeAlphaFlagBitsKHR::eOpaque,//compositeAlpha
 				presentMode,//present mode
 				false,//clipped
-				nullptr//oldSwapchain
+				oldSwapchain//oldSwapchain
 			);
 		}
 		else {
@@ -120,7 +154,7 @@ namespace Nya {
 				vk::CompositeAlphaFlagBitsKHR::eOpaque,//compositeAlpha
 				presentMode,//present mode
 				false,//clipped
-				nullptr//oldSwapchain
+				oldSwapchain//oldSwapchain
 			);
 		}
 
@@ -149,23 +183,19 @@ namespace Nya {
 		}
 	}
 
-	void NYSwapchain::createFrameBuffers(vk::RenderPass& renderPass){
-		frameBuffers.resize(swapchainImages.size());
-		for (int i = 0; i < swapchainImages.size(); i++) {
-			std::array<vk::ImageView, 1> attachments;
-			//in the default render pass we only had one color attachment, so for this frame buffer we will only have 1 attachment as well
-			attachments[0] = imageViews[i];
-
-			vk::FramebufferCreateInfo createInfo = vk::FramebufferCreateInfo(vk::FramebufferCreateFlags(),
-																			 renderPass,
-																		     attachments,
-																			 swapchainExtent.width,
-																			 swapchainExtent.height,
-																			 1);
-
-			frameBuffers[i] = renderDevice.getDevice().createFramebuffer(createInfo);
+	void NYSwapchain::createOffscreenTargets(vk::Extent2D extent){
+		NYLogger::checkAssert(extent.width > 0 && extent.height > 0, "headless NYSwapchain needs an offscreen extent");
+		swapchainExtent = extent;
+		//rgba so copies read back straight into files without swizzling
+		surfFormat = vk::SurfaceFormatKHR(vk::Format::eR8G8B8A8Unorm, vk::ColorSpaceKHR::eSrgbNonlinear);
+
+		//one image per frame in flight, the renderer cycles through them in order instead of acquiring
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			auto target = std::make_unique<NYFramebuffer>(renderDevice, swapchainExtent);
+			uint32_t color = target->addColorAttachment(surfFormat.format, vk::ImageUsageFlagBits::eTransferSrc);
+			swapchainImages.push_back(target->getAttachment(color).image);
+			imageViews.push_back(target->getAttachment(color).imageView);
+			offscreenTargets.push_back(std::move(target));
 		}
-
-		createdFrameBuffers = true;
 	}
 }
\ No newline at end of file
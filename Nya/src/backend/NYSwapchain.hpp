@@ -1,6 +1,7 @@
 #pragma once
 #include "pch.hpp"
 #include "NYRenderDevice.hpp"
+#include "NYFramebuffer.hpp"
 
 /*
 This is the swapchain abstraction class, it will encapsulate the following things
@@ -8,12 +9,14 @@ This is the swapchain abstraction class, it will encapsulate the following thing
 -swapchain images
 -swapchain image views
 -image formats, presentation modes
+on a headless device there's no surface to present to, the images are offscreen NYFramebuffers of the given extent instead
 */
 
 namespace Nya {
 	class NYSwapchain {
 	public:
-		NYSwapchain(NYRenderDevice& _renderDevice);
+		//offscreenExtent is only used when the device is headless, windowed swapchains take the surface's extent
+		NYSwapchain(NYRenderDevice& _renderDevice, vk::Extent2D offscreenExtent = vk::Extent2D());
 		~NYSwapchain();
 
 		NYSwapchain(NYSwapchain const&) = delete;
@@ -21,22 +24,32 @@ namespace Nya {
 
 		vk::SwapchainKHR& getSwapchain() { return swapchain; }
 
+		//makes a new swapchain at the window's current size from the old one, so the driver can reuse its images
+		//the old swapchain and views are released once the frames already submitted are done, nothing waits for the gpu
+		//the format is kept, so render passes and pipelines made for the old swapchain still work with the new one
+		void recreate();
+		//bumped by every recreate(), for anything made from the images or the extent
+		uint32_t getGeneration() { return generation; }
+
 		vk::Extent2D getSwapchainExtent() { return swapchainExtent; }
 		vk::Format getSwapchainFormat() { return surfFormat.format; }
 
-		vk::Framebuffer getFrameBuffer(uint32_t index) { return frameBuffers[index]; }
-
 		size_t numSwapchainImages() { return swapchainImages.size(); }
 		vk::SurfaceCapabilitiesKHR getSwapchainCapabilities() { return surfCapabilities; }
+		//framebuffers over these are made by the frame graph
 		vk::ImageView* getImageView_Ptr(uint32_t imageIndex) { return &imageViews[imageIndex]; }
+		vk::Image getImage(uint32_t imageIndex) { return swapchainImages[imageIndex]; }
 
-		//create the pipeline first and then use its renderPass
-		void createFrameBuffers(vk::RenderPass& renderPass);
+		bool isHeadless() { return renderDevice.isHeadless(); }
+		//layout the images are left in at the end of a frame, ready to present or to copy back when headless
+		vk::ImageLayout getFinalLayout() { return isHeadless() ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR; }
 	private:
 		void getSwapchainInfo();
 		void selectParams();
-		void createSwapchain();
+		void selectExtent();
+		void createSwapchain(vk::SwapchainKHR oldSwapchain);
 		void createImageViews();
+		void createOffscreenTargets(vk::Extent2D extent);
 
 		NYRenderDevice& renderDevice;//as mentioned before we cant copy this take it as reference
 
@@ -49,15 +62,14 @@ namespace Nya {
 		//swapchain resources
 		std::vector<vk::ImageView> imageViews;
 		std::vector<vk::Image> swapchainImages;
-
-		std::vector<vk::Framebuffer> frameBuffers;
+		//own the images and views above when headless
+		std::vector<std::unique_ptr<NYFramebuffer>> offscreenTargets;
 
 		//initialization parameters
 		vk::PresentModeKHR presentMode;
 		vk::SurfaceFormatKHR surfFormat;
 		vk::Extent2D swapchainExtent;
 
-		bool createdFrameBuffers = false;
-
+		uint32_t generation = 0;
 	};
 }
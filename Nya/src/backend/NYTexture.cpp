@@ -1,34 +1,200 @@
 #include "pch.hpp"
 #include "NYTexture.hpp"
+#include "NYTextureStreamer.hpp"
+#include "NYUploadContext.hpp"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 #include "logging/NYLogger.hpp"
 #include "utils/NYTimer.hpp"
+#include "utils/NYProfiler.hpp"
+#include "utils/NYImageUtils.hpp"
 
 namespace Nya {
-	NYTexture::NYTexture(NYRenderDevice& _renderDevice, std::string _filepath)
-		:renderDevice(_renderDevice), filepath(_filepath) {
-		createImage();
+	NYTexture::NYTexture(NYRenderDevice& _renderDevice, std::string _filepath, NYTextureCreateInfo _createInfo)
+		:renderDevice(_renderDevice), filepath(_filepath), createInfo(_createInfo) {
+		createImage(decode(filepath));
+		createImageView();
+		createSampler();
+	}
+
+	NYTexture::NYTexture(NYRenderDevice& _renderDevice, const DecodedImage& decoded, NYTextureCreateInfo _createInfo)
+		:renderDevice(_renderDevice), filepath(decoded.filepath), createInfo(_createInfo) {
+		createImage(decoded);
+		createImageView();
+		createSampler();
+	}
+
+	NYTexture::NYTexture(NYRenderDevice& _renderDevice, uint32_t _width, uint32_t _height)
+		:renderDevice(_renderDevice), width(_width), height(_height), channels(4) {
+		allocateImage();
+		//the clear goes out with the graphics upload context ahead of the next frame, so it's usable straight away
+		ready = true;
+
+		std::vector<uint8_t> clearPixels(static_cast<size_t>(width) * height * 4, 0);
+		uploadRegion(clearPixels.data(), 0, 0, width, height, VK_IMAGE_LAYOUT_UNDEFINED);
+
 		createImageView();
 		createSampler();
 	}
 
 	NYTexture::~NYTexture(){
-		vkDestroySampler(renderDevice.getDevice(), imageSampler, nullptr);
-		vkDestroyImageView(renderDevice.getDevice(), imageView ,nullptr);
-		vmaDestroyImage(renderDevice.getAllocator(), image, imageAlloc);
+		if (table) {
+			table->releaseTexture(*this);
+		}
+		//the streamer's callback points at this texture, it has to have run before it's gone
+		if (!ready) {
+			renderDevice.getTextureStreamer().finish();
+		}
+		//frames already submitted can still sample it and an upload can still be writing it, nothing waits on either here
+		uint64_t releaseValue = std::max(getUploadValue(), renderDevice.getSubmittedValue());
+		VkDevice device = renderDevice.getDevice();
+		VmaAllocator allocator = renderDevice.getAllocator();
+		VkSampler oldSampler = imageSampler;
+		VkImageView oldImageView = imageView;
+		VkImage oldImage = image;
+		VmaAllocation oldImageAlloc = imageAlloc;
+		renderDevice.deferRelease(releaseValue, [device, allocator, oldSampler, oldImageView, oldImage, oldImageAlloc]() {
+			vkDestroySampler(device, oldSampler, nullptr);
+			vkDestroyImageView(device, oldImageView, nullptr);
+			vmaDestroyImage(allocator, oldImage, oldImageAlloc);
+		});
 	}
 
-	void NYTexture::createImage(){
+	NYTexture::DecodedImage NYTexture::decode(const std::string& filepath){
+		NY_PROFILE_ZONE("texture decode");
+		DecodedImage decoded;
+		decoded.filepath = filepath;
+
+		if (std::filesystem::path(filepath).extension() == ".ktx2") {
+			decoded.ktx2 = std::make_unique<NYKTX2>();
+			if (!decoded.ktx2->load(filepath)) {
+				NYLogger::logWarning("Failed to load image %s", filepath.c_str());
+				decoded.ktx2.reset();
+				return decoded;
+			}
+			decoded.width = decoded.ktx2->getWidth();
+			decoded.height = decoded.ktx2->getHeight();
+			decoded.valid = true;
+			return decoded;
+		}
+
+		int width, height, channels;
 		stbi_uc* pixels = stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels) {
+			NYLogger::logWarning("Failed to load image %s", filepath.c_str());
+			return decoded;
+		}
+		//freed with stb's own allocator whenever the last copy of the image goes
+		decoded.pixels = std::shared_ptr<uint8_t>(pixels, stbi_image_free);
+		decoded.width = static_cast<uint32_t>(width);
+		decoded.height = static_cast<uint32_t>(height);
+		decoded.valid = true;
+		return decoded;
+	}
 
-		vk::DeviceSize imageSize = width * height * 4;
-		
+	NYTexture::DecodedImage NYTexture::decode(const std::string& filepath, const uint8_t* data, size_t size){
+		NY_PROFILE_ZONE("texture decode");
+		DecodedImage decoded;
+		decoded.filepath = filepath;
+
+		if (NYKTX2::isKTX2(data, size)) {
+			decoded.ktx2 = std::make_unique<NYKTX2>();
+			if (!decoded.ktx2->parse(data, size)) {
+				NYLogger::logWarning("Failed to load image %s", filepath.c_str());
+				decoded.ktx2.reset();
+				return decoded;
+			}
+			decoded.width = decoded.ktx2->getWidth();
+			decoded.height = decoded.ktx2->getHeight();
+			decoded.valid = true;
+			return decoded;
+		}
 
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load_from_memory(data, static_cast<int>(size), &width, &height, &channels, STBI_rgb_alpha);
 		if (!pixels) {
+			NYLogger::logWarning("Failed to load image %s", filepath.c_str());
+			return decoded;
+		}
+		decoded.pixels = std::shared_ptr<uint8_t>(pixels, stbi_image_free);
+		decoded.width = static_cast<uint32_t>(width);
+		decoded.height = static_cast<uint32_t>(height);
+		decoded.valid = true;
+		return decoded;
+	}
+
+	void NYTexture::createImage(const DecodedImage& decoded){
+		NY_PROFILE_ZONE("texture load");
+		if (!decoded.valid) {
 			NYLogger::logError("Failed to load image %s", filepath.c_str());
 		}
+		if (decoded.ktx2) {
+			createImageKTX2(*decoded.ktx2);
+			return;
+		}
+
+		width = static_cast<int>(decoded.width);
+		height = static_cast<int>(decoded.height);
+		channels = 4;
+		if (createInfo.mipmaps) {
+			mipLevels = NYImageUtils::getMipLevelCount(width, height);
+		}
+
+		allocateImage();
+		//streamed on the transfer queue, the texture shows up once the graphics queue has taken it over
+		//the streamer fills in the rest of the mip chain
+		renderDevice.getTextureStreamer().upload(image, format, decoded.pixels.get(), width, height, mipLevels, [this](uint64_t value) {
+			uploadValue = value;
+			ready = true;
+		});
+	}
+
+	void NYTexture::createImageKTX2(NYKTX2& ktx2){
+		//an image can't be created in a bc format here, a transparent pixel stands in like it would for a texture that's still streaming
+		if (NYKTX2::isBlockCompressed(ktx2.getFormat()) && !renderDevice.getEnabledFeatures().textureCompressionBC) {
+			NYLogger::logWarning("%s is block compressed and the gpu doesn't support bc textures, cook it uncompressed", filepath.c_str());
+			width = 1;
+			height = 1;
+			channels = 4;
+			allocateImage();
+			ready = true;
+			uint8_t clearPixel[4] = { 0, 0, 0, 0 };
+			uploadRegion(clearPixel, 0, 0, 1, 1, VK_IMAGE_LAYOUT_UNDEFINED);
+			return;
+		}
+
+		format = static_cast<vk::Format>(ktx2.getFormat());
+		width = static_cast<int>(ktx2.getWidth());
+		height = static_cast<int>(ktx2.getHeight());
+		channels = 4;
 
+		auto onReady = [this](uint64_t value) {
+			uploadValue = value;
+			ready = true;
+		};
+		std::vector<NYTextureStreamer::Level> levels;
+		for (auto& level : ktx2.getLevels()) {
+			levels.push_back({ level.data, level.size, level.width, level.height });
+		}
+		if (!createInfo.mipmaps) {
+			levels.resize(1);
+		}
+
+		//uncompressed files cooked without mips still get them generated like any other image
+		if (createInfo.mipmaps && levels.size() == 1 && !NYKTX2::isBlockCompressed(ktx2.getFormat())) {
+			mipLevels = NYImageUtils::getMipLevelCount(width, height);
+			allocateImage();
+			renderDevice.getTextureStreamer().upload(image, format, levels[0].data, width, height, mipLevels, onReady);
+			return;
+		}
+
+		//the blocks are copied straight to staging, nothing is decoded on the way
+		mipLevels = static_cast<uint32_t>(levels.size());
+		allocateImage();
+		renderDevice.getTextureStreamer().uploadLevels(image, levels, onReady);
+	}
+
+	void NYTexture::allocateImage(){
 		VmaAllocationCreateInfo allocInfo{};
 		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
@@ -37,45 +203,54 @@ namespace Nya {
 		imageInfo.extent.width = static_cast<uint32_t>(width);
 		imageInfo.extent.height = static_cast<uint32_t>(height);
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = mipLevels;
 		imageInfo.arrayLayers = 1;
-		imageInfo.format = vk::Format::eR8G8B8A8Srgb;
+		imageInfo.format = format;
 		imageInfo.tiling = vk::ImageTiling::eOptimal;
 		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
 		imageInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+		//every level is blitted from the one above it
+		if (mipLevels > 1) {
+			imageInfo.usage |= vk::ImageUsageFlagBits::eTransferSrc;
+		}
 		imageInfo.sharingMode = vk::SharingMode::eExclusive;
 		imageInfo.samples = vk::SampleCountFlagBits::e1;
 
 		renderDevice.createImage(image, static_cast<VkImageCreateInfo>(imageInfo), allocInfo, imageAlloc);
+	}
 
-		VkBuffer stagingBuffer;
-		VmaAllocation stagingAllocation;
-
-		VmaAllocationCreateInfo stagingAllocInfo{};
-		stagingAllocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
-
-		std::array<uint32_t, 1> queueFamilyIndices = { renderDevice.getGraphicsQueueFamilyIndex() };
-
-		vk::BufferCreateInfo stagingBufferInfo;
-		stagingBufferInfo.setQueueFamilyIndices(queueFamilyIndices);
-		stagingBufferInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
-		stagingBufferInfo.size = imageSize;
-		stagingBufferInfo.sharingMode = vk::SharingMode::eExclusive;
-
-		auto stagingBuffInfo = static_cast<VkBufferCreateInfo>(stagingBufferInfo);
-
-		NYLogger::checkAssert(vmaCreateBuffer(renderDevice.getAllocator(), &stagingBuffInfo, &stagingAllocInfo, &stagingBuffer, &stagingAllocation, nullptr) == VK_SUCCESS, "Failed to create staging buffer for image");
+	void NYTexture::updateRegion(const void* pixels, int32_t x, int32_t y, uint32_t regionWidth, uint32_t regionHeight){
+		NYLogger::checkAssert(x >= 0 && y >= 0 && x + regionWidth <= static_cast<uint32_t>(width) && y + regionHeight <= static_cast<uint32_t>(height),
+			"NYTexture::updateRegion() region is out of the texture's bounds");
+		NYLogger::checkAssert(ready, "NYTexture::updateRegion() called before the texture finished streaming in");
+		NYLogger::checkAssert(mipLevels == 1, "NYTexture::updateRegion() only updates the first level, mipmapped textures would go stale");
+		uploadRegion(pixels, x, y, regionWidth, regionHeight, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	}
 
-		void* data;
-		vmaMapMemory(renderDevice.getAllocator(), stagingAllocation, &data);
-		memcpy(data, pixels, imageSize);
-		vmaUnmapMemory(renderDevice.getAllocator(), stagingAllocation);
-		stbi_image_free(pixels);
+	void NYTexture::uploadRegion(const void* pixels, int32_t x, int32_t y, uint32_t regionWidth, uint32_t regionHeight, VkImageLayout oldLayout){
+		NY_PROFILE_ZONE("texture upload");
+		vk::DeviceSize imageSize = static_cast<vk::DeviceSize>(regionWidth) * regionHeight * 4;
+
+		NYUploadContext& uploadContext = renderDevice.getUploadContext();
+		//staging first, running out of ring space can submit the batch and start a new one
+		NYUploadContext::Staging staging = uploadContext.allocateStaging(imageSize);
+		memcpy(staging.data, pixels, imageSize);
+
+		//recorded into the context's open batch, nothing waits on it and the renderer submits it before the next frame
+		vk::CommandBuffer commandBuffer = uploadContext.getCommandBuffer();
+		transitionLayout(commandBuffer, image, vk::Format::eR8G8B8A8Srgb, oldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		copyBufferToImage(commandBuffer, staging.buffer, staging.offset, image, x, y, regionWidth, regionHeight);
+		transitionLayout(commandBuffer, image, vk::Format::eR8G8B8A8Srgb, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		uploadBatch = uploadContext.getOpenBatch();
+	}
 
-		transitionLayout(image, vk::Format::eR8G8B8A8Srgb, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		copyBufferToImage(stagingBuffer, image, width, height);
-		transitionLayout(image, vk::Format::eR8G8B8A8Srgb, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-		vmaDestroyBuffer(renderDevice.getAllocator(), stagingBuffer, stagingAllocation);
+	uint64_t NYTexture::getUploadValue(){
+		//an update still waiting in the upload context is submitted so it has a value to wait on
+		if (uploadBatch != 0) {
+			uploadValue = std::max(uploadValue, renderDevice.getUploadContext().getBatchValue(uploadBatch));
+			uploadBatch = 0;
+		}
+		return uploadValue;
 	}
 
 	void NYTexture::createImageView(){
@@ -83,10 +258,14 @@ namespace Nya {
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = image;
 		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+		viewInfo.format = static_cast<VkFormat>(format);
+		//bc4 only stores red, it's read as a grey mask
+		if (format == vk::Format::eBc4UnormBlock) {
+			viewInfo.components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+		}
 		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -97,25 +276,26 @@ namespace Nya {
 	void NYTexture::createSampler(){
 		VkSamplerCreateInfo samplerInfo{};
 		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.anisotropyEnable = VK_TRUE;
+		//pixel art keeps hard texel edges, mips are still picked so it doesn't shimmer when zoomed out
+		samplerInfo.magFilter = createInfo.pixelArt ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+		samplerInfo.minFilter = createInfo.pixelArt ? VK_FILTER_NEAREST : VK_FILTER_LINEAR;
+		samplerInfo.anisotropyEnable = createInfo.pixelArt ? VK_FALSE : VK_TRUE;
 		vk::PhysicalDeviceProperties phyDeviceProps = renderDevice.getPhysicalDevice().getProperties();
-		samplerInfo.maxAnisotropy = phyDeviceProps.limits.maxSamplerAnisotropy;
+		samplerInfo.maxAnisotropy = createInfo.pixelArt ? 1.0f : phyDeviceProps.limits.maxSamplerAnisotropy;
 		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 		samplerInfo.unnormalizedCoordinates = VK_FALSE;
 		samplerInfo.compareEnable = VK_FALSE;
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.mipmapMode = createInfo.pixelArt ? VK_SAMPLER_MIPMAP_MODE_NEAREST : VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		samplerInfo.mipLodBias = 0.0f;
 		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
+		samplerInfo.maxLod = static_cast<float>(mipLevels);
 
 		NYLogger::checkAssert(vkCreateSampler(renderDevice.getDevice(), &samplerInfo, nullptr, &imageSampler) == VK_SUCCESS,
 			"Failed to create image sampler");
 	}
 
-	void NYTexture::transitionLayout(VkImage& image, vk::Format format, VkImageLayout oldLayout, VkImageLayout newLayout){
-		vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
-
+	void NYTexture::transitionLayout(vk::CommandBuffer& commandBuffer, VkImage& image, vk::Format format, VkImageLayout oldLayout, VkImageLayout newLayout){
 		VkImageMemoryBarrier barrier{};
 		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
 		barrier.oldLayout = oldLayout;
@@ -147,17 +327,21 @@ namespace Nya {
 			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 		}
-		vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &barrier);
-
-		renderDevice.endSingleTimeCommandBuffers(commandBuffer);
-	}
 
-	void NYTexture::copyBufferToImage(VkBuffer& buffer, VkImage& image, uint32_t width, uint32_t height){
+		//updating a texture that's already been sampled from
+		if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+			barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 
-		vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
+			sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		}
+		vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
 
+	void NYTexture::copyBufferToImage(vk::CommandBuffer& commandBuffer, VkBuffer& buffer, vk::DeviceSize bufferOffset, VkImage& image, int32_t x, int32_t y, uint32_t width, uint32_t height){
 		VkBufferImageCopy region{};
-		region.bufferOffset = 0;
+		region.bufferOffset = bufferOffset;
 		region.bufferRowLength = 0;
 		region.bufferImageHeight = 0;
 
@@ -166,7 +350,7 @@ namespace Nya {
 		region.imageSubresource.baseArrayLayer = 0;
 		region.imageSubresource.layerCount = 1;
 		
-		region.imageOffset = { 0, 0, 0 };
+		region.imageOffset = { x, y, 0 };
 		region.imageExtent = {
 			width,
 			height,
@@ -174,7 +358,5 @@ namespace Nya {
 		};
 
 		vkCmdCopyBufferToImage(commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-
-		renderDevice.endSingleTimeCommandBuffers(commandBuffer);
 	}
 }
\ No newline at end of file
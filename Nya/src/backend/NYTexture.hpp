@@ -1,11 +1,43 @@
 #pragma once
 #include "pch.hpp"
 #include "NYRenderDevice.hpp"
+#include "NYTextureTable.hpp"
+#include "assets/NYKTX2.hpp"
 
 namespace Nya {
 	class NYTexture {
 	public:
-		NYTexture(NYRenderDevice& _renderDevice, std::string _filepath);
+		struct NYTextureCreateInfo {
+			bool mipmaps = true;//full mip chain sampled trilinearly, generated on upload
+			bool pixelArt = false;//nearest filtering on every level, for textures that must stay crisp
+		};
+
+		//a file read into memory and ready to upload, what decode() hands back
+		struct DecodedImage {
+			std::string filepath;
+			bool valid = false;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			//rgba8 from stb, null for ktx2 files
+			std::shared_ptr<uint8_t> pixels;
+			//.ktx2 files keep their stored levels, nothing in them is decoded
+			std::unique_ptr<NYKTX2> ktx2;
+		};
+
+		//reads the file and decodes it if it needs decoding, doesn't touch the device so it's safe on any thread
+		//.ktx2 files from the cooker are kept as stored, block compressed ones included, anything else goes through stb
+		//a file that can't be loaded gives an invalid image and a warning
+		static DecodedImage decode(const std::string& filepath);
+		//same from a file that's already in memory, like an asset pack blob. told apart by content rather than extension
+		//ktx2 levels point straight into data, which has to outlive the image and the texture's creation
+		static DecodedImage decode(const std::string& filepath, const uint8_t* data, size_t size);
+
+		//streamed in through the device's NYTextureStreamer, not usable until isReady()
+		NYTexture(NYRenderDevice& _renderDevice, std::string _filepath, NYTextureCreateInfo _createInfo = NYTextureCreateInfo());
+		//same as above from an image that was decoded ahead of time, see NYTextureLoader
+		NYTexture(NYRenderDevice& _renderDevice, const DecodedImage& decoded, NYTextureCreateInfo _createInfo = NYTextureCreateInfo());
+		//blank rgba8 texture cleared to transparent black, filled in later with updateRegion()
+		NYTexture(NYRenderDevice& _renderDevice, uint32_t _width, uint32_t _height);
 		~NYTexture();
 
 		NYTexture(NYTexture const&) = delete;
@@ -13,14 +45,33 @@ namespace Nya {
 
 		VkImageView& getImageView() { return imageView; }
 		VkSampler& getSampler() { return imageSampler; }
+		uint32_t getWidth() { return static_cast<uint32_t>(width); }
+		uint32_t getHeight() { return static_cast<uint32_t>(height); }
+		uint32_t getMipLevels() { return mipLevels; }
+		//slot in the global texture table, UINT32_MAX if it isn't registered
+		uint32_t getTableIndex() { return tableIndex; }
+		NYTextureTable* getTable() { return table; }
+		void setTableSlot(NYTextureTable* _table, uint32_t _tableIndex) { table = _table; tableIndex = _tableIndex; }
+
+		//overwrites a sub rectangle of the texture with tightly packed rgba8 pixels, only for textures without mips
+		//doesn't wait for the copy, it's batched in the render device's upload context and ordered before the next frame
+		void updateRegion(const void* pixels, int32_t x, int32_t y, uint32_t regionWidth, uint32_t regionHeight);
+		//graphics timeline value the latest upload is done at, check it with NYRenderDevice::isValueReached()
+		//submits the upload context's batch if the latest upload is still sitting in it
+		uint64_t getUploadValue();
+		//true once frames recorded from now on can sample it, streamed textures get there a frame or two after they're made
+		bool isReady() { return ready; }
 	private:
 
-		void createImage();
+		void createImage(const DecodedImage& decoded);
+		void createImageKTX2(NYKTX2& ktx2);
+		void allocateImage();
+		void uploadRegion(const void* pixels, int32_t x, int32_t y, uint32_t regionWidth, uint32_t regionHeight, VkImageLayout oldLayout);
 		void createImageView();
 		void createSampler();
 
-		void transitionLayout(VkImage& image, vk::Format format, VkImageLayout oldLayout, VkImageLayout newLayout);
-		void copyBufferToImage(VkBuffer& buffer, VkImage& image, uint32_t width, uint32_t height);
+		void transitionLayout(vk::CommandBuffer& commandBuffer, VkImage& image, vk::Format format, VkImageLayout oldLayout, VkImageLayout newLayout);
+		void copyBufferToImage(vk::CommandBuffer& commandBuffer, VkBuffer& buffer, vk::DeviceSize bufferOffset, VkImage& image, int32_t x, int32_t y, uint32_t width, uint32_t height);
 
 
 		NYRenderDevice& renderDevice;
@@ -33,5 +84,16 @@ namespace Nya {
 		std::string filepath;
 
 		int width, height, channels;
+		uint32_t mipLevels = 1;
+		vk::Format format = vk::Format::eR8G8B8A8Srgb;
+		NYTextureCreateInfo createInfo;
+
+		uint64_t uploadValue = 0;
+		//upload context batch the latest updateRegion() went into, 0 once it's been resolved to a value
+		uint64_t uploadBatch = 0;
+		bool ready = false;
+
+		NYTextureTable* table = nullptr;
+		uint32_t tableIndex = UINT32_MAX;
 	};
 }
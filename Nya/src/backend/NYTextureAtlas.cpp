@@ -0,0 +1,243 @@
+#include "pch.hpp"
+#include "NYTextureAtlas.hpp"
+#include "logging/NYLogger.hpp"
+#include "stb/stb_image.h"
+//imgui_draw.cpp compiles its own static copy, so this one has to be static as well
+#define STB_RECT_PACK_IMPLEMENTATION
+#define STBRP_STATIC
+#include "imgui/imstb_rectpack.h"
+
+namespace Nya {
+	struct NYTextureAtlas::Page {
+		std::unique_ptr<NYTexture> texture;
+		stbrp_context context;
+		//the skyline packer wants at least as many nodes as the page is wide
+		std::vector<stbrp_node> nodes;
+		std::vector<Handle> handles;
+		uint64_t freedArea = 0;
+	};
+
+	NYTextureAtlas::NYTextureAtlas(NYRenderDevice& _renderDevice, NYTextureTable& _textureTable, NYTextureAtlasCreateInfo _createInfo)
+		:renderDevice(_renderDevice), textureTable(_textureTable), createInfo(_createInfo) {
+		NYLogger::checkAssert(createInfo.pageSize > 0 && createInfo.pageSize <= 0xffff, "NYTextureAtlas page size must be between 1 and 65535");
+	}
+
+	NYTextureAtlas::~NYTextureAtlas(){
+		NYLogger::logTrace("NYTextureAtlas destroyed with %d pages", static_cast<int>(pages.size()));
+	}
+
+	NYTextureAtlas::Handle NYTextureAtlas::add(std::string filepath){
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+
+		if (!pixels) {
+			NYLogger::logError("Failed to load image %s", filepath.c_str());
+			return invalidHandle;
+		}
+
+		Handle handle = add(pixels, width, height);
+		stbi_image_free(pixels);
+		return handle;
+	}
+
+	NYTextureAtlas::Handle NYTextureAtlas::add(const uint8_t* pixels, uint32_t width, uint32_t height){
+		NYLogger::checkAssert(width > 0 && height > 0, "Can't add an empty image to NYTextureAtlas");
+
+		Handle handle;
+		if (!freeHandles.empty()) {
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		else {
+			handle = static_cast<Handle>(entries.size());
+			entries.emplace_back();
+		}
+
+		Entry& entry = entries[handle];
+		entry.width = width;
+		entry.height = height;
+		entry.pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		entry.alive = true;
+
+		NYLogger::checkAssert(slotWidth(entry) <= createInfo.pageSize && slotHeight(entry) <= createInfo.pageSize,
+			"Image is too big to fit in an atlas page");
+
+		//try the existing pages first, then the ones that free up space when repacked, and only then make a new page
+		if (!placeEntry(handle)) {
+			repackFragmentedPages();
+			if (!placeEntry(handle)) {
+				NYLogger::checkAssert(packIntoPage(createPage(), handle), "Failed to pack image into an empty atlas page");
+			}
+		}
+
+		writeEntry(handle);
+		return handle;
+	}
+
+	void NYTextureAtlas::remove(Handle handle){
+		NYLogger::checkAssert(handle < entries.size() && entries[handle].alive, "NYTextureAtlas::remove() called with an invalid handle");
+
+		Entry& entry = entries[handle];
+		Page& page = *pages[entry.page];
+
+		//the skyline packer can't reuse the space, it's reclaimed when the page gets repacked
+		page.freedArea += static_cast<uint64_t>(slotWidth(entry)) * slotHeight(entry);
+		page.handles.erase(std::find(page.handles.begin(), page.handles.end(), handle));
+
+		entry.alive = false;
+		entry.pixels.clear();
+		entry.pixels.shrink_to_fit();
+		freeHandles.push_back(handle);
+	}
+
+	NYTextureAtlas::Region NYTextureAtlas::getRegion(Handle handle){
+		NYLogger::checkAssert(handle < entries.size() && entries[handle].alive, "NYTextureAtlas::getRegion() called with an invalid handle");
+
+		Entry& entry = entries[handle];
+		float pageSize = static_cast<float>(createInfo.pageSize);
+		uint32_t border = createInfo.padding + createInfo.extrusion;
+
+		Region region;
+		region.uvRect = glm::vec4((entry.x + border) / pageSize, (entry.y + border) / pageSize, entry.width / pageSize, entry.height / pageSize);
+		region.textureIndex = pages[entry.page]->texture->getTableIndex();
+		return region;
+	}
+
+	float NYTextureAtlas::getFragmentation(uint32_t pageIndex){
+		NYLogger::checkAssert(pageIndex < pages.size(), "pageIndex parameter in NYTextureAtlas::getFragmentation() is out of range");
+		return static_cast<float>(pages[pageIndex]->freedArea) / (static_cast<float>(createInfo.pageSize) * createInfo.pageSize);
+	}
+
+	void NYTextureAtlas::repackFragmentedPages(){
+		for (uint32_t i = 0; i < pages.size(); i++) {
+			if (getFragmentation(i) >= createInfo.repackThreshold) {
+				repackPage(i);
+			}
+		}
+	}
+
+	void NYTextureAtlas::repackPage(uint32_t pageIndex){
+		NYLogger::checkAssert(pageIndex < pages.size(), "pageIndex parameter in NYTextureAtlas::repackPage() is out of range");
+		Page& page = *pages[pageIndex];
+
+		stbrp_init_target(&page.context, createInfo.pageSize, createInfo.pageSize, page.nodes.data(), static_cast<int>(page.nodes.size()));
+
+		//packing everything in one call lets the packer sort by height, which packs tighter than the order they were added in
+		std::vector<stbrp_rect> rects(page.handles.size());
+		for (size_t i = 0; i < rects.size(); i++) {
+			Entry& entry = entries[page.handles[i]];
+			rects[i].id = static_cast<int>(page.handles[i]);
+			rects[i].w = slotWidth(entry);
+			rects[i].h = slotHeight(entry);
+		}
+		stbrp_pack_rects(&page.context, rects.data(), static_cast<int>(rects.size()));
+
+		page.handles.clear();
+		page.freedArea = 0;
+
+		std::vector<uint8_t> pagePixels(static_cast<size_t>(createInfo.pageSize) * createInfo.pageSize * 4, 0);
+		std::vector<uint8_t> block;
+		std::vector<Handle> unpacked;
+
+		uint32_t border = createInfo.padding;
+		for (auto& rect : rects) {
+			Handle handle = static_cast<Handle>(rect.id);
+			if (!rect.was_packed) {
+				unpacked.push_back(handle);
+				continue;
+			}
+
+			Entry& entry = entries[handle];
+			entry.x = rect.x;
+			entry.y = rect.y;
+			page.handles.push_back(handle);
+
+			//compose the whole page on the cpu so it goes up in a single upload
+			buildExtrudedBlock(entry, block);
+			uint32_t blockWidth = entry.width + 2 * createInfo.extrusion;
+			uint32_t blockHeight = entry.height + 2 * createInfo.extrusion;
+			for (uint32_t row = 0; row < blockHeight; row++) {
+				size_t dst = ((static_cast<size_t>(entry.y) + border + row) * createInfo.pageSize + entry.x + border) * 4;
+				memcpy(&pagePixels[dst], &block[static_cast<size_t>(row) * blockWidth * 4], static_cast<size_t>(blockWidth) * 4);
+			}
+		}
+
+		page.texture->updateRegion(pagePixels.data(), 0, 0, createInfo.pageSize, createInfo.pageSize);
+
+		//the packer is order dependent, so whatever no longer fits moves to another page
+		for (Handle handle : unpacked) {
+			if (!placeEntry(handle)) {
+				NYLogger::checkAssert(packIntoPage(createPage(), handle), "Failed to pack image into an empty atlas page");
+			}
+			writeEntry(handle);
+		}
+
+		NYLogger::logTrace("NYTextureAtlas page %d repacked", pageIndex);
+	}
+
+	uint32_t NYTextureAtlas::createPage(){
+		auto& page = pages.emplace_back(std::make_unique<Page>());
+		page->texture = std::make_unique<NYTexture>(renderDevice, createInfo.pageSize, createInfo.pageSize);
+		textureTable.registerTexture(*page->texture);
+
+		page->nodes.resize(createInfo.pageSize);
+		stbrp_init_target(&page->context, createInfo.pageSize, createInfo.pageSize, page->nodes.data(), static_cast<int>(page->nodes.size()));
+
+		NYLogger::logTrace("NYTextureAtlas page %d created", static_cast<int>(pages.size() - 1));
+		return static_cast<uint32_t>(pages.size() - 1);
+	}
+
+	bool NYTextureAtlas::placeEntry(Handle handle){
+		for (uint32_t i = 0; i < pages.size(); i++) {
+			if (packIntoPage(i, handle)) { return true; }
+		}
+		return false;
+	}
+
+	bool NYTextureAtlas::packIntoPage(uint32_t pageIndex, Handle handle){
+		Page& page = *pages[pageIndex];
+		Entry& entry = entries[handle];
+
+		stbrp_rect rect{};
+		rect.id = static_cast<int>(handle);
+		rect.w = slotWidth(entry);
+		rect.h = slotHeight(entry);
+
+		//the context keeps its skyline between calls, so images can be added one at a time
+		stbrp_pack_rects(&page.context, &rect, 1);
+		if (!rect.was_packed) { return false; }
+
+		entry.page = pageIndex;
+		entry.x = rect.x;
+		entry.y = rect.y;
+		page.handles.push_back(handle);
+		return true;
+	}
+
+	void NYTextureAtlas::writeEntry(Handle handle){
+		Entry& entry = entries[handle];
+
+		std::vector<uint8_t> block;
+		buildExtrudedBlock(entry, block);
+
+		//the padding around it is never written, it stays cleared from when the page was created or repacked
+		pages[entry.page]->texture->updateRegion(block.data(), entry.x + createInfo.padding, entry.y + createInfo.padding,
+			entry.width + 2 * createInfo.extrusion, entry.height + 2 * createInfo.extrusion);
+	}
+
+	void NYTextureAtlas::buildExtrudedBlock(Entry& entry, std::vector<uint8_t>& block){
+		uint32_t extrusion = createInfo.extrusion;
+		uint32_t blockWidth = entry.width + 2 * extrusion;
+		uint32_t blockHeight = entry.height + 2 * extrusion;
+		block.resize(static_cast<size_t>(blockWidth) * blockHeight * 4);
+
+		//pixels outside the image are clamped to its nearest edge pixel
+		for (uint32_t y = 0; y < blockHeight; y++) {
+			uint32_t srcY = static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(y) - extrusion, 0, entry.height - 1));
+			for (uint32_t x = 0; x < blockWidth; x++) {
+				uint32_t srcX = static_cast<uint32_t>(std::clamp<int64_t>(static_cast<int64_t>(x) - extrusion, 0, entry.width - 1));
+				memcpy(&block[(static_cast<size_t>(y) * blockWidth + x) * 4], &entry.pixels[(static_cast<size_t>(srcY) * entry.width + srcX) * 4], 4);
+			}
+		}
+	}
+}
\ No newline at end of file
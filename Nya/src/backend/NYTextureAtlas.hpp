@@ -0,0 +1,85 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYTexture.hpp"
+#include "NYTextureTable.hpp"
+
+/*
+runtime texture atlas, packs many small images into a few large pages so sprites using them can share a texture
+-pages are NYTextures registered in the texture table, packing is done with the stb rect packer that ships with imgui
+-images can be added and removed at runtime, the handle stays valid when its image moves during a repack
+-each image is surrounded by extruded edge pixels and a transparent padding border so filtering doesn't bleed into neighbours
+*/
+
+namespace Nya {
+	class NYTextureAtlas {
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle invalidHandle = UINT32_MAX;
+
+		struct NYTextureAtlasCreateInfo {
+			uint32_t pageSize = 2048;
+			uint32_t padding = 2;//transparent border on every side of an image
+			uint32_t extrusion = 1;//edge pixels repeated outwards on every side of an image
+			float repackThreshold = 0.25f;//fraction of a page's area freed by removed images before it's worth repacking
+		};
+
+		//what a sprite needs to sample an image out of the atlas
+		struct Region {
+			glm::vec4 uvRect;//xy = offset, zw = size
+			uint32_t textureIndex;//slot of the page in the texture table
+		};
+
+		NYTextureAtlas(NYRenderDevice& _renderDevice, NYTextureTable& _textureTable, NYTextureAtlasCreateInfo _createInfo = NYTextureAtlasCreateInfo());
+		~NYTextureAtlas();
+
+		NYTextureAtlas(NYTextureAtlas const&) = delete;
+		NYTextureAtlas& operator=(NYTextureAtlas const&) = delete;
+
+		Handle add(std::string filepath);
+		//pixels are tightly packed rgba8 and are copied, the atlas keeps its own copy for repacking
+		Handle add(const uint8_t* pixels, uint32_t width, uint32_t height);
+		void remove(Handle handle);
+
+		Region getRegion(Handle handle);
+
+		//repacks every page whose freed area is above the threshold
+		void repackFragmentedPages();
+		void repackPage(uint32_t pageIndex);
+
+		uint32_t getPageCount() { return static_cast<uint32_t>(pages.size()); }
+		//fraction of the page's area taken by images that have since been removed
+		float getFragmentation(uint32_t pageIndex);
+
+	private:
+		struct Page;
+
+		struct Entry {
+			std::vector<uint8_t> pixels;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t page = 0;
+			//top left corner of the packed rect, padding included
+			int32_t x = 0;
+			int32_t y = 0;
+			bool alive = false;
+		};
+
+		uint32_t createPage();
+		bool placeEntry(Handle handle);
+		bool packIntoPage(uint32_t pageIndex, Handle handle);
+		void writeEntry(Handle handle);
+		void buildExtrudedBlock(Entry& entry, std::vector<uint8_t>& block);
+
+		uint32_t slotWidth(Entry& entry) { return entry.width + 2 * (createInfo.padding + createInfo.extrusion); }
+		uint32_t slotHeight(Entry& entry) { return entry.height + 2 * (createInfo.padding + createInfo.extrusion); }
+
+		NYRenderDevice& renderDevice;
+		NYTextureTable& textureTable;
+		NYTextureAtlasCreateInfo createInfo;
+
+		std::vector<std::unique_ptr<Page>> pages;
+		std::vector<Entry> entries;
+		std::vector<Handle> freeHandles;
+	};
+}
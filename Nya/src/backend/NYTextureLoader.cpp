@@ -0,0 +1,128 @@
+#include "pch.hpp"
+#include "NYTextureLoader.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+#include "utils/NYTimer.hpp"
+
+namespace Nya {
+	NYTextureLoader::NYTextureLoader(NYRenderDevice& _renderDevice, NYTextureTable& _textureTable, uint32_t threadCount)
+		:renderDevice(_renderDevice), textureTable(_textureTable) {
+		if (threadCount == 0) {
+			threadCount = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+		}
+		for (uint32_t i = 0; i < threadCount; i++) {
+			threads.emplace_back(&NYTextureLoader::decodeLoop, this, i);
+		}
+		NYLogger::logTrace("NYTextureLoader created with %u decoder threads", threadCount);
+	}
+
+	NYTextureLoader::~NYTextureLoader(){
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		workReady.notify_all();
+		for (std::thread& thread : threads) {
+			thread.join();
+		}
+		NYLogger::logTrace("NYTextureLoader destroyed");
+	}
+
+	NYTextureLoader::Future NYTextureLoader::load(const std::string& filepath, NYTexture::NYTextureCreateInfo createInfo){
+		std::unique_ptr<Request> request = std::make_unique<Request>();
+		request->filepath = filepath;
+		request->createInfo = createInfo;
+		Future future = request->promise.get_future().share();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			queue.push_back(std::move(request));
+			outstanding++;
+		}
+		workReady.notify_one();
+		return future;
+	}
+
+	void NYTextureLoader::update(){
+		std::vector<std::unique_ptr<Request>> ready;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (decoded.empty()) {
+				return;
+			}
+			ready = std::move(decoded);
+			decoded.clear();
+		}
+
+		NY_PROFILE_ZONE("texture loader update");
+		uint32_t loaded = 0;
+		uint32_t failed = 0;
+		for (auto& request : ready) {
+			if (!request->decoded.valid) {
+				failed++;
+				request->promise.set_value(nullptr);
+				continue;
+			}
+			//only the upload is recorded here, the pixels were decoded on a loader thread
+			std::shared_ptr<NYTexture> texture = std::make_shared<NYTexture>(renderDevice, request->decoded, request->createInfo);
+			textureTable.registerTexture(*texture);
+			loaded++;
+			request->promise.set_value(std::move(texture));
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		outstanding -= static_cast<uint32_t>(ready.size());
+		stats.loaded += loaded;
+		stats.failed += failed;
+	}
+
+	void NYTextureLoader::finish(){
+		NY_PROFILE_ZONE("texture loader finish");
+		while (true) {
+			update();
+			std::unique_lock<std::mutex> lock(mutex);
+			if (outstanding == 0) {
+				return;
+			}
+			imageDecoded.wait(lock, [this]() { return !decoded.empty(); });
+		}
+	}
+
+	NYTextureLoader::Stats NYTextureLoader::getStats(){
+		std::lock_guard<std::mutex> lock(mutex);
+		return stats;
+	}
+
+	void NYTextureLoader::decodeLoop(uint32_t threadIndex){
+		NY_PROFILE_THREAD("texture decoder " + std::to_string(threadIndex));
+		while (true) {
+			std::unique_ptr<Request> request;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				workReady.wait(lock, [this]() { return stopping || !queue.empty(); });
+				if (stopping) {
+					return;
+				}
+				request = std::move(queue.front());
+				queue.pop_front();
+			}
+
+			NYTimer timer;
+			NYAssetPack::Blob blob = assetPack ? assetPack->find(request->filepath) : NYAssetPack::Blob();
+			if (blob.data) {
+				request->decoded = NYTexture::decode(request->filepath, blob.data, blob.size);
+			}
+			else {
+				request->decoded = NYTexture::decode(request->filepath);
+			}
+			timer.endTimer();
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stats.fromPack += blob.data ? 1 : 0;
+				stats.decodeMillis += timer.getMillis();
+				decoded.push_back(std::move(request));
+			}
+			imageDecoded.notify_all();
+		}
+	}
+}
\ No newline at end of file
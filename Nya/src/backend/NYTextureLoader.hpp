@@ -0,0 +1,72 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYTexture.hpp"
+#include "NYTextureTable.hpp"
+#include "assets/NYAssetPack.hpp"
+#include <future>
+
+namespace Nya {
+	//loads textures without holding up the render thread on decoding
+	//files are read and decoded on the loader's own threads, one per core by default. decoded images wait in a queue
+	//until update() turns them into NYTextures on the render thread, registers them in the texture table and hands them
+	//out through the futures load() returned. from there they stream in like any other texture
+	class NYTextureLoader {
+	public:
+		using Future = std::shared_future<std::shared_ptr<NYTexture>>;
+
+		//0 leaves one core for the render thread and uses the rest
+		NYTextureLoader(NYRenderDevice& _renderDevice, NYTextureTable& _textureTable, uint32_t threadCount = 0);
+		~NYTextureLoader();
+
+		NYTextureLoader(NYTextureLoader const&) = delete;
+		NYTextureLoader& operator=(NYTextureLoader const&) = delete;
+
+		//queues the file and returns straight away. the future holds null if the file couldn't be loaded
+		//it's only fulfilled by update() or finish(), so don't block on it on the render thread before calling one of them
+		Future load(const std::string& filepath, NYTexture::NYTextureCreateInfo createInfo = NYTexture::NYTextureCreateInfo());
+		//files found in the pack are read out of its mapping instead of opened one by one, the rest still come off disk
+		//set it before loading anything, the pack has to outlive the loader
+		void setAssetPack(NYAssetPack* _assetPack) { assetPack = _assetPack; }
+		//render thread only, makes textures out of everything decoded so far and doesn't block
+		void update();
+		//render thread only, blocks until every load so far has been handed out
+		void finish();
+
+		struct Stats {
+			uint32_t loaded = 0;
+			uint32_t failed = 0;
+			uint32_t fromPack = 0;
+			float decodeMillis = 0.0f;//summed over every decoder thread
+		};
+		Stats getStats();
+		uint32_t getThreadCount() { return static_cast<uint32_t>(threads.size()); }
+
+	private:
+		struct Request {
+			std::string filepath;
+			NYTexture::NYTextureCreateInfo createInfo;
+			std::promise<std::shared_ptr<NYTexture>> promise;
+			NYTexture::DecodedImage decoded;
+		};
+
+		void decodeLoop(uint32_t threadIndex);
+
+		NYRenderDevice& renderDevice;
+		NYTextureTable& textureTable;
+		NYAssetPack* assetPack = nullptr;
+
+		//guards everything below, the decoder threads only hold it to take work and publish results
+		std::mutex mutex;
+		std::condition_variable workReady;
+		std::condition_variable imageDecoded;
+		std::deque<std::unique_ptr<Request>> queue;
+		std::vector<std::unique_ptr<Request>> decoded;
+		//loads that haven't been handed out by update() yet
+		uint32_t outstanding = 0;
+		Stats stats;
+		bool stopping = false;
+
+		std::vector<std::thread> threads;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "pch.hpp"
+#include "NYTextureStreamer.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+#include "utils/NYImageUtils.hpp"
+
+namespace Nya {
+	NYTextureStreamer::NYTextureStreamer(NYRenderDevice& _renderDevice, vk::DeviceSize ringSize)
+		:renderDevice(_renderDevice), dedicatedQueue(_renderDevice.hasTransferQueue()) {
+		graphicsFamily = renderDevice.getGraphicsQueueFamilyIndex();
+		transferFamily = dedicatedQueue ? renderDevice.getTransferQueueFamilyIndex() : graphicsFamily;
+
+		if (dedicatedQueue) {
+			transferContext = std::make_unique<NYUploadContext>(renderDevice, NYUploadContext::Queue::eTransfer, ringSize);
+			uploadContext = transferContext.get();
+		}
+		else {
+			uploadContext = &renderDevice.getUploadContext();
+		}
+		NYLogger::logTrace("NYTextureStreamer created");
+	}
+
+	NYTextureStreamer::~NYTextureStreamer(){
+		NYLogger::logTrace("NYTextureStreamer destroyed");
+	}
+
+	void NYTextureStreamer::upload(VkImage image, vk::Format format, const void* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, ReadyCallback onReady){
+		NY_PROFILE_ZONE("texture stream");
+		PendingImage pending{ image, width, height, mipLevels, mipLevels > 1 && supportsLinearBlit(format), std::move(onReady), 0 };
+
+		//every level that's copied, just the first one when the rest is blitted
+		std::vector<Level> levels;
+		vk::DeviceSize chainSize = 0;
+		uint32_t copiedLevels = pending.blitMips ? 1 : mipLevels;
+		for (uint32_t level = 0; level < copiedLevels; level++) {
+			uint32_t levelWidth = std::max(width >> level, 1u);
+			uint32_t levelHeight = std::max(height >> level, 1u);
+			vk::DeviceSize levelSize = static_cast<vk::DeviceSize>(levelWidth) * levelHeight * 4;
+			levels.push_back({ pixels, levelSize, levelWidth, levelHeight });
+			chainSize += levelSize;
+		}
+
+		//the cpu chain is built before record() takes the lock, it's the slow part
+		std::vector<uint8_t> chain;
+		if (copiedLevels > 1) {
+			NY_PROFILE_ZONE("cpu mips");
+			chain.resize(chainSize);
+			uint8_t* levelData = chain.data();
+			memcpy(levelData, pixels, levels[0].size);
+			levels[0].data = levelData;
+			for (uint32_t level = 1; level < copiedLevels; level++) {
+				NYImageUtils::downsample(levelData, levels[level - 1].width, levels[level - 1].height, levelData + levels[level - 1].size);
+				levelData += levels[level - 1].size;
+				levels[level].data = levelData;
+			}
+		}
+		record(std::move(pending), levels);
+	}
+
+	void NYTextureStreamer::uploadLevels(VkImage image, const std::vector<Level>& levels, ReadyCallback onReady){
+		NY_PROFILE_ZONE("texture stream");
+		NYLogger::checkAssert(!levels.empty(), "NYTextureStreamer::uploadLevels() needs at least one level");
+		PendingImage pending{ image, levels[0].width, levels[0].height, static_cast<uint32_t>(levels.size()), false, std::move(onReady), 0 };
+		record(std::move(pending), levels);
+	}
+
+	void NYTextureStreamer::record(PendingImage pending, const std::vector<Level>& levels){
+		//16 keeps every level's offset a multiple of the texel block size, for rgba8 and the bc formats alike
+		const vk::DeviceSize levelAlignment = 16;
+		std::vector<vk::BufferImageCopy> regions;
+		vk::DeviceSize size = 0;
+		for (uint32_t level = 0; level < levels.size(); level++) {
+			vk::BufferImageCopy region;
+			region.bufferOffset = size;
+			region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, 1);
+			region.imageExtent = vk::Extent3D(levels[level].width, levels[level].height, 1);
+			regions.push_back(region);
+			size = (size + levels[level].size + levelAlignment - 1) / levelAlignment * levelAlignment;
+		}
+
+		VkImage image = pending.image;
+		uint32_t mipLevels = pending.mipLevels;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		//staging first, running out of ring space can submit the batch and start a new one
+		NYUploadContext::Staging staging = uploadContext->allocateStaging(size, levelAlignment);
+		for (uint32_t level = 0; level < levels.size(); level++) {
+			memcpy(static_cast<uint8_t*>(staging.data) + regions[level].bufferOffset, levels[level].data, levels[level].size);
+			regions[level].bufferOffset += staging.offset;
+		}
+		vk::CommandBuffer commandBuffer = uploadContext->getCommandBuffer();
+
+		vk::ImageMemoryBarrier toTransfer = makeBarrier(image, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::AccessFlags(), vk::AccessFlagBits::eTransferWrite, 0, mipLevels);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, toTransfer);
+		commandBuffer.copyBufferToImage(vk::Buffer(staging.buffer), vk::Image(image), vk::ImageLayout::eTransferDstOptimal, regions);
+
+		//on the transfer queue this is the release half of the ownership transfer, update() records the acquire on the graphics queue
+		//the layout change has to be the same in both halves. images still to be blitted stay in transfer dst for the blits
+		vk::ImageLayout releasedLayout = pending.blitMips ? vk::ImageLayout::eTransferDstOptimal : vk::ImageLayout::eShaderReadOnlyOptimal;
+		if (dedicatedQueue) {
+			vk::ImageMemoryBarrier release = makeBarrier(image, vk::ImageLayout::eTransferDstOptimal, releasedLayout,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlags(), 0, mipLevels);
+			release.srcQueueFamilyIndex = transferFamily;
+			release.dstQueueFamilyIndex = graphicsFamily;
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eBottomOfPipe, vk::DependencyFlags(), nullptr, nullptr, release);
+		}
+		else if (pending.blitMips) {
+			recordMipBlits(commandBuffer, pending);
+		}
+		else {
+			vk::ImageMemoryBarrier toShader = makeBarrier(image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, 0, mipLevels);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), nullptr, nullptr, toShader);
+		}
+
+		recorded.push_back(std::move(pending));
+	}
+
+	void NYTextureStreamer::flush(){
+		std::vector<PendingImage> ready;
+		uint64_t readyValue = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (recorded.empty()) {
+				return;
+			}
+			NY_PROFILE_ZONE("texture stream flush");
+			//batches the ring forced out early signal lower values, so this covers every recorded image
+			uint64_t value = uploadContext->submit();
+
+			if (dedicatedQueue) {
+				for (auto& image : recorded) {
+					image.transferValue = value;
+					inFlight.push_back(std::move(image));
+				}
+				recorded.clear();
+			}
+			else {
+				//the graphics queue orders the copies before every frame submitted after them, so they're usable right away
+				readyValue = value;
+				ready = std::move(recorded);
+				recorded.clear();
+			}
+		}
+		for (auto& image : ready) {
+			image.onReady(readyValue);
+		}
+	}
+
+	void NYTextureStreamer::update(){
+		std::vector<PendingImage> ready;
+		uint64_t readyValue = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (inFlight.empty() || !uploadContext->isValueReached(inFlight.front().transferValue)) {
+				return;
+			}
+			NY_PROFILE_ZONE("texture stream acquire");
+
+			//every finished image is acquired with one barrier call in one submission, followed by the blits of the ones that need mips
+			std::vector<vk::ImageMemoryBarrier> acquires;
+			uint64_t acquiredValue = 0;
+			while (!inFlight.empty() && uploadContext->isValueReached(inFlight.front().transferValue)) {
+				PendingImage& image = inFlight.front();
+				vk::ImageMemoryBarrier acquire = image.blitMips ?
+					makeBarrier(image.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferDstOptimal,
+						vk::AccessFlags(), vk::AccessFlagBits::eTransferRead | vk::AccessFlagBits::eTransferWrite, 0, image.mipLevels) :
+					makeBarrier(image.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+						vk::AccessFlags(), vk::AccessFlagBits::eShaderRead, 0, image.mipLevels);
+				acquire.srcQueueFamilyIndex = transferFamily;
+				acquire.dstQueueFamilyIndex = graphicsFamily;
+				acquires.push_back(acquire);
+				acquiredValue = image.transferValue;
+				ready.push_back(std::move(image));
+				inFlight.pop_front();
+			}
+
+			vk::PipelineStageFlags acquireStages = vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eFragmentShader;
+			vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
+			commandBuffer.pipelineBarrier(acquireStages, acquireStages, vk::DependencyFlags(), nullptr, nullptr, acquires);
+			for (auto& image : ready) {
+				if (image.blitMips) {
+					recordMipBlits(commandBuffer, image);
+				}
+			}
+			//the timeline's already there, the wait is what orders the acquire after the release on the other queue
+			readyValue = renderDevice.submitSingleTimeCommandBuffers(commandBuffer, uploadContext->getTimeline(), acquiredValue, acquireStages);
+		}
+		for (auto& image : ready) {
+			image.onReady(readyValue);
+		}
+	}
+
+	void NYTextureStreamer::finish(){
+		flush();
+		uint64_t target = 0;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!inFlight.empty()) {
+				target = inFlight.back().transferValue;
+			}
+		}
+		if (target > 0) {
+			uploadContext->waitForValue(target);
+		}
+		update();
+	}
+
+	bool NYTextureStreamer::supportsLinearBlit(vk::Format format){
+		vk::FormatFeatureFlags features = renderDevice.getPhysicalDevice().getFormatProperties(format).optimalTilingFeatures;
+		vk::FormatFeatureFlags needed = vk::FormatFeatureFlagBits::eBlitSrc | vk::FormatFeatureFlagBits::eBlitDst | vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+		return (features & needed) == needed;
+	}
+
+	void NYTextureStreamer::recordMipBlits(vk::CommandBuffer commandBuffer, PendingImage& image){
+		int32_t levelWidth = static_cast<int32_t>(image.width);
+		int32_t levelHeight = static_cast<int32_t>(image.height);
+
+		for (uint32_t level = 1; level < image.mipLevels; level++) {
+			vk::ImageMemoryBarrier toSource = makeBarrier(image.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead, level - 1, 1);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, toSource);
+
+			int32_t nextWidth = std::max(levelWidth / 2, 1);
+			int32_t nextHeight = std::max(levelHeight / 2, 1);
+			vk::ImageBlit blit;
+			blit.srcSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level - 1, 0, 1);
+			blit.srcOffsets[1] = vk::Offset3D(levelWidth, levelHeight, 1);
+			blit.dstSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, level, 0, 1);
+			blit.dstOffsets[1] = vk::Offset3D(nextWidth, nextHeight, 1);
+			commandBuffer.blitImage(vk::Image(image.image), vk::ImageLayout::eTransferSrcOptimal, vk::Image(image.image), vk::ImageLayout::eTransferDstOptimal,
+				blit, vk::Filter::eLinear);
+
+			//the level's done being read from, it can go to the shaders
+			vk::ImageMemoryBarrier toShader = makeBarrier(image.image, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead, level - 1, 1);
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), nullptr, nullptr, toShader);
+
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+
+		vk::ImageMemoryBarrier lastToShader = makeBarrier(image.image, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead, image.mipLevels - 1, 1);
+		commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), nullptr, nullptr, lastToShader);
+	}
+
+	vk::ImageMemoryBarrier NYTextureStreamer::makeBarrier(VkImage image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+		uint32_t baseLevel, uint32_t levelCount){
+		vk::ImageMemoryBarrier barrier;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcAccessMask = srcAccess;
+		barrier.dstAccessMask = dstAccess;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, baseLevel, levelCount, 0, 1);
+		return barrier;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include "pch.hpp"
+#include "NYUploadContext.hpp"
+
+/*
+streams texture uploads through a transfer only queue family when the gpu has one, so loading doesn't hold up rendering
+-uploads go through an NYUploadContext on the transfer queue, everything since the last flush() is submitted as one batch
+-batches the transfer timeline has reached are handed to the graphics queue with a queue family ownership transfer
+-a texture is only usable once that's been submitted, until then sprites draw the texture table's placeholder
+-mip chains are blitted on the graphics queue, in the same command buffer as the copy or as the acquire when the copy ran on the transfer queue
+without a transfer only family the render device's graphics upload context is used and textures are usable as soon as it's submitted
+*/
+
+namespace Nya {
+	class NYTextureStreamer {
+	public:
+		//gets the graphics timeline value the image is usable at, from whichever thread called update() or flush()
+		using ReadyCallback = std::function<void(uint64_t)>;
+
+		NYTextureStreamer(NYRenderDevice& _renderDevice, vk::DeviceSize ringSize = 64 * 1024 * 1024);
+		~NYTextureStreamer();
+
+		NYTextureStreamer(NYTextureStreamer const&) = delete;
+		NYTextureStreamer& operator=(NYTextureStreamer const&) = delete;
+
+		//copies the tightly packed rgba8 pixels to staging right away, so they can be freed once this returns
+		//the image has to be in undefined layout and ends up in shader read only
+		//with more than one mip level the rest of the chain is blitted down from the first one on the graphics queue, formats that can't
+		//be blitted with linear filtering get it downsampled on the cpu instead. blitted images need transfer src usage
+		void upload(VkImage image, vk::Format format, const void* pixels, uint32_t width, uint32_t height, uint32_t mipLevels, ReadyCallback onReady);
+
+		//one level of data laid out the way the image's format expects, block compressed formats included
+		struct Level {
+			const void* data;
+			vk::DeviceSize size;
+			uint32_t width;
+			uint32_t height;
+		};
+		//copies precomputed levels as they are, level 0 first, with the same layout and lifetime rules as upload()
+		//nothing is blitted or decoded, so this is the path for cooked textures
+		void uploadLevels(VkImage image, const std::vector<Level>& levels, ReadyCallback onReady);
+		//submits everything uploaded since the last flush as one batch
+		void flush();
+		//hands the batches the transfer queue has finished over to the graphics queue, doesn't block
+		void update();
+		//flushes and blocks until every upload so far is usable
+		void finish();
+
+		bool usesTransferQueue() { return dedicatedQueue; }
+		NYUploadContext::Stats& getStats() { return uploadContext->getStats(); }
+
+	private:
+		struct PendingImage {
+			VkImage image;
+			uint32_t width;
+			uint32_t height;
+			uint32_t mipLevels;
+			//levels past the first are still to be blitted, always on the graphics queue since transfer queues can't blit
+			bool blitMips;
+			ReadyCallback onReady;
+			//transfer timeline value the copy is done at, once it's been submitted
+			uint64_t transferValue;
+		};
+
+		//copies the levels to staging and records them, the image is released or transitioned according to pending.blitMips
+		void record(PendingImage pending, const std::vector<Level>& levels);
+		bool supportsLinearBlit(vk::Format format);
+		//walks the chain down from level 0, which has to be in transfer dst like the rest, and leaves every level in shader read only
+		void recordMipBlits(vk::CommandBuffer commandBuffer, PendingImage& image);
+		vk::ImageMemoryBarrier makeBarrier(VkImage image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+			uint32_t baseLevel, uint32_t levelCount);
+
+		NYRenderDevice& renderDevice;
+		bool dedicatedQueue;
+		uint32_t transferFamily;
+		uint32_t graphicsFamily;
+
+		//only made when there's a transfer queue, uploadContext points at the render device's graphics one otherwise
+		std::unique_ptr<NYUploadContext> transferContext;
+		NYUploadContext* uploadContext;
+
+		//recorded and not submitted yet
+		std::vector<PendingImage> recorded;
+		//submitted to the transfer queue and not acquired yet, in submission order
+		std::deque<PendingImage> inFlight;
+		std::mutex mutex;
+	};
+}
\ No newline at end of file
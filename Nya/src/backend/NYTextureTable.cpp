@@ -0,0 +1,89 @@
+#include "pch.hpp"
+#include "NYTextureTable.hpp"
+#include "NYTexture.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+
+namespace Nya {
+	NYTextureTable::NYTextureTable(NYRenderDevice& _renderDevice):renderDevice(_renderDevice) {
+		//partially bound so unused slots don't need valid descriptors, update unused while pending so new textures
+		//can be registered while frames that don't use them are still in flight
+		layout.addBinding(vk::DescriptorType::eCombinedImageSampler, MAX_BINDLESS_TEXTURES, vk::ShaderStageFlagBits::eFragment,
+			vk::DescriptorBindingFlagBits::eUpdateAfterBind |
+			vk::DescriptorBindingFlagBits::ePartiallyBound |
+			vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending);
+		layout.buildLayout();
+
+		vk::DescriptorPoolCreateInfo poolInfo;
+		poolInfo.flags = vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind;
+		poolInfo.maxSets = 1;
+		poolInfo.setPoolSizes(layout.getPoolSizes(1));
+
+		pool = renderDevice.getDevice().createDescriptorPool(poolInfo);
+
+		vk::DescriptorSetAllocateInfo allocInfo;
+		allocInfo.descriptorPool = pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout.getLayout();
+
+		set = renderDevice.getDevice().allocateDescriptorSets(allocInfo).front();
+
+		//1x1 and cleared to transparent black, made through the graphics queue so it's usable from the first frame
+		placeholder = std::make_unique<NYTexture>(renderDevice, 1, 1);
+		placeholderIndex = registerTexture(*placeholder);
+		NYLogger::logTrace("NYTextureTable created");
+	}
+
+	NYTextureTable::~NYTextureTable(){
+		placeholder.reset();
+		//slot returns still waiting on the timeline point at this table, they're run now rather than after it's gone
+		renderDevice.waitForValue(renderDevice.getSubmittedValue());
+		renderDevice.collectReleases();
+		renderDevice.getDevice().destroyDescriptorPool(pool);
+	}
+
+	uint32_t NYTextureTable::registerTexture(NYTexture& texture) {
+		uint32_t slot;
+		if (!freeSlots.empty()) {
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else {
+			NYLogger::checkAssert(nextSlot < MAX_BINDLESS_TEXTURES, "NYTextureTable is full, raise MAX_BINDLESS_TEXTURES");
+			slot = nextSlot++;
+		}
+
+		writeSlot(slot, texture);
+		texture.setTableSlot(this, slot);
+		return slot;
+	}
+
+	void NYTextureTable::releaseTexture(NYTexture& texture) {
+		NYLogger::checkAssert(texture.getTableIndex() != UINT32_MAX, "NYTexture isn't registered in the table");
+		//frames in flight can still index the slot, it's only handed out again once they're done
+		uint32_t slot = texture.getTableIndex();
+		renderDevice.deferRelease(renderDevice.getSubmittedValue(), [this, slot]() {
+			freeSlots.push_back(slot);
+		});
+		texture.setTableSlot(nullptr, UINT32_MAX);
+	}
+
+	void NYTextureTable::writeSlot(uint32_t slot, NYTexture& texture) {
+		NY_PROFILE_ZONE("descriptor writes");
+		VkDescriptorImageInfo imageInfo;
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.sampler = texture.getSampler();
+		imageInfo.imageView = texture.getImageView();
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.dstArrayElement = slot;
+		write.dstBinding = 0;
+		write.dstSet = set;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(renderDevice.getDevice(), 1, &write, 0, nullptr);
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+#include "NYDescriptorSetLayout.hpp"
+#include "defines.hpp"
+
+/*
+global bindless texture table, a single partially bound sampler2D[] set that is bound once per frame
+-textures register into it and get a stable slot index
+-shaders index into the array with that slot, so swapping a texture is just changing an integer
+-slot 0 is a transparent placeholder that sprites draw instead of textures that are still streaming in
+*/
+
+namespace Nya {
+	class NYTexture;
+
+	class NYTextureTable {
+	public:
+		NYTextureTable(NYRenderDevice& _renderDevice);
+		~NYTextureTable();
+
+		NYTextureTable(NYTextureTable const&) = delete;
+		NYTextureTable& operator=(NYTextureTable const&) = delete;
+
+		//writes the texture into a free slot and returns the slot index, the texture remembers it as well
+		//textures still streaming in can be registered, their slot just mustn't be sampled before they're ready
+		uint32_t registerTexture(NYTexture& texture);
+		//frees the slot once the frames submitted so far are done with it, the descriptor is left as is since the binding is partially bound
+		void releaseTexture(NYTexture& texture);
+
+		uint32_t getPlaceholderIndex() { return placeholderIndex; }
+
+		NYDescriptorSetLayout& getLayout() { return layout; }
+		vk::DescriptorSet& getDescriptorSet() { return set; }
+	private:
+		void writeSlot(uint32_t slot, NYTexture& texture);
+
+		NYRenderDevice& renderDevice;
+
+		NYDescriptorSetLayout layout{ renderDevice };
+		vk::DescriptorPool pool;
+		vk::DescriptorSet set;
+
+		std::vector<uint32_t> freeSlots;
+		uint32_t nextSlot = 0;
+
+		std::unique_ptr<NYTexture> placeholder;
+		uint32_t placeholderIndex = UINT32_MAX;
+	};
+}
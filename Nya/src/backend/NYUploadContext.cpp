@@ -0,0 +1,359 @@
+#include "pch.hpp"
+#include "NYUploadContext.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYTimer.hpp"
+#include "utils/NYProfiler.hpp"
+
+namespace Nya {
+	NYUploadContext::NYUploadContext(NYRenderDevice& _renderDevice, Queue _queue, vk::DeviceSize _ringSize)
+		:renderDevice(_renderDevice), queue(_queue), ringSize(_ringSize) {
+		NYLogger::checkAssert(queue == Queue::eGraphics || renderDevice.hasTransferQueue(), "transfer NYUploadContexts need a device with a transfer queue");
+		uint32_t family = queue == Queue::eTransfer ? renderDevice.getTransferQueueFamilyIndex() : renderDevice.getGraphicsQueueFamilyIndex();
+
+		//command buffers are reset and reused once their batch is done
+		vk::CommandPoolCreateInfo poolInfo(vk::CommandPoolCreateFlagBits::eTransient | vk::CommandPoolCreateFlagBits::eResetCommandBuffer, family);
+		pool = renderDevice.getDevice().createCommandPool(poolInfo);
+
+		if (queue == Queue::eTransfer) {
+			vk::SemaphoreTypeCreateInfo typeInfo(vk::SemaphoreType::eTimeline, 0);
+			vk::SemaphoreCreateInfo semaphoreInfo;
+			semaphoreInfo.pNext = &typeInfo;
+			timeline = renderDevice.getDevice().createSemaphore(semaphoreInfo);
+		}
+		createRing();
+	}
+
+	NYUploadContext::~NYUploadContext(){
+		if (!inFlight.empty()) {
+			waitForValue(inFlight.back().value);
+		}
+		retire();
+		//a batch that was never submitted only has to give back its buffers, its command buffer goes with the pool
+		for (auto& oversized : openOversized) {
+			vmaDestroyBuffer(renderDevice.getAllocator(), oversized.buffer, oversized.allocation);
+		}
+		renderDevice.getDevice().destroyCommandPool(pool);
+		if (timeline) {
+			renderDevice.getDevice().destroySemaphore(timeline);
+		}
+		vmaDestroyBuffer(renderDevice.getAllocator(), ringBuffer, ringAllocation);
+	}
+
+	void NYUploadContext::createRing(){
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+		vk::BufferCreateInfo bufferInfo;
+		bufferInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
+		bufferInfo.size = ringSize;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+		auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+		VmaAllocationInfo allocationInfo;
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &ringBuffer, &ringAllocation, &allocationInfo);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create upload staging ring");
+		ringData = static_cast<uint8_t*>(allocationInfo.pMappedData);
+	}
+
+	NYUploadContext::Staging NYUploadContext::allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment){
+		if (!batchOpen) {
+			beginBatch();
+		}
+		stats.uploads++;
+		stats.bytes += size;
+
+		if (size > ringSize) {
+			stats.oversized++;
+			VmaAllocationCreateInfo allocInfo{};
+			allocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+			allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+			vk::BufferCreateInfo bufferInfo;
+			bufferInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
+			bufferInfo.size = size;
+			bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+			auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+			Oversized oversized;
+			VmaAllocationInfo allocationInfo;
+			auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &oversized.buffer, &oversized.allocation, &allocationInfo);
+			NYLogger::checkAssert(result == VK_SUCCESS, "failed to create staging buffer for an upload bigger than the ring");
+			openOversized.push_back(oversized);
+			return { allocationInfo.pMappedData, oversized.buffer, 0 };
+		}
+
+		vk::DeviceSize offset;
+		while (!tryAllocate(size, alignment, offset)) {
+			NY_PROFILE_ZONE("upload ring wait");
+			if (inFlight.empty()) {
+				//everything in the ring belongs to the open batch, it has to go out before any of it can come back
+				submitBatch();
+				beginBatch();
+			}
+			else {
+				stats.ringWaits++;
+				waitForValue(inFlight.front().value);
+			}
+			retire();
+		}
+		return { ringData + offset, ringBuffer, offset };
+	}
+
+	vk::CommandBuffer NYUploadContext::getCommandBuffer(){
+		if (!batchOpen) {
+			beginBatch();
+		}
+		return openCommandBuffer;
+	}
+
+	void NYUploadContext::uploadBuffer(VkBuffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size){
+		Staging staging = allocateStaging(size);
+		memcpy(staging.data, data, size);
+		vk::BufferCopy region(staging.offset, dstOffset, size);
+		getCommandBuffer().copyBuffer(vk::Buffer(staging.buffer), vk::Buffer(dst), region);
+	}
+
+	uint64_t NYUploadContext::submit(){
+		if (batchOpen) {
+			submitBatch();
+		}
+		retire();
+		return inFlight.empty() ? 0 : inFlight.back().value;
+	}
+
+	uint64_t NYUploadContext::getBatchValue(uint64_t batch){
+		if (batch == openBatch && batchOpen) {
+			submitBatch();
+		}
+		for (auto& submitted : inFlight) {
+			if (submitted.id == batch) {
+				return submitted.value;
+			}
+		}
+		return 0;
+	}
+
+	bool NYUploadContext::isValueReached(uint64_t value){
+		if (queue == Queue::eGraphics) {
+			return renderDevice.isValueReached(value);
+		}
+		return value <= renderDevice.getDevice().getSemaphoreCounterValue(timeline);
+	}
+
+	void NYUploadContext::waitForValue(uint64_t value){
+		if (queue == Queue::eGraphics) {
+			renderDevice.waitForValue(value);
+			return;
+		}
+		vk::SemaphoreWaitInfo waitInfo;
+		waitInfo.setSemaphores(timeline);
+		waitInfo.setValues(value);
+		auto result = renderDevice.getDevice().waitSemaphores(waitInfo, UINT64_MAX);
+		NYLogger::checkAssert(result == vk::Result::eSuccess, "failed to wait on the transfer timeline");
+	}
+
+	void NYUploadContext::beginBatch(){
+		if (freeCommandBuffers.empty()) {
+			vk::CommandBufferAllocateInfo allocInfo(pool, vk::CommandBufferLevel::ePrimary, 1);
+			openCommandBuffer = renderDevice.getDevice().allocateCommandBuffers(allocInfo).front();
+		}
+		else {
+			openCommandBuffer = freeCommandBuffers.back();
+			freeCommandBuffers.pop_back();
+		}
+
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		openCommandBuffer.begin(beginInfo);
+		openRingBytes = 0;
+		batchOpen = true;
+	}
+
+	uint64_t NYUploadContext::submitBatch(){
+		NY_PROFILE_ZONE("upload submit");
+		openCommandBuffer.end();
+		//the ring is host coherent on most gpus, where these do nothing
+		vmaFlushAllocation(renderDevice.getAllocator(), ringAllocation, 0, VK_WHOLE_SIZE);
+		for (auto& oversized : openOversized) {
+			vmaFlushAllocation(renderDevice.getAllocator(), oversized.allocation, 0, VK_WHOLE_SIZE);
+		}
+
+		uint64_t value;
+		if (queue == Queue::eGraphics) {
+			value = renderDevice.submitGraphics(openCommandBuffer);
+		}
+		else {
+			value = ++timelineValue;
+			vk::TimelineSemaphoreSubmitInfo timelineInfo;
+			timelineInfo.setSignalSemaphoreValues(value);
+			vk::SubmitInfo submitInfo;
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.setCommandBuffers(openCommandBuffer);
+			submitInfo.setSignalSemaphores(timeline);
+			renderDevice.getTransferQueue().submit(submitInfo);
+		}
+
+		inFlight.push_back({ openBatch, value, openCommandBuffer, head, openRingBytes, std::move(openOversized) });
+		openOversized.clear();
+		batchOpen = false;
+		openBatch++;
+		stats.submits++;
+		return value;
+	}
+
+	void NYUploadContext::retire(){
+		while (!inFlight.empty() && isValueReached(inFlight.front().value)) {
+			Batch& batch = inFlight.front();
+			//a batch without ring bytes owns nothing in it, its ringEnd can be from before the ring last started over
+			if (batch.ringBytes > 0) {
+				tail = batch.ringEnd;
+				ringUsed -= batch.ringBytes;
+			}
+			for (auto& oversized : batch.oversized) {
+				vmaDestroyBuffer(renderDevice.getAllocator(), oversized.buffer, oversized.allocation);
+			}
+			batch.commandBuffer.reset();
+			freeCommandBuffers.push_back(batch.commandBuffer);
+			inFlight.pop_front();
+		}
+	}
+
+	bool NYUploadContext::tryAllocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset){
+		//an empty ring starts over at the front, so big uploads don't have to wrap
+		if (ringUsed == 0) {
+			head = 0;
+			tail = 0;
+		}
+		vk::DeviceSize start = (head + alignment - 1) / alignment * alignment;
+		vk::DeviceSize consumed;
+
+		if (head >= tail && !(head == tail && ringUsed > 0)) {
+			if (start + size <= ringSize) {
+				consumed = start - head + size;
+			}
+			else if (size <= tail) {
+				//the rest of the end is skipped and handed back along with this allocation
+				consumed = ringSize - head + size;
+				start = 0;
+			}
+			else {
+				return false;
+			}
+		}
+		else {
+			if (start + size > tail) {
+				return false;
+			}
+			consumed = start - head + size;
+		}
+
+		offset = start;
+		head = start + size;
+		ringUsed += consumed;
+		openRingBytes += consumed;
+		return true;
+	}
+
+	void NYUploadContext::runBenchmark(NYRenderDevice& renderDevice, uint32_t textureCount, uint32_t size){
+		vk::DeviceSize textureBytes = static_cast<vk::DeviceSize>(size) * size * 4;
+		std::vector<uint8_t> pixels(textureBytes);
+		for (size_t i = 0; i < pixels.size(); i++) {
+			pixels[i] = static_cast<uint8_t>(i * 31);
+		}
+
+		VmaAllocationCreateInfo imageAllocInfo{};
+		imageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		vk::ImageCreateInfo imageInfo;
+		imageInfo.imageType = vk::ImageType::e2D;
+		imageInfo.extent = vk::Extent3D(size, size, 1);
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = vk::Format::eR8G8B8A8Unorm;
+		imageInfo.tiling = vk::ImageTiling::eOptimal;
+		imageInfo.initialLayout = vk::ImageLayout::eUndefined;
+		imageInfo.usage = vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled;
+		imageInfo.sharingMode = vk::SharingMode::eExclusive;
+		imageInfo.samples = vk::SampleCountFlagBits::e1;
+
+		std::vector<VkImage> images(textureCount);
+		std::vector<VmaAllocation> imageAllocations(textureCount);
+		for (uint32_t i = 0; i < textureCount; i++) {
+			renderDevice.createImage(images[i], static_cast<VkImageCreateInfo>(imageInfo), imageAllocInfo, imageAllocations[i]);
+		}
+
+		auto recordCopy = [&](vk::CommandBuffer commandBuffer, VkBuffer buffer, vk::DeviceSize offset, VkImage image) {
+			vk::ImageMemoryBarrier barrier;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange = vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+			barrier.oldLayout = vk::ImageLayout::eUndefined;
+			barrier.newLayout = vk::ImageLayout::eTransferDstOptimal;
+			barrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), nullptr, nullptr, barrier);
+
+			vk::BufferImageCopy region;
+			region.bufferOffset = offset;
+			region.imageSubresource = vk::ImageSubresourceLayers(vk::ImageAspectFlagBits::eColor, 0, 0, 1);
+			region.imageExtent = vk::Extent3D(size, size, 1);
+			commandBuffer.copyBufferToImage(vk::Buffer(buffer), vk::Image(image), vk::ImageLayout::eTransferDstOptimal, region);
+
+			barrier.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+			barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+			commandBuffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), nullptr, nullptr, barrier);
+		};
+
+		//a staging buffer, command buffer, submit and wait per texture, the way every upload used to go
+		NYTimer singleTimer;
+		for (uint32_t i = 0; i < textureCount; i++) {
+			VmaAllocationCreateInfo stagingAllocInfo{};
+			stagingAllocInfo.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+			stagingAllocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+			vk::BufferCreateInfo bufferInfo;
+			bufferInfo.usage = vk::BufferUsageFlagBits::eTransferSrc;
+			bufferInfo.size = textureBytes;
+			bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+			auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+			VkBuffer stagingBuffer;
+			VmaAllocation stagingAllocation;
+			VmaAllocationInfo allocationInfo;
+			NYLogger::checkAssert(vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &stagingAllocInfo, &stagingBuffer, &stagingAllocation, &allocationInfo) == VK_SUCCESS,
+				"failed to create benchmark staging buffer");
+			memcpy(allocationInfo.pMappedData, pixels.data(), textureBytes);
+
+			vk::CommandBuffer commandBuffer = renderDevice.beginSingleTimeCommandBuffers();
+			recordCopy(commandBuffer, stagingBuffer, 0, images[i]);
+			renderDevice.endSingleTimeCommandBuffers(commandBuffer);
+			vmaDestroyBuffer(renderDevice.getAllocator(), stagingBuffer, stagingAllocation);
+		}
+		singleTimer.endTimer();
+
+		//the same uploads again, the images are overwritten from undefined so nothing carries over
+		NYTimer contextTimer;
+		Stats contextStats;
+		{
+			NYUploadContext context(renderDevice, Queue::eGraphics);
+			for (uint32_t i = 0; i < textureCount; i++) {
+				Staging staging = context.allocateStaging(textureBytes);
+				memcpy(staging.data, pixels.data(), textureBytes);
+				recordCopy(context.getCommandBuffer(), staging.buffer, staging.offset, images[i]);
+			}
+			context.waitForValue(context.submit());
+			contextStats = context.getStats();
+		}
+		contextTimer.endTimer();
+
+		NYLogger::logInfo("upload benchmark, %u textures of %ux%u", textureCount, size, size);
+		NYLogger::logInfo("one submit per texture: %.2f ms, %u submits", singleTimer.getMillis(), textureCount);
+		NYLogger::logInfo("upload context: %.2f ms, %u submits, %u ring waits, %u oversized, %.2fx faster", contextTimer.getMillis(), contextStats.submits,
+			contextStats.ringWaits, contextStats.oversized, singleTimer.getMillis() / std::max(contextTimer.getMillis(), 0.001f));
+
+		for (uint32_t i = 0; i < textureCount; i++) {
+			vmaDestroyImage(renderDevice.getAllocator(), images[i], imageAllocations[i]);
+		}
+	}
+}
\ No newline at end of file
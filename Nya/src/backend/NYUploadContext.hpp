@@ -0,0 +1,122 @@
+#pragma once
+#include "pch.hpp"
+#include "NYRenderDevice.hpp"
+
+/*
+batches gpu uploads so loading many resources costs one submission instead of one each
+-staging comes out of one persistently mapped ring, space is handed back once the batch that used it is done on the gpu
+-copies and the barriers around them are recorded into the open batch's command buffer as they're made, nothing reaches the gpu until submit()
+-running out of ring space waits on the oldest batch in flight, uploads bigger than the whole ring get their own staging buffer
+-graphics contexts submit through the render device's timeline, transfer contexts submit to the transfer queue and signal their own
+*/
+
+namespace Nya {
+	class NYUploadContext {
+	public:
+		enum class Queue {
+			eGraphics,
+			eTransfer
+		};
+
+		struct Staging {
+			void* data;
+			VkBuffer buffer;
+			vk::DeviceSize offset;
+		};
+
+		struct Stats {
+			uint32_t submits = 0;
+			uint32_t uploads = 0;
+			vk::DeviceSize bytes = 0;
+			//times the ring was full and had to wait on the gpu
+			uint32_t ringWaits = 0;
+			//uploads too big for the ring
+			uint32_t oversized = 0;
+		};
+
+		//transfer contexts need NYRenderDevice::hasTransferQueue()
+		NYUploadContext(NYRenderDevice& _renderDevice, Queue _queue, vk::DeviceSize _ringSize = 32 * 1024 * 1024);
+		~NYUploadContext();
+
+		NYUploadContext(NYUploadContext const&) = delete;
+		NYUploadContext& operator=(NYUploadContext const&) = delete;
+
+		//space in the open batch, write the data before the batch is submitted
+		Staging allocateStaging(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+		//the open batch's command buffer, copies out of staging and their barriers go in here
+		//only record from one thread at a time, allocating staging can submit the batch and open a new one
+		vk::CommandBuffer getCommandBuffer();
+		//stages the data and records the copy, the caller is responsible for barriers around it
+		void uploadBuffer(VkBuffer dst, vk::DeviceSize dstOffset, const void* data, vk::DeviceSize size);
+
+		//id of the batch anything recorded right now goes into, for getBatchValue()
+		uint64_t getOpenBatch() { return openBatch; }
+		//submits the open batch if anything was recorded into it, returns the timeline value everything submitted so far is done at
+		uint64_t submit();
+		//timeline value the batch is done at, submits it first if it's still open. 0 if it's long done
+		uint64_t getBatchValue(uint64_t batch);
+
+		bool isValueReached(uint64_t value);
+		void waitForValue(uint64_t value);
+		//only transfer contexts have one, graphics contexts signal the render device's timeline
+		vk::Semaphore getTimeline() { return timeline; }
+
+		Stats& getStats() { return stats; }
+
+		//uploads textureCount textures of size x size through one submission per texture, like the single time command buffers did,
+		//and then through a context, and logs how long each took
+		static void runBenchmark(NYRenderDevice& renderDevice, uint32_t textureCount, uint32_t size);
+
+	private:
+		struct Oversized {
+			VkBuffer buffer;
+			VmaAllocation allocation;
+		};
+
+		struct Batch {
+			uint64_t id;
+			uint64_t value;
+			vk::CommandBuffer commandBuffer;
+			//ring space is freed front to back, so the batch only has to remember where its allocations ended
+			vk::DeviceSize ringEnd;
+			vk::DeviceSize ringBytes;
+			std::vector<Oversized> oversized;
+		};
+
+		void createRing();
+		void beginBatch();
+		uint64_t submitBatch();
+		//takes back the ring space and command buffers of every batch the gpu finished
+		void retire();
+		bool tryAllocate(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+
+		NYRenderDevice& renderDevice;
+		Queue queue;
+		vk::DeviceSize ringSize;
+
+		VkBuffer ringBuffer;
+		VmaAllocation ringAllocation;
+		uint8_t* ringData = nullptr;
+		//free space is [head, tail) when head < tail, and [head, end) plus [0, tail) otherwise
+		vk::DeviceSize head = 0;
+		vk::DeviceSize tail = 0;
+		vk::DeviceSize ringUsed = 0;
+
+		vk::CommandPool pool;
+		std::vector<vk::CommandBuffer> freeCommandBuffers;
+		vk::Semaphore timeline;
+		uint64_t timelineValue = 0;
+
+		//what's been recorded since the last submit
+		bool batchOpen = false;
+		uint64_t openBatch = 1;
+		vk::CommandBuffer openCommandBuffer;
+		vk::DeviceSize openRingBytes = 0;
+		std::vector<Oversized> openOversized;
+
+		//submitted and not known to be done yet, oldest first
+		std::deque<Batch> inFlight;
+
+		Stats stats;
+	};
+}
\ No newline at end of file
@@ -6,11 +6,12 @@
 //its pretty simple and nothing much to it
 namespace Nya {
 	NYWindow::NYWindow(uint32_t _width, uint32_t _height, const char* _title):width(_width), height(_height), title(_title) {
-		//TODO:resizing
 		glfwInit();
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
-		glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);\
+		glfwWindowHint(GLFW_RESIZABLE, GLFW_TRUE);
 		window = glfwCreateWindow(width, height, title, NULL, NULL);
+		glfwSetWindowUserPointer(window, this);
+		glfwSetFramebufferSizeCallback(window, framebufferSizeCallback);
 		glfwSetKeyCallback(window, NYInput::key_callback);
 		glfwSetMouseButtonCallback(window, NYInput::mouse_button_callback);
 		NYLogger::logTrace("NYWindow created");
@@ -22,4 +23,46 @@ namespace Nya {
 		NYLogger::logTrace("NYWindow destroyed");
 
 	}
+
+	vk::Extent2D NYWindow::getFramebufferExtent() {
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		return vk::Extent2D(static_cast<uint32_t>(framebufferWidth), static_cast<uint32_t>(framebufferHeight));
+	}
+
+	bool NYWindow::isMinimized() {
+		vk::Extent2D extent = getFramebufferExtent();
+		return extent.width == 0 || extent.height == 0;
+	}
+
+	bool NYWindow::consumeResize() {
+		bool wasResized = resized;
+		resized = false;
+		return wasResized;
+	}
+
+	void NYWindow::setFullscreen(bool fullscreen) {
+		if (fullscreen == isFullscreen()) {
+			return;
+		}
+		if (fullscreen) {
+			glfwGetWindowPos(window, &windowedX, &windowedY);
+			glfwGetWindowSize(window, &windowedWidth, &windowedHeight);
+			GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+			const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+			glfwSetWindowMonitor(window, monitor, 0, 0, mode->width, mode->height, mode->refreshRate);
+		}
+		else {
+			glfwSetWindowMonitor(window, nullptr, windowedX, windowedY, windowedWidth, windowedHeight, GLFW_DONT_CARE);
+		}
+		//the size callback covers this too, but not every platform calls it when the size ends up the same
+		resized = true;
+	}
+
+	void NYWindow::framebufferSizeCallback(GLFWwindow* window, int width, int height) {
+		NYWindow* nyWindow = static_cast<NYWindow*>(glfwGetWindowUserPointer(window));
+		nyWindow->resized = true;
+		nyWindow->width = static_cast<uint32_t>(width);
+		nyWindow->height = static_cast<uint32_t>(height);
+	}
 }
\ No newline at end of file
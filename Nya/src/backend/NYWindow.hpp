@@ -13,10 +13,28 @@ namespace Nya {
 		NYWindow& operator=(NYWindow const&) = delete;
 
 		inline GLFWwindow* getHandlePointer() { return window; }
+
+		//size in pixels, which is what the swapchain has to match. 0x0 while minimized
+		vk::Extent2D getFramebufferExtent();
+		bool isMinimized();
+		//true once after every change to the framebuffer size, the renderer rebuilds the swapchain when it sees it
+		bool consumeResize();
+
+		//fullscreen on the primary monitor at its current video mode, going back restores the old position and size
+		void setFullscreen(bool fullscreen);
+		bool isFullscreen() { return glfwGetWindowMonitor(window) != nullptr; }
+
 	private:
+		static void framebufferSizeCallback(GLFWwindow* window, int width, int height);
+
 		GLFWwindow* window;
 		uint32_t width;
 		uint32_t height;
 		const char* title;
+
+		bool resized = false;
+		//where the window was before going fullscreen
+		int windowedX = 0, windowedY = 0;
+		int windowedWidth = 0, windowedHeight = 0;
 	};
-}
+}
\ No newline at end of file
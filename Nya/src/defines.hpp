@@ -1,3 +1,13 @@
 #pragma once
 
 constexpr int MAX_FRAMES_IN_FLIGHT = 3;
+//size of the global bindless texture array
+constexpr uint32_t MAX_BINDLESS_TEXTURES = 4096;
+
+//how a sprite is blended, each mode needs its own pipeline since blend state is baked in
+enum class NYBlendMode : uint8_t {
+	eOpaque,
+	eAlpha,
+	eAdditive,
+	eCount
+};
\ No newline at end of file
@@ -1,80 +1,131 @@
 #include "pch.hpp"
 #include "game.hpp"
 #include "backend/NYInput.hpp"
+#include "logging/NYLogger.hpp"
+#include "backend/NYShaderCompiler.hpp"
+#include "utils/NYProfiler.hpp"
 
 namespace Nya {
-	Game::Game() { initBackend();};
+	Game::Game(GameCreateInfo _createInfo):createInfo(_createInfo) {
+		//pipelines compile in the background, so this mostly measures device setup and shader compiles on a cold cache
+		NYTimer timer;
+		initBackend();
+		timer.endTimer();
+		NYLogger::logInfo("backend initialized in %.2f ms", timer.getMillis());
+		NYShaderCompiler::logStats();
+		renderDevice.logPipelineStats();
+	};
 	Game::~Game() {
+		renderer->getPipelineLibrary().logStats();
 		renderDevice.getDevice().waitIdle();
 	};
 
 	void Game::initBackend() {
-		NYPipelineConfig pipelineConfig;
-		auto bindingDesc = NYSprite::getBindingDescriptions();
-		auto attribDesc = NYSprite::getAttributeDescriptions();
-
-		spriteLayout.addBinding(vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eAllGraphics);
-		spriteLayout.addBinding(vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eAllGraphics);
-		spriteLayout.buildLayout();
-
-		NYPipeline::createDefaultPipelineConfig(pipelineConfig, swapchain, bindingDesc, attribDesc);
-
-		makeRenderPasses();
-
-		pipeline = std::make_unique<NYPipeline>(renderDevice, pipelineConfig, spriteShader, spriteLayout, renderPass);
-		swapchain.createFrameBuffers(renderPass.getRenderpass());
+		//everything the game and its systems use, compiled side by side up front so the NYShaders below only read the cache
+		NYShaderCompiler::compileAll({
+			{ "src/shaders/sprite_batch.vert" },
+			{ "src/shaders/shader.frag" },
+			{ "src/shaders/sprite_cull.comp" } }, threadPool);
+		batchShader = std::make_unique<NYShader>(renderDevice, "src/shaders/sprite_batch.vert", "src/shaders/shader.frag");
+
+		NYPipelineConfig batchPipelineConfig;
+		auto instancedBindingDesc = NYSprite::getInstancedBindingDescriptions();
+		auto instancedAttribDesc = NYSprite::getInstancedAttributeDescriptions();
+		NYPipeline::createDefaultPipelineConfig(batchPipelineConfig, swapchain, instancedBindingDesc, instancedAttribDesc);
+
+		renderer = std::make_unique<NYRenderer>(renderDevice, swapchain, threadPool);
+		renderingSystem = std::make_unique<NYRenderingSystem>(*renderer, renderDevice, textureTable);
+		//one recording task per worker, each records its slice of the draws into a secondary command buffer
+		renderingSystem->setRecordingTaskCount(threadPool.getWorkerCount());
+
+		buildFrameGraph();
+
+		//set 0 is the camera, set 1 the texture table
+		NYFrameGraph& frameGraph = renderer->getFrameGraph();
+		batchPipelineConfig.subpass = frameGraph.getSubpass(spritePass);
+		std::vector<NYDescriptorSetLayout*> batchLayouts = { &renderingSystem->getCameraLayout(), &textureTable.getLayout() };
+		NYPipelineLibrary& pipelineLibrary = renderer->getPipelineLibrary();
+		pipelineLibrary.registerTarget("sprites", batchLayouts, frameGraph.getRenderPass(spritePass));
+		pipelineLibrary.registerShader(*batchShader);
+		//whatever the last run used starts compiling now, so the requests below mostly find their pipelines already queued
+		pipelineLibrary.prewarm("pipeline_library.bin");
+		for (size_t i = 0; i < static_cast<size_t>(NYBlendMode::eCount); i++) {
+			NYPipeline::setBlendMode(batchPipelineConfig, static_cast<NYBlendMode>(i));
+			renderingSystem->setBlendPipeline(static_cast<NYBlendMode>(i), pipelineLibrary.request(batchPipelineConfig, *batchShader, "sprites"));
+		}
 
-		renderer = std::make_unique<NYRenderer>(renderDevice, swapchain);
+		//the minimap sees more of the world in the top right corner
+		minimapCamera.viewport = glm::vec4(0.75f, 0.0f, 0.25f, 0.25f);
+		minimapCamera.zoom = 0.5f;
+		cameras = { &mainCamera, &minimapCamera };
 	}
 
-	void Game::makeRenderPasses() {
-		renderPass.addAttachment(swapchain.getSwapchainFormat(), vk::AttachmentLoadOp::eClear, vk::AttachmentStoreOp::eStore, vk::ImageLayout::eUndefined, vk::ImageLayout::eColorAttachmentOptimal);
-
-		//make a reference of the attachment to be used in the subpass
-		vk::AttachmentReference colorAttachmentRef = vk::AttachmentReference(0, vk::ImageLayout::eColorAttachmentOptimal);
-		std::vector<vk::AttachmentReference> colorAttachmentRefs;
-		colorAttachmentRefs.push_back(colorAttachmentRef);
-
-		std::vector<vk::AttachmentReference> inputAttachmentRefs;
+	void Game::buildFrameGraph() {
+		NYFrameGraph& frameGraph = renderer->getFrameGraph();
+		NYFrameGraph::Resource backbuffer = frameGraph.importSwapchain("backbuffer");
 
-		renderPass.addSubpass(colorAttachmentRefs, inputAttachmentRefs, nullptr);
+		//both passes draw straight to the backbuffer, so the graph merges them into two subpasses of one render pass
+		//headless there's no gui and the sprite pass is the only one
+		spritePass = renderingSystem->addSpritePass(backbuffer, glm::vec4(0.05f, 0.05f, 0.05f, 1.0f));
+		renderer->addGUIPass(backbuffer);
 
-		vk::SubpassDependency dependency;
-		dependency.setSrcSubpass(VK_SUBPASS_EXTERNAL);
-		dependency.setDstSubpass(0);
-		dependency.setSrcAccessMask(vk::AccessFlagBits::eNone);
-		dependency.setDstAccessMask(vk::AccessFlagBits::eColorAttachmentWrite);
-		dependency.setSrcStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		dependency.setDstStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
-		renderPass.addDependency(dependency);
-
-		renderPass.build();
+		renderer->compileFrameGraph();
 	}
 
 	void Game::init() {
-		textures.resize(2);
-		textures[0] = std::make_shared<NYTexture>(renderDevice, "res/1K-wood_plank_14_Dif.jpg");
-		textures[1] = std::make_shared<NYTexture>(renderDevice, "res/zoro_dressrosa_drip_black.png");
+		if (std::filesystem::exists("res.pack") && assetPack.open("res.pack")) {
+			textureLoader.setAssetPack(&assetPack);
+		}
+
+		//decoded in parallel on the loader's threads, the loader registers them in the table
+		std::vector<NYTextureLoader::Future> loads;
+		loads.push_back(textureLoader.load("res/1K-wood_plank_14_Dif.jpg"));
+		loads.push_back(textureLoader.load("res/zoro_dressrosa_drip_black.png"));
+		textureLoader.finish();
+		for (auto& load : loads) {
+			textures.push_back(load.get());
+		}
+		NYTextureLoader::Stats loaderStats = textureLoader.getStats();
+		NYLogger::logInfo("loaded %u textures on %u threads, %u from the asset pack, %f ms spent decoding", loaderStats.loaded, textureLoader.getThreadCount(),
+			loaderStats.fromPack, loaderStats.decodeMillis);
+
+		//small generated checkerboard to exercise the atlas path
+		std::vector<uint8_t> checker(16 * 16 * 4);
+		for (uint32_t y = 0; y < 16; y++) {
+			for (uint32_t x = 0; x < 16; x++) {
+				uint8_t value = ((x / 4 + y / 4) % 2) ? 255 : 40;
+				uint8_t* pixel = &checker[(y * 16 + x) * 4];
+				pixel[0] = value; pixel[1] = value; pixel[2] = value; pixel[3] = 255;
+			}
+		}
+		NYTextureAtlas::Handle checkerHandle = atlas.add(checker.data(), 16, 16);
 
-		sprites.resize(2);
-		sprites[0] = std::make_unique<NYSprite>(renderDevice);
+		sprites.resize(3);
+		sprites[0] = std::make_unique<NYSprite>();
 
 		sprites[0]->translation = glm::vec3(2.0f, 0.0f, 0.0f);
 		sprites[0]->rotation = glm::vec3(0.0f, 0.0f, 0.0f);
 		sprites[0]->scale = glm::vec3(2.0f, 2.0f, 1.0f);
 		sprites[0]->writeTexture(textures[0]);
 
-		sprites[1] = std::make_unique<NYSprite>(renderDevice);
+		sprites[1] = std::make_unique<NYSprite>();
 		sprites[1]->translation = glm::vec3(-2.0f, 0.0f, 0.0f);
 		sprites[1]->rotation = glm::vec3(0.0f, 0.0f, 0.0f);
 		sprites[1]->scale = glm::vec3(2.0f, 2.0f, 1.0f);
 		sprites[1]->writeTexture(textures[1]);
+		sprites[1]->blendMode = NYBlendMode::eAlpha;
+
+		sprites[2] = std::make_unique<NYSprite>();
+		sprites[2]->translation = glm::vec3(0.0f, 2.0f, 0.0f);
+		sprites[2]->scale = glm::vec3(1.0f, 1.0f, 1.0f);
+		sprites[2]->writeAtlasRegion(atlas, checkerHandle);
 
-		renderingSystem = std::make_unique<NYRenderingSystem>(*renderer, renderDevice, sprites);
 	}
 
 	void Game::update() {
-		float delta = 0.0f;
+		NY_PROFILE_ZONE("update");
+		//textures loaded after init show up here
+		textureLoader.update();
 		if (NYInput::isKeyPressed(GLFW_KEY_SPACE)) {
 			sprites[0]->writeTexture(textures[1]);
 		}
@@ -82,12 +133,33 @@ namespace Nya {
 			sprites[0]->writeTexture(textures[0]);
 		}
 
-		NYTimer timer;
-		renderingSystem->render(sprites, *pipeline);
-		timer.endTimer();
-		delta = timer.getSeconds();
-		glfwPollEvents();
-		//printf("%f ms\n", delta * 1000.0);
-		
+		float panSpeed = 0.05f;
+		if (NYInput::isKeyPressed(GLFW_KEY_LEFT)) { mainCamera.position.x -= panSpeed; }
+		if (NYInput::isKeyPressed(GLFW_KEY_RIGHT)) { mainCamera.position.x += panSpeed; }
+		if (NYInput::isKeyPressed(GLFW_KEY_DOWN)) { mainCamera.position.y -= panSpeed; }
+		if (NYInput::isKeyPressed(GLFW_KEY_UP)) { mainCamera.position.y += panSpeed; }
+
+		renderingSystem->renderBatch(sprites, cameras);
+		if (window) {
+			glfwPollEvents();
+		}
+	}
+
+	bool Game::shouldClose() {
+		return window && glfwWindowShouldClose(window->getHandlePointer());
+	}
+
+	void Game::saveFrame(const char* path) {
+		std::vector<uint8_t> pixels;
+		renderer->readback(pixels);
+
+		std::ofstream file(path, std::ios::binary);
+		NYLogger::checkAssert(file.is_open(), "failed to open the frame output file");
+		file << "P6\n" << createInfo.width << " " << createInfo.height << "\n255\n";
+		//ppm has no alpha, the offscreen images are rgba
+		for (size_t i = 0; i < pixels.size(); i += 4) {
+			file.write(reinterpret_cast<const char*>(&pixels[i]), 3);
+		}
+		NYLogger::logInfo("saved frame to %s", path);
 	}
 }
\ No newline at end of file
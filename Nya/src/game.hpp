@@ -5,39 +5,69 @@
 #include "backend/NYPipeline.hpp"
 #include "backend/NYRenderer.hpp"
 #include "utils/NYTimer.hpp"
+#include "utils/NYThreadPool.hpp"
 #include "game/NYSprite.hpp"
+#include "game/NYCamera2D.hpp"
 #include "systems/NYRenderingSystem.hpp"
 #include "backend/NYTexture.hpp"
+#include "backend/NYTextureTable.hpp"
+#include "backend/NYTextureAtlas.hpp"
+#include "backend/NYTextureLoader.hpp"
 #include "backend/NYShader.hpp"
-#include "backend/NYRenderpass.hpp"
 
 namespace Nya {
+	struct GameCreateInfo {
+		//renders into offscreen images without opening a window, for benchmarks and ci
+		bool headless = false;
+		uint32_t width = 1280;
+		uint32_t height = 720;
+	};
+
 	class Game {
 		public:
-			Game();
+			Game(GameCreateInfo _createInfo = GameCreateInfo());
 			~Game();
 
 			void init();
 			void update();
+			//true once the window's been closed, headless games run until the caller stops
+			bool shouldClose();
+			//headless only, writes the last rendered frame as a binary ppm
+			void saveFrame(const char* path);
+			//min/avg/max of every gpu profiler scope
+			void logGPUTimings() { renderer->getGPUProfiler().logStats(); }
 
-		NYWindow window{ 1280, 720, "testbed" };
 	private:
 		void initBackend();
-		void makeRenderPasses();
+		void buildFrameGraph();
 		void initRendering();
 
 	private:
-		NYRenderDevice::NYRenderDeviceCreateInfo renderDeviceInfo{ "testbed", VK_MAKE_VERSION(1, 0, 0) };
-		NYRenderDevice renderDevice{ renderDeviceInfo, window };
-		NYSwapchain swapchain{ renderDevice };
-
-		NYDescriptorSetLayout spriteLayout{ renderDevice };
-		NYShader spriteShader{ renderDevice, "src/shaders/shader.vert", "src/shaders/shader.frag" };
-		NYRenderPass renderPass{ renderDevice };
-		std::unique_ptr<NYPipeline> pipeline;
+		GameCreateInfo createInfo;
+		//null when headless
+		std::unique_ptr<NYWindow> window = createInfo.headless ? nullptr : std::make_unique<NYWindow>(createInfo.width, createInfo.height, "testbed");
+		NYRenderDevice::NYRenderDeviceCreateInfo renderDeviceInfo{ "testbed", VK_MAKE_VERSION(1, 0, 0), createInfo.headless };
+		NYRenderDevice renderDevice{ renderDeviceInfo, window.get() };
+		NYSwapchain swapchain{ renderDevice, vk::Extent2D(createInfo.width, createInfo.height) };
+
+		NYTextureTable textureTable{ renderDevice };
+		NYTextureAtlas atlas{ renderDevice, textureTable };
+		//res.pack made by NyaPack, used for whatever's in it when it's there. outlives the loader reading from it
+		NYAssetPack assetPack;
+		NYTextureLoader textureLoader{ renderDevice, textureTable };
+		//made in initBackend() once every shader's been compiled on the thread pool
+		//declared ahead of the renderer, its pipeline library's pipelines are made from it
+		std::unique_ptr<NYShader> batchShader;
+		NYThreadPool threadPool;
 		std::unique_ptr<NYRenderer> renderer;
 		std::unique_ptr<NYRenderingSystem> renderingSystem;
+		NYFrameGraph::Pass spritePass;
+
 
+		NYCamera2D mainCamera;
+		NYCamera2D minimapCamera;
+		//drawn in this order, so the minimap ends up on top
+		std::vector<NYCamera2D*> cameras;
 
 		std::vector<std::unique_ptr<NYSprite>> sprites;
 		std::vector<std::shared_ptr<NYTexture>> textures;
@@ -0,0 +1,35 @@
+#include "pch.hpp"
+#include "NYCamera2D.hpp"
+
+namespace Nya {
+	NYCamera2D::NYCamera2D(glm::vec2 _position, float _zoom, float _rotation)
+		:position(_position), zoom(_zoom), rotation(_rotation) {
+	}
+
+	NYCamera2D::~NYCamera2D(){
+	}
+
+	glm::mat4 NYCamera2D::getViewProjection(float aspectRatio) {
+		float halfWidth = 0.5f * viewWidth / zoom;
+		float halfHeight = halfWidth / aspectRatio;
+		glm::mat4 proj = glm::ortho(-halfWidth, halfWidth, -halfHeight, halfHeight);
+
+		//the view is the inverse of the camera's own transform
+		glm::mat4 view = glm::rotate(glm::mat4(1.0f), -rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+		view = glm::translate(view, glm::vec3(-position, 0.0f));
+
+		return proj * view;
+	}
+
+	glm::vec4 NYCamera2D::getWorldBounds(float aspectRatio) {
+		float halfWidth = 0.5f * viewWidth / zoom;
+		float halfHeight = halfWidth / aspectRatio;
+
+		//extents of the rotated view rect
+		float c = glm::abs(glm::cos(rotation));
+		float s = glm::abs(glm::sin(rotation));
+		glm::vec2 extents(halfWidth * c + halfHeight * s, halfWidth * s + halfHeight * c);
+
+		return glm::vec4(position - extents, position + extents);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	class NYCamera2D {
+	public:
+		//what the sprite shaders read from set 0, one per camera per frame
+		struct CameraData {
+			glm::mat4 viewProj;
+		};
+
+		NYCamera2D(glm::vec2 _position = glm::vec2(0.0f), float _zoom = 1.0f, float _rotation = 0.0f);
+		~NYCamera2D();
+
+		//aspect ratio is the one of the camera's viewport in pixels
+		glm::mat4 getViewProjection(float aspectRatio);
+		//axis aligned world space rect the camera can see, xy = min, zw = max
+		glm::vec4 getWorldBounds(float aspectRatio);
+
+		glm::vec2 position;
+		float zoom;//above 1 zooms in
+		float rotation;//radians, around z
+		//part of the render target the camera draws to, normalized, xy = offset, zw = size
+		glm::vec4 viewport = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+		//world units visible horizontally at a zoom of 1
+		float viewWidth = 10.0f;
+	};
+}
@@ -1,7 +1,8 @@
 #pragma once
 #include "pch.hpp"
 #include "backend/NYTexture.hpp"
-#include "backend/NYDescriptorSetLayout.hpp"
+#include "backend/NYTextureAtlas.hpp"
+#include "defines.hpp"
 
 namespace Nya {
 	class NYSprite {
@@ -11,33 +12,39 @@ namespace Nya {
 			glm::vec2 uv;
 		};
 
-		struct UniformObject {
-			alignas(16) glm::mat4 model;
-			alignas(16) glm::mat4 view;
-			alignas(16) glm::mat4 proj;
+		//per instance data used by the batched path, one of these per sprite in the instance buffer
+		struct InstanceData {
+			glm::mat4 model;
+			glm::vec4 uvRect;//xy = offset, zw = size
+			uint32_t textureIndex;//slot in the global texture table
+			uint32_t drawIndex;//indirect draw the instance belongs to, UINT32_MAX if it isn't culled on the gpu
+			//pads the struct to its std430 size so the culling shader can read the same buffer as an array
+			uint32_t padding[2];
 		};
 
-		struct PushData {
-			glm::mat4 transformMatrix;
-		};
-
-		NYSprite(NYRenderDevice& _renderDevice, glm::vec3 _translation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), glm::vec3 _rotation = glm::vec3(0.0f));
+		NYSprite(glm::vec3 _translation = glm::vec3(0.0f), glm::vec3 _scale = glm::vec3(1.0f), glm::vec3 _rotation = glm::vec3(0.0f));
 		~NYSprite();
 
-		void updateUniformBuffers(uint32_t frameIndex, UniformObject& ubo);
+		//only stores the texture's table slot, no descriptor writes
 		void writeTexture(std::shared_ptr<NYTexture>& texture);
-		vk::DescriptorSet& getDescriptorSet(uint32_t frameIndex) { return descriptorSets[frameIndex]; }
+		//samples from an image in an atlas instead, the region is looked up every time so it follows the image when its page is repacked
+		void writeAtlasRegion(NYTextureAtlas& atlas, NYTextureAtlas::Handle handle);
 
-		static std::array<vk::VertexInputBindingDescription, 1> getBindingDescriptions() {
-			std::array<vk::VertexInputBindingDescription, 1> bindingDescriptions;
+		//binding 0 is the shared unit quad, binding 1 steps once per instance
+		static std::array<vk::VertexInputBindingDescription, 2> getInstancedBindingDescriptions() {
+			std::array<vk::VertexInputBindingDescription, 2> bindingDescriptions;
 			bindingDescriptions[0].binding = 0;
 			bindingDescriptions[0].stride = sizeof(Vertex);
 			bindingDescriptions[0].inputRate = vk::VertexInputRate::eVertex;
+
+			bindingDescriptions[1].binding = 1;
+			bindingDescriptions[1].stride = sizeof(InstanceData);
+			bindingDescriptions[1].inputRate = vk::VertexInputRate::eInstance;
 			return bindingDescriptions;
 		}
 
-		static std::array<vk::VertexInputAttributeDescription, 2> getAttributeDescriptions() {
-			std::array<vk::VertexInputAttributeDescription, 2> attributeDescriptions;
+		static std::array<vk::VertexInputAttributeDescription, 8> getInstancedAttributeDescriptions() {
+			std::array<vk::VertexInputAttributeDescription, 8> attributeDescriptions;
 			attributeDescriptions[0].binding = 0;
 			attributeDescriptions[0].location = 0;
 			attributeDescriptions[0].format = vk::Format::eR32G32B32Sfloat;
@@ -48,45 +55,63 @@ namespace Nya {
 			attributeDescriptions[1].format = vk::Format::eR32G32Sfloat;
 			attributeDescriptions[1].offset = offsetof(Vertex, uv);
 
+			//a mat4 attribute takes up 4 locations, one per column
+			for (uint32_t i = 0; i < 4; i++) {
+				attributeDescriptions[2 + i].binding = 1;
+				attributeDescriptions[2 + i].location = 2 + i;
+				attributeDescriptions[2 + i].format = vk::Format::eR32G32B32A32Sfloat;
+				attributeDescriptions[2 + i].offset = offsetof(InstanceData, model) + sizeof(glm::vec4) * i;
+			}
+
+			attributeDescriptions[6].binding = 1;
+			attributeDescriptions[6].location = 6;
+			attributeDescriptions[6].format = vk::Format::eR32G32B32A32Sfloat;
+			attributeDescriptions[6].offset = offsetof(InstanceData, uvRect);
+
+			attributeDescriptions[7].binding = 1;
+			attributeDescriptions[7].location = 7;
+			attributeDescriptions[7].format = vk::Format::eR32Uint;
+			attributeDescriptions[7].offset = offsetof(InstanceData, textureIndex);
+
 			return attributeDescriptions;
 		}
 
-		std::array<Vertex, 4>& getVertices() { return vertices; }
-		std::array<uint32_t, 6>& getIndices() { return indices; }
+		//every sprite is the same quad so the geometry is shared
+		static std::array<Vertex, 4>& getVertices() { return vertices; }
+		static std::array<uint32_t, 6>& getIndices() { return indices; }
 
 		glm::vec3 translation;
 		glm::vec3 scale;
 		glm::vec3 rotation;
-
-		glm::mat4& transform_matrix();
-
-		NYRenderDevice& renderDevice;
-		NYDescriptorSetLayout layout{ renderDevice };
-
-		//rendering data
-		vk::DescriptorPool descPool;
-		std::vector<vk::DescriptorSet> descriptorSets;
-
-		std::vector<VkBuffer> uniformBuffers;
-		std::vector<VmaAllocation> uniformAllocations;
-		std::vector<void*> mappedUniformMems;
-		PushData pushData;
-		UniformObject ubo;
-
-		bool built = false;
+		//region of the texture the sprite samples from, the whole texture by default
+		//when the sprite uses an atlas it's relative to the atlas region instead
+		glm::vec4 uvRect = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+
+		//sprites are drawn layer by layer, inside a layer opaque sprites are grouped by state and aren't ordered against each other
+		//translucent ones are drawn back to front by translation.z
+		uint8_t layer = 0;
+		NYBlendMode blendMode = NYBlendMode::eOpaque;
+
+		//single sprite path, the rendering system builds all the matrices at once through NYTransformBatch instead
+		glm::mat4 transform_matrix();
+		std::shared_ptr<NYTexture>& getTexture() { return texture; }
+		uint32_t getTextureIndex();
+		//uvRect resolved against the atlas region if there is one
+		glm::vec4 getUVRect();
 
 	private:
+		//kept so the texture, and with it its table slot, stays alive while the sprite uses it
+		std::shared_ptr<NYTexture> texture;
+		uint32_t textureIndex = 0;
 
-		void createLayout();
-		void allocateDescriptors();
-		void createUniformBuffers();
-		void initDescriptors();
+		NYTextureAtlas* atlas = nullptr;
+		NYTextureAtlas::Handle atlasHandle = NYTextureAtlas::invalidHandle;
 
-		std::array<Vertex, 4> vertices = { Vertex{glm::vec3(0.5f,  0.5f, 0.0f), glm::vec2(1.0f, 1.0f)},
+		static inline std::array<Vertex, 4> vertices = { Vertex{glm::vec3(0.5f,  0.5f, 0.0f), glm::vec2(1.0f, 1.0f)},
 										   Vertex{glm::vec3(0.5f,  -0.5f, 0.0f), glm::vec2(1.0f, 0.0f)},
 										   Vertex{glm::vec3(-0.5f, 0.5f, 0.0f), glm::vec2(0.0f, 1.0f)},
 										   Vertex{glm::vec3(-0.5f, -0.5f, 0.0f), glm::vec2(0.0f, 0.0f)}};
 
-		std::array <uint32_t, 6> indices = { 0,1,2,1,3,2 };
+		static inline std::array <uint32_t, 6> indices = { 0,1,2,1,3,2 };
 	};
 }
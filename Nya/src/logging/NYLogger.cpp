@@ -5,18 +5,26 @@
 //TODO: variadic args
 namespace Nya {
 	void NYLogger::logMessage(const char* message, NYLogLevel logLevel, va_list arg_list){
+#ifdef _WIN32
 		//get the standard output handle using windows.h
 		HANDLE h = GetStdHandle(STD_OUTPUT_HANDLE);
 		//change the color used to print
 		//index into the afformentioned msgColors vector with the logLevel enum
 		SetConsoleTextAttribute(h, msgColors[logLevel]);
+#else
+		//everywhere else the terminal takes ansi escape codes
+		printf("%s", msgColors[logLevel]);
+#endif
 		//print the tag in front of the message
 		printf("%s", Tags[logLevel]);
 		//print the formatted message
 		vfprintf(stdout, message, arg_list);
+#ifdef _WIN32
 		printf("\n");
-
 		SetConsoleTextAttribute(h, defaultCol);
+#else
+		printf("%s\n", defaultCol);
+#endif
 	}
 
 	//pretty straightforward
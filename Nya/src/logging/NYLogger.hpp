@@ -33,6 +33,7 @@ namespace Nya{
 		//private method used in all the log methods
 		static void logMessage(const char* message, NYLogLevel logLevel, va_list arg_list);
 
+#ifdef _WIN32
 		//default console color , white(unintensified)
 		static const uint32_t defaultCol = FOREGROUND_RED | FOREGROUND_BLUE | FOREGROUND_GREEN;
 
@@ -49,6 +50,19 @@ namespace Nya{
 			//intensified green for trace 
 			FOREGROUND_GREEN| FOREGROUND_INTENSITY
 		};
+#else
+		//reset to the terminal's default
+		static inline const char* const defaultCol = "\033[0m";
+
+		//same colors as the windows console ones, as ansi escape codes
+		static const inline std::vector<const char*> msgColors = {
+			"\033[1;97;101m",
+			"\033[1;91m",
+			"\033[1;93m",
+			"\033[1;94m",
+			"\033[1;92m"
+		};
+#endif
 
 		//tags to be used before each message is logged, it again corresponds to the log levels in the enum
 		static const inline std::vector<const char*> Tags = {
@@ -1,13 +1,63 @@
 #include "pch.hpp"
 #include "game.hpp"
+#include "utils/NYTransformBatch.hpp"
+#include "utils/NYTimer.hpp"
+#include "logging/NYLogger.hpp"
+#include "utils/NYProfiler.hpp"
+#include "backend/NYUploadContext.hpp"
 
 
-int main() {
+int main(int argc, char** argv) {
 	using namespace Nya;
+	NY_PROFILE_THREAD("main");
+
+	//Nya.exe --bench-transforms [sprite count] runs the transform microbenchmark instead of the game
+	if (argc > 1 && strcmp(argv[1], "--bench-transforms") == 0) {
+		uint32_t count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 100000;
+		NYTransformBatch::runBenchmark(count, 100);
+		return 0;
+	}
+
+	//Nya.exe --bench-uploads [texture count] [size] times uploading textures one submission each against one upload context
+	//runs on a headless device, so it works without a display
+	if (argc > 1 && strcmp(argv[1], "--bench-uploads") == 0) {
+		uint32_t count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 500;
+		uint32_t size = argc > 3 ? static_cast<uint32_t>(std::strtoul(argv[3], nullptr, 10)) : 256;
+		NYRenderDevice::NYRenderDeviceCreateInfo deviceInfo{ "upload benchmark", VK_MAKE_VERSION(1, 0, 0), true, "" };
+		NYRenderDevice renderDevice(deviceInfo, nullptr);
+		NYUploadContext::runBenchmark(renderDevice, count, size);
+		return 0;
+	}
+
+	//Nya.exe --headless [frame count] [output.ppm] renders offscreen without a window, then reports the frame time
+	//and optionally saves the last frame, works on software implementations like lavapipe
+	if (argc > 1 && strcmp(argv[1], "--headless") == 0) {
+		uint32_t frameCount = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1000;
+		GameCreateInfo createInfo;
+		createInfo.headless = true;
+		Game game(createInfo);
+		game.init();
+		//with profiling compiled in the whole run is traced, for ci to keep around
+		NY_PROFILE_CAPTURE(frameCount, "headless_trace.json");
+
+		NYTimer timer;
+		for (uint32_t i = 0; i < frameCount; i++) {
+			game.update();
+		}
+		timer.endTimer();
+		NYLogger::logInfo("headless: %u frames, %f ms/frame", frameCount, timer.getMillis() / std::max(frameCount, 1u));
+		game.logGPUTimings();
+
+		if (argc > 3) {
+			game.saveFrame(argv[3]);
+		}
+		return 0;
+	}
+
 	Game game;
 	game.init();
 
-	while (!glfwWindowShouldClose(game.window.getHandlePointer())) {
+	while (!game.shouldClose()) {
 		game.update();
 	}
 }
\ No newline at end of file
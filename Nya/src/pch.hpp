@@ -13,14 +13,27 @@
 #include <algorithm>
 #include <set>
 #include <vector>
+#include <deque>
+#include <unordered_map>
+#include <type_traits>
 #include <memory>
+#ifdef _WIN32
 #include <Windows.h>
 #include <direct.h>
+#endif
 #include <stdio.h>
 #include <cassert>
+#include <cstring>
+#include <cstdarg>
 #include <optional>
 #include <fstream>
 #include <cstdlib>
 #include <string>
 #include <filesystem>
 #include <chrono>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
@@ -1,8 +1,11 @@
 #version 460
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec2 frag_uv;
+layout(location = 1) flat in uint frag_textureIndex;
 
-layout(binding = 1) uniform sampler2D texSampler;
+//global bindless texture table, set 0 is the camera
+layout(set = 1, binding = 0) uniform sampler2D textures[];
 
 
 layout(location = 0) out vec4 outColor;
@@ -14,7 +17,7 @@ void main() {
     float uvy_f = floor(uv.y);
     vec2 pix_uv = vec2(uvx_f/divisions, uvy_f/divisions);
 
-    vec4 texColor = texture(texSampler, pix_uv);
+    vec4 texColor = texture(textures[nonuniformEXT(frag_textureIndex)], pix_uv);
     
 
     if(texColor.w == 0.0){//transparency
@@ -0,0 +1,22 @@
+#version 460
+
+layout(location = 0) in vec3 pos;
+layout(location = 1) in vec2 uv;
+//per instance attributes, the mat4 takes up locations 2 to 5
+layout(location = 2) in mat4 model;
+layout(location = 6) in vec4 uvRect;
+layout(location = 7) in uint textureIndex;
+
+layout(location = 0) out vec2 frag_uv;
+layout(location = 1) flat out uint frag_textureIndex;
+
+//shared by every sprite the camera draws
+layout(set = 0, binding = 0) uniform Camera {
+    mat4 viewProj;
+} camera;
+
+void main() {
+    gl_Position = camera.viewProj * model * vec4(pos, 1.0);
+    frag_uv = uvRect.xy + uv * uvRect.zw;
+    frag_textureIndex = textureIndex;
+}
\ No newline at end of file
@@ -0,0 +1,200 @@
+#include "pch.hpp"
+#include "NYCullingSystem.hpp"
+#include "logging/NYLogger.hpp"
+#include "defines.hpp"
+#include "utils/NYProfiler.hpp"
+
+namespace Nya {
+	NYCullingSystem::NYCullingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice):
+		renderer(_renderer), renderDevice(_renderDevice) {
+		//the sets are only rewritten after their frame's fence has been waited on, so no update after bind is needed
+		//instances live in the frame ring, so they're bound with a dynamic offset instead of rewriting the set every frame
+		descLayout.addBinding(vk::DescriptorType::eStorageBufferDynamic, 1, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBindingFlags());
+		descLayout.addBinding(vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBindingFlags());
+		descLayout.addBinding(vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, vk::DescriptorBindingFlags());
+		descLayout.buildLayout();
+
+		cullPipeline = std::make_unique<NYComputePipeline>(renderDevice, cullShader, descLayout, sizeof(PushData));
+		renderer.getShaderWatcher().watch(*cullPipeline);
+
+		createDescriptorResources();
+		createDrawCommandBuffers();
+	}
+
+	NYCullingSystem::~NYCullingSystem(){
+		renderer.getShaderWatcher().unwatch(*cullPipeline);
+		for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			vmaUnmapMemory(renderDevice.getAllocator(), drawCommandAllocations[i]);
+			vmaDestroyBuffer(renderDevice.getAllocator(), drawCommandBuffers[i], drawCommandAllocations[i]);
+
+			if (visibleCapacities[i] == 0) { continue; }
+			vmaDestroyBuffer(renderDevice.getAllocator(), visibleBuffers[i], visibleAllocations[i]);
+		}
+
+		renderDevice.getDevice().destroyDescriptorPool(descPool);
+	}
+
+	void NYCullingSystem::createDescriptorResources() {
+		vk::DescriptorPoolCreateInfo poolInfo;
+		poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+		poolInfo.setPoolSizes(descLayout.getPoolSizes(MAX_FRAMES_IN_FLIGHT));
+
+		descPool = renderDevice.getDevice().createDescriptorPool(poolInfo);
+
+		std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, descLayout.getLayout());
+		vk::DescriptorSetAllocateInfo allocInfo;
+		allocInfo.descriptorPool = descPool;
+		allocInfo.setSetLayouts(layouts);
+
+		descSets = renderDevice.getDevice().allocateDescriptorSets(allocInfo);
+		descSetsDirty.resize(MAX_FRAMES_IN_FLIGHT, true);
+		descSetRingGenerations.resize(MAX_FRAMES_IN_FLIGHT, 0);
+
+		visibleBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		visibleAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+		visibleCapacities.resize(MAX_FRAMES_IN_FLIGHT, 0);
+	}
+
+	void NYCullingSystem::createDrawCommandBuffers() {
+		drawCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+		drawCommandAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+		mappedDrawCommands.resize(MAX_FRAMES_IN_FLIGHT, nullptr);
+		drawCommandCapacities.resize(MAX_FRAMES_IN_FLIGHT, 0);
+		drawCommandCounts.resize(MAX_FRAMES_IN_FLIGHT, 0);
+
+		for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			reserveDrawCommands(i, 1);
+		}
+	}
+
+	void NYCullingSystem::reserveDrawCommands(uint32_t frameIndex, size_t count) {
+		if (count <= drawCommandCapacities[frameIndex]) { return; }
+
+		if (drawCommandCapacities[frameIndex] != 0) {
+			vmaUnmapMemory(renderDevice.getAllocator(), drawCommandAllocations[frameIndex]);
+			vmaDestroyBuffer(renderDevice.getAllocator(), drawCommandBuffers[frameIndex], drawCommandAllocations[frameIndex]);
+		}
+
+		size_t capacity = std::max<size_t>(std::max<size_t>(count, drawCommandCapacities[frameIndex] * 2), 16);
+
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
+		std::array<uint32_t, 1> queueFamilyIndices = { renderDevice.getGraphicsQueueFamilyIndex() };
+
+		vk::BufferCreateInfo bufferInfo;
+		bufferInfo.setQueueFamilyIndices(queueFamilyIndices);
+		bufferInfo.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer;
+		bufferInfo.size = sizeof(VkDrawIndexedIndirectCommand) * capacity;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &drawCommandBuffers[frameIndex], &drawCommandAllocations[frameIndex], nullptr);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create draw command buffer");
+
+		vmaMapMemory(renderDevice.getAllocator(), drawCommandAllocations[frameIndex], &mappedDrawCommands[frameIndex]);
+		memset(mappedDrawCommands[frameIndex], 0, sizeof(VkDrawIndexedIndirectCommand) * capacity);
+
+		drawCommandCapacities[frameIndex] = capacity;
+		//the old counts went with the old buffer
+		drawCommandCounts[frameIndex] = 0;
+		descSetsDirty[frameIndex] = true;
+	}
+
+	void NYCullingSystem::reserveVisibleInstances(uint32_t frameIndex, size_t count) {
+		if (count <= visibleCapacities[frameIndex]) { return; }
+
+		if (visibleCapacities[frameIndex] != 0) {
+			vmaDestroyBuffer(renderDevice.getAllocator(), visibleBuffers[frameIndex], visibleAllocations[frameIndex]);
+		}
+
+		//same growth policy as the instance buffers it mirrors
+		size_t capacity = std::max<size_t>(std::max<size_t>(count, visibleCapacities[frameIndex] * 2), 1024);
+
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+		std::array<uint32_t, 1> queueFamilyIndices = { renderDevice.getGraphicsQueueFamilyIndex() };
+
+		vk::BufferCreateInfo bufferInfo;
+		bufferInfo.setQueueFamilyIndices(queueFamilyIndices);
+		bufferInfo.usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eVertexBuffer;
+		bufferInfo.size = sizeof(NYSprite::InstanceData) * capacity;
+		bufferInfo.sharingMode = vk::SharingMode::eExclusive;
+
+		auto buffInfo = static_cast<VkBufferCreateInfo>(bufferInfo);
+
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &buffInfo, &allocInfo, &visibleBuffers[frameIndex], &visibleAllocations[frameIndex], nullptr);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create visible instance buffer");
+
+		visibleCapacities[frameIndex] = capacity;
+		descSetsDirty[frameIndex] = true;
+	}
+
+	void NYCullingSystem::writeDescriptorSet(uint32_t frameIndex) {
+		NY_PROFILE_ZONE("descriptor writes");
+		NYFrameRingBuffer& frameRing = renderer.getFrameRing();
+
+		std::array<vk::DescriptorBufferInfo, 3> bufferInfos;
+		bufferInfos[0] = vk::DescriptorBufferInfo(frameRing.getBuffer(), 0, frameRing.getBindRange());
+		bufferInfos[1] = vk::DescriptorBufferInfo(visibleBuffers[frameIndex], 0, VK_WHOLE_SIZE);
+		bufferInfos[2] = vk::DescriptorBufferInfo(drawCommandBuffers[frameIndex], 0, VK_WHOLE_SIZE);
+
+		std::array<vk::WriteDescriptorSet, 3> writes;
+		for (uint32_t i = 0; i < writes.size(); i++) {
+			writes[i].dstSet = descSets[frameIndex];
+			writes[i].dstBinding = i;
+			writes[i].descriptorCount = 1;
+			writes[i].descriptorType = descLayout.getType(i);
+			writes[i].pBufferInfo = &bufferInfos[i];
+		}
+
+		renderDevice.getDevice().updateDescriptorSets(writes, nullptr);
+		descSetsDirty[frameIndex] = false;
+		descSetRingGenerations[frameIndex] = frameRing.getGeneration();
+	}
+
+	void NYCullingSystem::cull(NYFrameRingBuffer::Allocation& instances, uint32_t instanceCount, glm::vec4 cameraRect, std::vector<uint32_t>& drawFirstInstances) {
+		NY_PROFILE_ZONE("cull");
+		uint32_t frameIndex = renderer.getFrameIndex();
+
+		//the frame's fence has been waited on, so the counts the shader wrote the last time this slot was used are final
+		VkDrawIndexedIndirectCommand* drawCommands = static_cast<VkDrawIndexedIndirectCommand*>(mappedDrawCommands[frameIndex]);
+		vmaInvalidateAllocation(renderDevice.getAllocator(), drawCommandAllocations[frameIndex], 0, sizeof(VkDrawIndexedIndirectCommand) * drawCommandCounts[frameIndex]);
+		lastVisibleCount = 0;
+		for (size_t i = 0; i < drawCommandCounts[frameIndex]; i++) {
+			lastVisibleCount += drawCommands[i].instanceCount;
+		}
+
+		reserveDrawCommands(frameIndex, drawFirstInstances.size());
+		drawCommands = static_cast<VkDrawIndexedIndirectCommand*>(mappedDrawCommands[frameIndex]);
+
+		for (size_t i = 0; i < drawFirstInstances.size(); i++) {
+			drawCommands[i].indexCount = NYSprite::getIndices().size();
+			drawCommands[i].instanceCount = 0;
+			drawCommands[i].firstIndex = 0;
+			drawCommands[i].vertexOffset = 0;
+			drawCommands[i].firstInstance = drawFirstInstances[i];
+		}
+		drawCommandCounts[frameIndex] = drawFirstInstances.size();
+		vmaFlushAllocation(renderDevice.getAllocator(), drawCommandAllocations[frameIndex], 0, sizeof(VkDrawIndexedIndirectCommand) * drawFirstInstances.size());
+
+		reserveVisibleInstances(frameIndex, instanceCount);
+		NYLogger::checkAssert(instances.buffer == renderer.getFrameRing().getBuffer(), "NYCullingSystem::cull() instances must come from the current frame ring buffer");
+		if (descSetsDirty[frameIndex] || descSetRingGenerations[frameIndex] != renderer.getFrameRing().getGeneration()) {
+			writeDescriptorSet(frameIndex);
+		}
+
+		PushData pushData;
+		pushData.cameraRect = cameraRect;
+		pushData.instanceCount = instanceCount;
+
+		renderer.bindComputePipeline(*cullPipeline);
+		uint32_t instanceOffset = static_cast<uint32_t>(instances.offset);
+		renderer.bindComputeDescriptorSet(*cullPipeline, descSets[frameIndex], 0, instanceOffset);
+		renderer.pushComputeConstants(*cullPipeline, &pushData, sizeof(PushData));
+		renderer.dispatch((instanceCount + workGroupSize - 1) / workGroupSize, 1, 1);
+		renderer.computeToDrawBarrier();
+	}
+}
\ No newline at end of file
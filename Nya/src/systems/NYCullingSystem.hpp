@@ -0,0 +1,72 @@
+#pragma once
+#include "pch.hpp"
+#include "backend/NYRenderer.hpp"
+#include "backend/NYComputePipeline.hpp"
+#include "backend/NYDescriptorSetLayout.hpp"
+#include "backend/NYShader.hpp"
+#include "game/NYSprite.hpp"
+
+//system that culls sprite instances against the camera on the gpu and writes the indirect draw for the visible ones
+namespace Nya {
+	class NYCullingSystem {
+	public:
+		struct PushData {
+			glm::vec4 cameraRect;//xy = min, zw = max, in world space
+			uint32_t instanceCount;
+		};
+
+		NYCullingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice);
+		~NYCullingSystem();
+
+		//records the culling dispatch, must be called after NYRenderer::beginFrame() and before the render pass begins
+		//every instance names its draw with InstanceData::drawIndex, drawFirstInstances holds where each draw's instances start
+		//visible instances are compacted into the same range of getVisibleBuffer(), their order isn't preserved
+		//instances must be allocated from the renderer's frame ring, they're read through a dynamic offset
+		void cull(NYFrameRingBuffer::Allocation& instances, uint32_t instanceCount, glm::vec4 cameraRect, std::vector<uint32_t>& drawFirstInstances);
+
+		//per frame outputs, bind the visible buffer as the instance buffer and draw with the draw command buffer
+		//draw i's command is at offset i * sizeof(VkDrawIndexedIndirectCommand)
+		VkBuffer& getVisibleBuffer(uint32_t frameIndex) { return visibleBuffers[frameIndex]; }
+		VkBuffer& getDrawCommandBuffer(uint32_t frameIndex) { return drawCommandBuffers[frameIndex]; }
+
+		//read back without stalling, so it lags MAX_FRAMES_IN_FLIGHT frames behind
+		uint32_t getLastVisibleCount() { return lastVisibleCount; }
+
+	private:
+		void createDescriptorResources();
+		void createDrawCommandBuffers();
+		void reserveDrawCommands(uint32_t frameIndex, size_t count);
+		void reserveVisibleInstances(uint32_t frameIndex, size_t count);
+		void writeDescriptorSet(uint32_t frameIndex);
+
+		NYRenderer& renderer;
+		NYRenderDevice& renderDevice;
+
+		NYShader cullShader{ renderDevice, "src/shaders/sprite_cull.comp" };
+		NYDescriptorSetLayout descLayout{ renderDevice };
+		std::unique_ptr<NYComputePipeline> cullPipeline;
+
+		vk::DescriptorPool descPool;
+		std::vector<vk::DescriptorSet> descSets;
+		//the sets only need rewriting when one of the buffers they point at gets reallocated
+		std::vector<bool> descSetsDirty;
+		std::vector<uint32_t> descSetRingGenerations;
+
+		//compacted instances, only ever touched by the gpu
+		std::vector<VkBuffer> visibleBuffers;
+		std::vector<VmaAllocation> visibleAllocations;
+		std::vector<size_t> visibleCapacities;
+
+		//VkDrawIndexedIndirectCommands, reset by the cpu and filled in by the culling shader
+		std::vector<VkBuffer> drawCommandBuffers;
+		std::vector<VmaAllocation> drawCommandAllocations;
+		std::vector<void*> mappedDrawCommands;
+		std::vector<size_t> drawCommandCapacities;
+		//how many commands the frame used, so their counts can be read back when it comes around again
+		std::vector<size_t> drawCommandCounts;
+
+		uint32_t lastVisibleCount = 0;
+
+		const uint32_t workGroupSize = 64;
+	};
+}
@@ -0,0 +1,75 @@
+#include "pch.hpp"
+#include "NYRenderQueue.hpp"
+#include "logging/NYLogger.hpp"
+
+namespace Nya {
+	uint64_t NYRenderQueue::makeKey(uint8_t layer, uint32_t pipeline, NYBlendMode blendMode, uint32_t texture, float depth) {
+		NYLogger::checkAssert(pipeline < maxPipelines, "pipeline doesn't fit in a render queue sort key");
+		NYLogger::checkAssert(texture < maxTextures, "texture doesn't fit in a render queue sort key");
+
+		uint64_t state = (static_cast<uint64_t>(pipeline) << 16) | (static_cast<uint64_t>(blendMode) << 14) | texture;
+		uint64_t key = static_cast<uint64_t>(layer) << 56;
+
+		if (blendMode == NYBlendMode::eOpaque) {
+			return key | (state << 32) | depthToBits(depth);
+		}
+
+		//farther away has to come first, so the depth is inverted
+		uint64_t depthBits = static_cast<uint32_t>(~depthToBits(depth));
+		return key | (1ull << 55) | (depthBits << 23) | state;
+	}
+
+	uint32_t NYRenderQueue::getPipeline(uint64_t key) {
+		uint64_t state = isTranslucent(key) ? key : key >> 32;
+		return static_cast<uint32_t>(state >> 16) & (maxPipelines - 1);
+	}
+
+	NYBlendMode NYRenderQueue::getBlendMode(uint64_t key) {
+		uint64_t state = isTranslucent(key) ? key : key >> 32;
+		return static_cast<NYBlendMode>((state >> 14) & 0x3);
+	}
+
+	uint32_t NYRenderQueue::getTexture(uint64_t key) {
+		uint64_t state = isTranslucent(key) ? key : key >> 32;
+		return static_cast<uint32_t>(state) & (maxTextures - 1);
+	}
+
+	uint32_t NYRenderQueue::depthToBits(float depth) {
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(float));
+		//negative floats sort backwards when read as integers, so flip all their bits, positive ones only need the sign bit set
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	void NYRenderQueue::sort() {
+		if (entries.size() < 2) { return; }
+
+		//count all 8 digits in a single read of the keys
+		std::array<std::array<uint32_t, 256>, 8> histograms{};
+		for (auto& entry : entries) {
+			for (uint32_t digit = 0; digit < 8; digit++) {
+				histograms[digit][(entry.key >> (digit * 8)) & 0xff]++;
+			}
+		}
+
+		scratch.resize(entries.size());
+		for (uint32_t digit = 0; digit < 8; digit++) {
+			auto& histogram = histograms[digit];
+
+			//every key has the same value for this digit, so this pass wouldn't move anything
+			if (histogram[(entries[0].key >> (digit * 8)) & 0xff] == entries.size()) { continue; }
+
+			uint32_t offset = 0;
+			for (auto& count : histogram) {
+				uint32_t bucketSize = count;
+				count = offset;
+				offset += bucketSize;
+			}
+
+			for (auto& entry : entries) {
+				scratch[histogram[(entry.key >> (digit * 8)) & 0xff]++] = entry;
+			}
+			entries.swap(scratch);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+#include "pch.hpp"
+#include "defines.hpp"
+
+/*
+sort key render queue, every draw submission is packed into a 64 bit key and sorted with an lsd radix sort
+walking the sorted entries then only needs a state change where the relevant bits of the key change
+
+key layout, most significant bits first:
+opaque:      layer(8) | translucent = 0 (1) | pipeline(7) | blend(2) | texture(14) | depth(32) front to back
+translucent: layer(8) | translucent = 1 (1) | depth(32) back to front | pipeline(7) | blend(2) | texture(14)
+*/
+
+namespace Nya {
+	class NYRenderQueue {
+	public:
+		struct Entry {
+			uint64_t key;
+			uint32_t index;//whatever the submitter wants to find its draw by, usually an index into its own array
+		};
+
+		static constexpr uint32_t maxPipelines = 1 << 7;
+		static constexpr uint32_t maxTextures = 1 << 14;
+
+		NYRenderQueue() = default;
+		~NYRenderQueue() = default;
+
+		NYRenderQueue(NYRenderQueue const&) = delete;
+		NYRenderQueue& operator=(NYRenderQueue const&) = delete;
+
+		//translucent draws are ordered back to front inside their layer, opaque ones are grouped by state instead
+		static uint64_t makeKey(uint8_t layer, uint32_t pipeline, NYBlendMode blendMode, uint32_t texture, float depth);
+
+		static bool isTranslucent(uint64_t key) { return (key >> 55) & 1; }
+		static uint8_t getLayer(uint64_t key) { return static_cast<uint8_t>(key >> 56); }
+		static uint32_t getPipeline(uint64_t key);
+		static NYBlendMode getBlendMode(uint64_t key);
+		static uint32_t getTexture(uint64_t key);
+
+		void clear() { entries.clear(); }
+		void reserve(size_t count) { entries.reserve(count); scratch.reserve(count); }
+		void submit(uint64_t key, uint32_t index) { entries.push_back({ key, index }); }
+		//stable, so draws with equal keys keep their submission order
+		void sort();
+
+		std::vector<Entry>& getEntries() { return entries; }
+		size_t size() { return entries.size(); }
+
+	private:
+		//maps a float to an unsigned integer with the same ordering
+		static uint32_t depthToBits(float depth);
+
+		std::vector<Entry> entries;
+		std::vector<Entry> scratch;
+	};
+}
@@ -2,39 +2,51 @@
 #include "NYRenderingSystem.hpp"
 #include "logging/NYLogger.hpp"
 #include "utils/NYTimer.hpp"
+#include "defines.hpp"
+#include "utils/NYProfiler.hpp"
 
 namespace Nya {
-	NYRenderingSystem::NYRenderingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice, std::vector<std::unique_ptr<NYSprite>>& _sprites):
-		renderer(_renderer), renderDevice(_renderDevice) {
-		load(_sprites);
+	NYRenderingSystem::NYRenderingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice, NYTextureTable& _textureTable):
+		renderer(_renderer), renderDevice(_renderDevice), textureTable(_textureTable) {
+		createBatchResources();
+		createCameraResources();
+		blendPipelines.fill(UINT32_MAX);
+
+		renderer.addDebugCallback([this]() {
+			//culled draws start at their batch's first instance, which needs drawIndirectFirstInstance
+			if (renderDevice.getEnabledFeatures().drawIndirectFirstInstance) {
+				ImGui::Checkbox("GPU culling", &gpuCulling);
+				if (gpuCulling) {
+					ImGui::Text("Visible sprites: %u", cullingSystem.getLastVisibleCount());
+				}
+			}
+			else {
+				ImGui::Text("GPU culling unsupported (no drawIndirectFirstInstance)");
+			}
+			//each task records its slice of the draws on a worker thread into its own secondary command buffer
+			int taskCount = static_cast<int>(recordingTaskCount);
+			if (ImGui::SliderInt("Recording tasks", &taskCount, 1, 64)) {
+				setRecordingTaskCount(static_cast<uint32_t>(taskCount));
+			}
+			ImGui::Text("Draws: %u", stats.draws);
+			ImGui::Text("Pipeline binds: %u (saved %d, %u recorded)", stats.pipelineBinds, stats.pipelineBindsSaved, stats.recordedPipelineBinds);
+			ImGui::Text("Texture switches: %u (saved %d)", stats.textureSwitches, stats.textureSwitchesSaved);
+		});
 	}
 
 	NYRenderingSystem::~NYRenderingSystem(){
-		for (int i = 0; i < vertexBuffers.size(); i++) {
-			vmaDestroyBuffer(renderDevice.getAllocator(), vertexBuffers[i], vertexBufferAllocations[i]);
-			vmaDestroyBuffer(renderDevice.getAllocator(), indexBuffers[i], indexBufferAllocations[i]);
-		}
-
+		renderDevice.getDevice().destroyDescriptorPool(cameraPool);
+		vmaDestroyBuffer(renderDevice.getAllocator(), quadVertexBuffer, quadVertexAllocation);
+		vmaDestroyBuffer(renderDevice.getAllocator(), quadIndexBuffer, quadIndexAllocation);
 	}
 
-	void NYRenderingSystem::load(std::vector<std::unique_ptr<NYSprite>>& _sprites){
-
-		NYTimer timer;
-		vertexBuffers.clear();
-		indexBuffers.clear();
-
-		vertexBuffers.resize(_sprites.size());
-		vertexBufferAllocations.resize(_sprites.size());
-
-		indexBuffers.resize(_sprites.size());
-		indexBufferAllocations.resize(_sprites.size());
-
+	void NYRenderingSystem::createBatchResources() {
 		VmaAllocationCreateInfo allocInfo{};
-		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-		
+		allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+
 		std::array<uint32_t, 1> queueFamilyIndices = { renderDevice.getGraphicsQueueFamilyIndex() };
 
-		size_t vertexBuffSize = sizeof(NYSprite::Vertex) * _sprites[0]->getVertices().size();
+		size_t vertexBuffSize = sizeof(NYSprite::Vertex) * NYSprite::getVertices().size();
 
 		vk::BufferCreateInfo vertexBufferInfo;
 		vertexBufferInfo.setQueueFamilyIndices(queueFamilyIndices);
@@ -42,7 +54,7 @@ namespace Nya {
 		vertexBufferInfo.size = vertexBuffSize;
 		vertexBufferInfo.sharingMode = vk::SharingMode::eExclusive;
 
-		size_t indexBuffSize = sizeof(uint32_t) * _sprites[0]->getIndices().size();
+		size_t indexBuffSize = sizeof(uint32_t) * NYSprite::getIndices().size();
 
 		vk::BufferCreateInfo indexBufferInfo;
 		indexBufferInfo.setQueueFamilyIndices(queueFamilyIndices);
@@ -53,50 +65,328 @@ namespace Nya {
 		auto vertBuffInfo = static_cast<VkBufferCreateInfo>(vertexBufferInfo);
 		auto indexBuffInfo = static_cast<VkBufferCreateInfo>(indexBufferInfo);
 
-		for (int i = 0; i < _sprites.size(); i++) {
+		auto result = vmaCreateBuffer(renderDevice.getAllocator(), &vertBuffInfo, &allocInfo, &quadVertexBuffer, &quadVertexAllocation, nullptr);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create quad vertex buffer");
+
+		void* mappedMem;
+		vmaMapMemory(renderDevice.getAllocator(), quadVertexAllocation, &mappedMem);
+		memcpy(mappedMem, NYSprite::getVertices().data(), vertexBuffSize);
+		vmaUnmapMemory(renderDevice.getAllocator(), quadVertexAllocation);
+
+		result = vmaCreateBuffer(renderDevice.getAllocator(), &indexBuffInfo, &allocInfo, &quadIndexBuffer, &quadIndexAllocation, nullptr);
+		NYLogger::checkAssert(result == VK_SUCCESS, "failed to create quad index buffer");
+
+		vmaMapMemory(renderDevice.getAllocator(), quadIndexAllocation, &mappedMem);
+		memcpy(mappedMem, NYSprite::getIndices().data(), indexBuffSize);
+		vmaUnmapMemory(renderDevice.getAllocator(), quadIndexAllocation);
+	}
+
+	void NYRenderingSystem::createCameraResources() {
+		cameraLayout.addBinding(vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex, vk::DescriptorBindingFlags());
+		cameraLayout.buildLayout();
+
+		vk::DescriptorPoolCreateInfo poolInfo;
+		poolInfo.maxSets = MAX_FRAMES_IN_FLIGHT;
+		poolInfo.setPoolSizes(cameraLayout.getPoolSizes(MAX_FRAMES_IN_FLIGHT));
+
+		cameraPool = renderDevice.getDevice().createDescriptorPool(poolInfo);
+
+		std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, cameraLayout.getLayout());
+		vk::DescriptorSetAllocateInfo allocInfo;
+		allocInfo.descriptorPool = cameraPool;
+		allocInfo.setSetLayouts(layouts);
+
+		cameraSets = renderDevice.getDevice().allocateDescriptorSets(allocInfo);
+		cameraSetRingGenerations.resize(MAX_FRAMES_IN_FLIGHT, 0);
+	}
+
+	void NYRenderingSystem::writeCameraSet(uint32_t frameIndex) {
+		NY_PROFILE_ZONE("descriptor writes");
+		NYFrameRingBuffer& frameRing = renderer.getFrameRing();
+
+		vk::DescriptorBufferInfo bufferInfo(frameRing.getBuffer(), 0, sizeof(NYCamera2D::CameraData));
+
+		vk::WriteDescriptorSet write;
+		write.dstSet = cameraSets[frameIndex];
+		write.dstBinding = 0;
+		write.descriptorCount = 1;
+		write.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
+		write.pBufferInfo = &bufferInfo;
+
+		renderDevice.getDevice().updateDescriptorSets(write, nullptr);
+		cameraSetRingGenerations[frameIndex] = frameRing.getGeneration();
+	}
+
+	void NYRenderingSystem::setBlendPipeline(NYBlendMode blendMode, NYPipelineLibrary::Handle pipeline) {
+		auto iter = std::find(pipelines.begin(), pipelines.end(), pipeline);
+		if (iter == pipelines.end()) {
+			iter = pipelines.insert(pipelines.end(), pipeline);
+		}
+		blendPipelines[static_cast<size_t>(blendMode)] = static_cast<uint32_t>(std::distance(pipelines.begin(), iter));
+	}
+
+	void NYRenderingSystem::fillInstances(std::vector<std::unique_ptr<NYSprite>>& _sprites, bool cullingActive) {
+		NY_PROFILE_ZONE("fill instances");
+		uint32_t instanceCount = _sprites.size();
+
+		renderQueue.clear();
+		renderQueue.reserve(instanceCount);
+
+		//count what drawing in storage order would have cost
+		uint32_t unsortedPipelineBinds = 0;
+		uint32_t unsortedTextureSwitches = 0;
+		uint32_t lastPipeline = UINT32_MAX;
+		uint32_t lastTexture = UINT32_MAX;
+
+		for (uint32_t i = 0; i < instanceCount; i++) {
+			NYSprite& sprite = *_sprites[i];
+			uint32_t pipeline = blendPipelines[static_cast<size_t>(sprite.blendMode)];
+			NYLogger::checkAssert(pipeline != UINT32_MAX, "No pipeline set for a sprite's blend mode, call NYRenderingSystem::setBlendPipeline()");
+
+			uint32_t texture = sprite.getTextureIndex();
+			renderQueue.submit(NYRenderQueue::makeKey(sprite.layer, pipeline, sprite.blendMode, texture, sprite.translation.z), i);
+
+			if (pipeline != lastPipeline) { unsortedPipelineBinds++; lastPipeline = pipeline; }
+			if (texture != lastTexture) { unsortedTextureSwitches++; lastTexture = texture; }
+		}
+
+		renderQueue.sort();
+
+		transformBatch.clear();
+		transformBatch.reserve(instanceCount);
+
+		batches.clear();
+		drawFirstInstances.clear();
+		stats.textureSwitches = 0;
+		lastTexture = UINT32_MAX;
+
+		//written straight into the frame ring, it's flushed along with everything else when the frame ends
+		NYSprite::InstanceData* instances = static_cast<NYSprite::InstanceData*>(instanceAllocation.data);
+		auto& entries = renderQueue.getEntries();
+
+		for (uint32_t i = 0; i < entries.size(); i++) {
+			uint64_t key = entries[i].key;
+			NYSprite& sprite = *_sprites[entries[i].index];
 
-			auto result = vmaCreateBuffer(renderDevice.getAllocator(), &vertBuffInfo, &allocInfo, &vertexBuffers[i], &vertexBufferAllocations[i], nullptr);
+			uint32_t pipeline = NYRenderQueue::getPipeline(key);
+			uint8_t layer = NYRenderQueue::getLayer(key);
+			//culling compacts out of order, so translucent sprites skip it to stay back to front
+			bool culled = cullingActive && !NYRenderQueue::isTranslucent(key);
 
-			NYLogger::checkAssert(result == VK_SUCCESS, "failed to create vertex buffer");
+			//a draw keeps its instances in order, so only culled batches need splitting at layers
+			bool newBatch = batches.empty() || batches.back().pipeline != pipeline || batches.back().culled != culled ||
+				(culled && batches.back().layer != layer);
+			if (newBatch) {
+				Batch& batch = batches.emplace_back();
+				batch.pipeline = pipeline;
+				batch.firstInstance = i;
+				batch.instanceCount = 0;
+				batch.layer = layer;
+				batch.culled = culled;
+				batch.drawIndex = UINT32_MAX;
+				if (culled) {
+					batch.drawIndex = drawFirstInstances.size();
+					drawFirstInstances.push_back(i);
+				}
+			}
+			batches.back().instanceCount++;
 
-			void* mappedMem;
-			vmaMapMemory(renderDevice.getAllocator(), vertexBufferAllocations[i], &mappedMem);
-			memcpy(mappedMem, _sprites[i]->getVertices().data(), vertexBuffSize);
+			uint32_t texture = NYRenderQueue::getTexture(key);
+			if (texture != lastTexture) { stats.textureSwitches++; lastTexture = texture; }
 
-			vmaUnmapMemory(renderDevice.getAllocator(), vertexBufferAllocations[i]);
+			transformBatch.push(sprite.translation, sprite.scale, sprite.rotation);
+			instances[i].uvRect = sprite.getUVRect();
+			instances[i].textureIndex = texture;
+			instances[i].drawIndex = batches.back().drawIndex;
+		}
+
+		//the matrices are gathered in sorted order, so they land next to the rest of their instance
+		if (instanceCount > 0) {
+			transformBatch.compute(&instances[0].model, sizeof(NYSprite::InstanceData));
+		}
+
+		stats.pipelineBindsSaved = static_cast<int32_t>(unsortedPipelineBinds);
+		stats.textureSwitchesSaved = static_cast<int32_t>(unsortedTextureSwitches) - static_cast<int32_t>(stats.textureSwitches);
+	}
+
+	void NYRenderingSystem::renderBatch(std::vector<std::unique_ptr<NYSprite>>& _sprites, std::vector<NYCamera2D*>& cameras) {
+		NY_PROFILE_ZONE("render batch");
+		NYLogger::checkAssert(!pipelines.empty(), "NYRenderingSystem needs at least one pipeline, call setBlendPipeline()");
+		NYLogger::checkAssert(spritePass != UINT32_MAX, "NYRenderingSystem needs its pass in the frame graph, call addSpritePass()");
+
+		//beginning the frame waits on its fence, after that its region of the frame ring is free to overwrite
+		renderer.beginFrame();
+
+		//pipelines still compiling resolve to a compatible finished one, so the workers only ever see ready pipelines
+		NYPipelineLibrary& pipelineLibrary = renderer.getPipelineLibrary();
+		framePipelines.resize(pipelines.size());
+		for (size_t i = 0; i < pipelines.size(); i++) {
+			framePipelines[i] = &pipelineLibrary.get(pipelines[i]);
+		}
+
+		uint32_t frameIndex = renderer.getFrameIndex();
+		uint32_t instanceCount = _sprites.size();
+		NYFrameRingBuffer& frameRing = renderer.getFrameRing();
+
+		//the instances and every camera's block are reserved with one allocation, so a ring reallocation can't leave one of them
+		//in the retired buffer while descriptors get written against the new one. both alignments are powers of two, the larger
+		//one satisfies both
+		vk::DeviceSize uniformAlignment = frameRing.getUniformAlignment();
+		vk::DeviceSize cameraStride = (sizeof(NYCamera2D::CameraData) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+		vk::DeviceSize instanceBytes = sizeof(NYSprite::InstanceData) * instanceCount;
+		vk::DeviceSize cameraBlockStart = (instanceBytes + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+		NYFrameRingBuffer::Allocation frameAllocation = frameRing.allocate(cameraBlockStart + cameraStride * cameras.size(),
+			std::max(uniformAlignment, frameRing.getStorageAlignment()));
+
+		instanceAllocation = frameAllocation;
+		instanceAllocation.size = instanceBytes;
+		NYFrameRingBuffer::Allocation cameraAllocation = frameAllocation;
+		cameraAllocation.offset += cameraBlockStart;
+		cameraAllocation.data = static_cast<uint8_t*>(frameAllocation.data) + cameraBlockStart;
+		cameraAllocation.size = cameraStride * cameras.size();
+
+		bool cullingActive = gpuCulling && renderDevice.getEnabledFeatures().drawIndirectFirstInstance && instanceCount > 0 && !cameras.empty();
+		fillInstances(_sprites, cullingActive);
+
+		//every camera's view projection is computed once and goes in one block
+		vk::Extent2D extent = renderer.getExtent();
+
+		glm::vec4 cullBounds(glm::vec2(std::numeric_limits<float>::max()), glm::vec2(std::numeric_limits<float>::lowest()));
+		for (size_t i = 0; i < cameras.size(); i++) {
+			NYCamera2D& camera = *cameras[i];
+			float aspectRatio = (camera.viewport.z * extent.width) / (camera.viewport.w * extent.height);
+
+			NYCamera2D::CameraData* cameraData = reinterpret_cast<NYCamera2D::CameraData*>(static_cast<uint8_t*>(cameraAllocation.data) + cameraStride * i);
+			cameraData->viewProj = camera.getViewProjection(aspectRatio);
+
+			//sprites are culled once for all cameras against the union of what they see
+			glm::vec4 bounds = camera.getWorldBounds(aspectRatio);
+			cullBounds = glm::vec4(glm::min(glm::vec2(cullBounds), glm::vec2(bounds)), glm::max(glm::vec2(cullBounds.z, cullBounds.w), glm::vec2(bounds.z, bounds.w)));
+		}
+
+		if (cameraSetRingGenerations[frameIndex] != frameRing.getGeneration()) {
+			writeCameraSet(frameIndex);
+		}
+
+		if (!drawFirstInstances.empty()) {
+			uint32_t cullScope = renderer.beginGPUScope("culling");
+			cullingSystem.cull(instanceAllocation, instanceCount, cullBounds, drawFirstInstances);
+			renderer.endGPUScope(cullScope);
+		}
+
+		cameraBlockOffset = cameraAllocation.offset;
+		cameraBlockStride = cameraStride;
+
+		//the draw list is every batch once per camera, it's cut into contiguous slices when recording in parallel
+		frameCameras = cameras;
+		frameDrawCount = static_cast<uint32_t>(cameras.size() * batches.size());
+		frameTaskCount = std::min(recordingTaskCount, frameDrawCount);
+		renderer.getFrameGraph().setContents(spritePass, frameTaskCount > 1 ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline);
 
-			result = vmaCreateBuffer(renderDevice.getAllocator(), &indexBuffInfo, &allocInfo, &indexBuffers[i], &indexBufferAllocations[i], nullptr);
+		stats.draws = frameDrawCount;
+		NY_PROFILE_COUNTER("draws", frameDrawCount);
+		NY_PROFILE_COUNTER("sprites", instanceCount);
+		//counted off the batch list as if it were recorded in one go, so the number of recording tasks doesn't show up in it
+		stats.pipelineBinds = 0;
+		uint32_t lastPipeline = UINT32_MAX;
+		for (uint32_t draw = 0; draw < frameDrawCount; draw++) {
+			uint32_t pipeline = batches[draw % batches.size()].pipeline;
+			if (pipeline != lastPipeline) { stats.pipelineBinds++; lastPipeline = pipeline; }
+		}
+		//fillInstances() left the unsorted bind count for a single pass over the sprites in here
+		stats.pipelineBindsSaved = stats.pipelineBindsSaved * static_cast<int32_t>(cameras.size()) - static_cast<int32_t>(stats.pipelineBinds);
 
-			NYLogger::checkAssert(result == VK_SUCCESS, "failed to create index buffer");
+		stats.recordedPipelineBinds = 0;
+		renderer.executeFrameGraph();
 
-			vmaMapMemory(renderDevice.getAllocator(), indexBufferAllocations[i], &mappedMem);
-			memcpy(mappedMem, _sprites[i]->getIndices().data(), indexBuffSize);
+		renderer.endFrame();
+	}
 
-			vmaUnmapMemory(renderDevice.getAllocator(), indexBufferAllocations[i]);
+	NYFrameGraph::Pass NYRenderingSystem::addSpritePass(NYFrameGraph::Resource target, glm::vec4 clearColor) {
+		NYFrameGraph& frameGraph = renderer.getFrameGraph();
+		spritePass = frameGraph.addPass("sprites", [this](NYFrameGraph::PassContext& context) {
+			recordPass(context);
+		});
+		frameGraph.clearColor(spritePass, target, clearColor);
+		return spritePass;
+	}
 
+	void NYRenderingSystem::recordPass(NYFrameGraph::PassContext& context) {
+		NYGPUProfiler& profiler = renderer.getGPUProfiler();
+		if (frameTaskCount <= 1) {
+			NYCommandList commandList(context.commandBuffer, context.extent);
+			uint32_t scope = profiler.beginScope(context.commandBuffer, "sprite draws");
+			recordDraws(commandList, 0, frameDrawCount, frameCameras, stats.recordedPipelineBinds);
+			profiler.endScope(context.commandBuffer, scope);
+			return;
+		}
+
+		secondaries.resize(frameTaskCount);
+		taskPipelineBinds.assign(frameTaskCount, 0);
+		renderer.getThreadPool().parallelFor(frameTaskCount, [&](uint32_t task, uint32_t worker) {
+			uint32_t firstDraw = static_cast<uint32_t>(uint64_t(frameDrawCount) * task / frameTaskCount);
+			uint32_t endDraw = static_cast<uint32_t>(uint64_t(frameDrawCount) * (task + 1) / frameTaskCount);
+
+			//every slice is its own scope, they add up to the pass' draw time since secondaries run one after another
+			NYCommandList commandList = renderer.beginSecondary(worker, context);
+			uint32_t scope = profiler.beginScope(commandList.getCommandBuffer(), "sprite draws");
+			recordDraws(commandList, firstDraw, endDraw, frameCameras, taskPipelineBinds[task]);
+			profiler.endScope(commandList.getCommandBuffer(), scope);
+			renderer.endSecondary(commandList);
+			secondaries[task] = commandList.getCommandBuffer();
+		});
+
+		//slices are executed in task order, so the draw order is the same as recording it in one go
+		renderer.executeSecondaries(context, secondaries);
+		for (uint32_t binds : taskPipelineBinds) {
+			stats.recordedPipelineBinds += binds;
 		}
-		timer.endTimer();
-		std::cout << timer.getMillis() << std::endl;
-		
 	}
 
-	void NYRenderingSystem::render(std::vector<std::unique_ptr<NYSprite>>& _sprites, NYPipeline& pipeline) {
-		float aspect_ratio = 16.0f / 9.0f;
-		renderer.beginRenderPass(glm::vec4(0.05f, 0.05f, 0.05f, 0.05f), pipeline);
-		renderer.bindPipeline(pipeline);
-		for (int i = 0; i < vertexBuffers.size();i++) {
-			
-			NYSprite::UniformObject ubo;
-			ubo.model = _sprites[i]->transform_matrix();
-			ubo.proj = glm::mat4(0.0f);
-			ubo.proj = glm::ortho(-5.0f, 5.0f, -5.0f/aspect_ratio, 5.0f/aspect_ratio);
-			ubo.view = glm::mat4(1.0f);
-			
-			_sprites[i]->updateUniformBuffers(renderer.getFrameIndex(), ubo);
-			_sprites[i]->pushData.transformMatrix = ubo.proj * ubo.model;
-			renderer.pushConstants(pipeline, &_sprites[i]->pushData, sizeof(NYSprite::PushData));
-			renderer.draw(vertexBuffers[i], indexBuffers[i], pipeline, _sprites[i]->getIndices().size(), _sprites[i]->getDescriptorSet(renderer.getFrameIndex()));
+	void NYRenderingSystem::recordDraws(NYCommandList& commandList, uint32_t firstDraw, uint32_t endDraw, std::vector<NYCamera2D*>& cameras, uint32_t& pipelineBinds) {
+		NY_PROFILE_ZONE("record draws");
+		uint32_t frameIndex = renderer.getFrameIndex();
+		uint32_t batchCount = static_cast<uint32_t>(batches.size());
+
+		//every pipeline shares the same layout, so the sets stay bound across pipeline binds
+		NYPipeline& layoutPipeline = *framePipelines[0];
+		commandList.bindDescriptorSet(layoutPipeline, textureTable.getDescriptorSet(), 1);
+
+		uint32_t boundCamera = UINT32_MAX;
+		uint32_t boundPipeline = UINT32_MAX;
+		VkBuffer boundInstanceBuffer = VK_NULL_HANDLE;
+
+		for (uint32_t draw = firstDraw; draw < endDraw; draw++) {
+			uint32_t cameraIndex = draw / batchCount;
+			Batch& batch = batches[draw % batchCount];
+
+			if (cameraIndex != boundCamera) {
+				commandList.setViewport(cameras[cameraIndex]->viewport);
+				uint32_t cameraOffset = static_cast<uint32_t>(cameraBlockOffset + cameraBlockStride * cameraIndex);
+				commandList.bindDescriptorSet(layoutPipeline, cameraSets[frameIndex], 0, cameraOffset);
+				boundCamera = cameraIndex;
+			}
+
+			if (batch.pipeline != boundPipeline) {
+				commandList.bindPipeline(*framePipelines[batch.pipeline]);
+				boundPipeline = batch.pipeline;
+				pipelineBinds++;
+			}
+
+			//textures are picked per instance from the table, so they never break a batch
+			VkBuffer& instanceBuffer = batch.culled ? cullingSystem.getVisibleBuffer(frameIndex) : instanceAllocation.buffer;
+			if (instanceBuffer != boundInstanceBuffer) {
+				commandList.bindInstanceBuffers(quadVertexBuffer, instanceBuffer, quadIndexBuffer, batch.culled ? 0 : instanceAllocation.offset);
+				boundInstanceBuffer = instanceBuffer;
+			}
+
+			if (batch.culled) {
+				//the instance count of the draw was written by the culling shader
+				commandList.drawIndexedIndirect(cullingSystem.getDrawCommandBuffer(frameIndex), sizeof(VkDrawIndexedIndirectCommand) * batch.drawIndex, 1);
+			}
+			else {
+				commandList.drawInstanced(NYSprite::getIndices().size(), batch.instanceCount, batch.firstInstance);
+			}
 		}
-		renderer.endRenderPass(pipeline);
 	}
 }
\ No newline at end of file
@@ -2,26 +2,118 @@
 #include "pch.hpp"
 #include "backend/NYRenderer.hpp"
 #include "game/NYSprite.hpp"
+#include "game/NYCamera2D.hpp"
 #include "backend/NYPipeline.hpp"
+#include "backend/NYPipelineLibrary.hpp"
+#include "backend/NYTextureTable.hpp"
+#include "NYCullingSystem.hpp"
+#include "NYRenderQueue.hpp"
+#include "utils/NYTransformBatch.hpp"
+#include "defines.hpp"
 
 //system that utilizes the NYRenderer and deals with all the pre-rendering stuff like creating buffers, descriptors, etc
 namespace Nya {
 	class NYRenderingSystem {
 	public:
-		NYRenderingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice, std::vector<std::unique_ptr<NYSprite>>& _sprites);
+		NYRenderingSystem(NYRenderer& _renderer, NYRenderDevice& _renderDevice, NYTextureTable& _textureTable);
 		~NYRenderingSystem();
 
-		void load(std::vector<std::unique_ptr<NYSprite>>& _sprites);
-		void render(std::vector<std::unique_ptr<NYSprite>>& _sprites, NYPipeline& pipeline);
+		//declares the pass sprites are drawn in, pipelines set with setBlendPipeline() must be made for its render pass and subpass
+		NYFrameGraph::Pass addSpritePass(NYFrameGraph::Resource target, glm::vec4 clearColor);
+
+		//sprite pipelines take this as set 0 and the texture table's layout as set 1
+		NYDescriptorSetLayout& getCameraLayout() { return cameraLayout; }
+
+		//sprites are drawn with the pipeline set for their blend mode, all of them must be made with NYSprite's instanced descriptions
+		//and share the same layout and the sprite pass' subpass. they come from the renderer's pipeline library, so one that's
+		//still compiling is drawn with a compatible one in the meantime
+		void setBlendPipeline(NYBlendMode blendMode, NYPipelineLibrary::Handle pipeline);
+
+		//draws all the sprites as instances of one shared quad, sorted through the render queue so state only changes when it has to
+		//every camera draws the same instance data into its own viewport, in the order given
+		//runs the whole frame graph, so this is the one call per frame
+		void renderBatch(std::vector<std::unique_ptr<NYSprite>>& _sprites, std::vector<NYCamera2D*>& cameras);
+
+		//how many slices the draw list is recorded in, each one on a worker thread into a secondary command buffer
+		//1 records everything inline on the calling thread
+		void setRecordingTaskCount(uint32_t taskCount) { recordingTaskCount = std::max(taskCount, 1u); }
+
+		//per frame counters, "saved" is compared against drawing the sprites in the order they're stored
+		struct RenderStats {
+			uint32_t draws = 0;
+			uint32_t pipelineBinds = 0;
+			int32_t pipelineBindsSaved = 0;
+			//what ended up in the command buffers, every recording task binds its first pipeline again
+			uint32_t recordedPipelineBinds = 0;
+			uint32_t textureSwitches = 0;
+			int32_t textureSwitchesSaved = 0;
+		};
+		RenderStats& getStats() { return stats; }
 
 	private:
+		//a run of sorted instances drawn with one draw call
+		struct Batch {
+			uint32_t pipeline;
+			uint32_t firstInstance;
+			uint32_t instanceCount;
+			uint8_t layer;
+			bool culled;//drawn indirectly out of the culling system's visible buffer
+			uint32_t drawIndex;
+		};
+
+		void createBatchResources();
+		void createCameraResources();
+		void writeCameraSet(uint32_t frameIndex);
+		void fillInstances(std::vector<std::unique_ptr<NYSprite>>& _sprites, bool cullingActive);
+		//records draws [firstDraw, endDraw) of the frame's draw list, draw i is batch i % batches.size() seen by camera i / batches.size()
+		//binds everything it uses itself, so it's safe to call on separate command lists from several threads at once
+		void recordPass(NYFrameGraph::PassContext& context);
+		void recordDraws(NYCommandList& commandList, uint32_t firstDraw, uint32_t endDraw, std::vector<NYCamera2D*>& cameras, uint32_t& pipelineBinds);
+
 		NYRenderer& renderer;
 		NYRenderDevice& renderDevice;
+		NYTextureTable& textureTable;
+
+		NYCullingSystem cullingSystem{ renderer, renderDevice };
+		//when off every instance is drawn directly, toggled from the debug window
+		bool gpuCulling = true;
+
+		NYRenderQueue renderQueue;
+		NYTransformBatch transformBatch;
+		std::vector<NYPipelineLibrary::Handle> pipelines;
+		//what the handles resolved to this frame, looked up once before recording
+		std::vector<NYPipeline*> framePipelines;
+		std::array<uint32_t, static_cast<size_t>(NYBlendMode::eCount)> blendPipelines;
+		std::vector<Batch> batches;
+		std::vector<uint32_t> drawFirstInstances;
+		RenderStats stats;
+
+		//batched rendering resources, one unit quad shared by every sprite
+		VkBuffer quadVertexBuffer;
+		VmaAllocation quadVertexAllocation;
+		VkBuffer quadIndexBuffer;
+		VmaAllocation quadIndexAllocation;
+
+		//camera blocks live in the frame ring and are picked with a dynamic offset, the per frame sets only
+		//need rewriting when the ring reallocates
+		NYDescriptorSetLayout cameraLayout{ renderDevice };
+		vk::DescriptorPool cameraPool;
+		std::vector<vk::DescriptorSet> cameraSets;
+		std::vector<uint32_t> cameraSetRingGenerations;
 
-		std::vector<VkBuffer> vertexBuffers;
-		std::vector<VmaAllocation> vertexBufferAllocations;
+		//this frame's instances, sub-allocated from the renderer's frame ring
+		NYFrameRingBuffer::Allocation instanceAllocation{};
+		//this frame's camera blocks, one per camera stride bytes apart
+		vk::DeviceSize cameraBlockOffset = 0;
+		vk::DeviceSize cameraBlockStride = 0;
 
-		std::vector<VkBuffer> indexBuffers;
-		std::vector<VmaAllocation> indexBufferAllocations;
+		NYFrameGraph::Pass spritePass = UINT32_MAX;
+		uint32_t recordingTaskCount = 1;
+		//what the pass records this frame, set by renderBatch() before the frame graph runs
+		std::vector<NYCamera2D*> frameCameras;
+		uint32_t frameDrawCount = 0;
+		uint32_t frameTaskCount = 1;
+		std::vector<vk::CommandBuffer> secondaries;
+		std::vector<uint32_t> taskPipelineBinds;
 	};
 }
@@ -0,0 +1,31 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	//64 bit fnv-1a, for cache keys built from a handful of fields
+	class NYHash {
+	public:
+		void addBytes(const void* data, size_t size) {
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for (size_t i = 0; i < size; i++) {
+				hash ^= bytes[i];
+				hash *= 0x100000001b3ull;
+			}
+		}
+		//the size goes in ahead of the bytes so neighbouring strings can't run into each other
+		void addString(const std::string& string) {
+			addValue(static_cast<uint64_t>(string.size()));
+			addBytes(string.data(), string.size());
+		}
+		template<typename T>
+		void addValue(const T& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "NYHash::addValue() only takes plain values");
+			addBytes(&value, sizeof(T));
+		}
+
+		uint64_t get() { return hash; }
+
+	private:
+		uint64_t hash = 0xcbf29ce484222325ull;
+	};
+}
\ No newline at end of file
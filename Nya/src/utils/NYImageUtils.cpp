@@ -0,0 +1,30 @@
+#include "pch.hpp"
+#include "NYImageUtils.hpp"
+
+namespace Nya {
+	uint32_t NYImageUtils::getMipLevelCount(uint32_t width, uint32_t height){
+		uint32_t levels = 1;
+		for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+			levels++;
+		}
+		return levels;
+	}
+
+	void NYImageUtils::downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst){
+		uint32_t dstWidth = std::max(width / 2, 1u);
+		uint32_t dstHeight = std::max(height / 2, 1u);
+		for (uint32_t y = 0; y < dstHeight; y++) {
+			uint32_t y0 = std::min(y * 2, height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, height - 1);
+			for (uint32_t x = 0; x < dstWidth; x++) {
+				uint32_t x0 = std::min(x * 2, width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, width - 1);
+				for (uint32_t channel = 0; channel < 4; channel++) {
+					uint32_t sum = src[(y0 * width + x0) * 4 + channel] + src[(y0 * width + x1) * 4 + channel] +
+						src[(y1 * width + x0) * 4 + channel] + src[(y1 * width + x1) * 4 + channel];
+					dst[(y * dstWidth + x) * 4 + channel] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	//this class only contains static helpers for tightly packed rgba8 images, shared by the texture streamer and the cooker
+	class NYImageUtils {
+	public:
+		//levels down to 1x1, floor(log2(max(width, height))) + 1
+		static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+		//2x2 box filter into a half sized image, odd edges repeat their last texel
+		static void downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst);
+	};
+}
\ No newline at end of file
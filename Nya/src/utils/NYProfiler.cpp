@@ -0,0 +1,159 @@
+#include "pch.hpp"
+#include "NYProfiler.hpp"
+#include "logging/NYLogger.hpp"
+#include <iomanip>
+
+#ifdef NY_ENABLE_PROFILING
+namespace Nya {
+	NYProfiler::ThreadBuffer& NYProfiler::getThreadBuffer() {
+		//owned by the buffers list so the trace can still be written after the thread is gone
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (!buffer) {
+			std::lock_guard<std::mutex> lock(buffersMutex);
+			buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = buffers.back().get();
+			buffer->threadIndex = static_cast<uint32_t>(buffers.size() - 1);
+			buffer->name = "thread " + std::to_string(buffer->threadIndex);
+		}
+		return *buffer;
+	}
+
+	void NYProfiler::record(const char* name, EventType type, double value) {
+		ThreadBuffer& buffer = getThreadBuffer();
+		//first event of a new capture, the old events are dropped by the owner so nobody else ever writes count
+		uint32_t capture = captureIndex.load(std::memory_order_acquire);
+		if (buffer.capture.load(std::memory_order_relaxed) != capture) {
+			buffer.count.store(0, std::memory_order_relaxed);
+			buffer.capture.store(capture, std::memory_order_release);
+		}
+		uint32_t index = buffer.count.load(std::memory_order_relaxed);
+		uint32_t chunk = index / chunkSize;
+		//out of room, the rest of the capture is dropped for this thread
+		if (chunk >= maxChunks) {
+			return;
+		}
+		if (!buffer.chunks[chunk]) {
+			buffer.chunks[chunk] = std::make_unique<Event[]>(chunkSize);
+		}
+
+		uint64_t timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+		buffer.chunks[chunk][index % chunkSize] = { name, timestamp, value, type };
+		//the writer only reads events below count
+		buffer.count.store(index + 1, std::memory_order_release);
+	}
+
+	void NYProfiler::beginCapture(uint32_t frameCount, const std::string& path) {
+		if (isCapturing() || frameCount == 0) {
+			return;
+		}
+		captureIndex.fetch_add(1, std::memory_order_release);
+		framesLeft = frameCount;
+		capturePath = path;
+		capturing.store(true, std::memory_order_release);
+		NYLogger::logInfo("capturing %u frames to %s", frameCount, path.c_str());
+	}
+
+	void NYProfiler::frameMark() {
+		if (!isCapturing()) {
+			return;
+		}
+		record("frame", EventType::eFrame, 0.0);
+		if (--framesLeft == 0) {
+			capturing.store(false, std::memory_order_release);
+			writeTrace();
+		}
+	}
+
+	void NYProfiler::setThreadName(const std::string& name) {
+		ThreadBuffer& buffer = getThreadBuffer();
+		//writeTrace() reads it while holding the lock
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		buffer.name = name;
+	}
+
+	//names are free form, a quote, backslash or control character would break the json string
+	static std::string escapeJSON(const char* text) {
+		std::string escaped;
+		for (const char* c = text; *c; c++) {
+			switch (*c) {
+			case '"': escaped += "\\\""; break;
+			case '\\': escaped += "\\\\"; break;
+			case '\n': escaped += "\\n"; break;
+			case '\t': escaped += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(*c) < 0x20) {
+					char code[8];
+					snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(*c));
+					escaped += code;
+				}
+				else {
+					escaped += *c;
+				}
+			}
+		}
+		return escaped;
+	}
+
+	void NYProfiler::writeTrace() {
+		std::ofstream file(capturePath);
+		if (!file.is_open()) {
+			NYLogger::logWarning("NYProfiler: couldn't open %s", capturePath.c_str());
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(buffersMutex);
+		size_t eventCount = 0;
+		bool first = true;
+		auto separator = [&]() -> std::ofstream& {
+			if (!first) { file << ",\n"; }
+			first = false;
+			return file;
+		};
+
+		//timestamps are microseconds, fixed so long captures don't end up in scientific notation
+		file << std::fixed << std::setprecision(3);
+		file << "{\"traceEvents\":[\n";
+		uint32_t capture = captureIndex.load(std::memory_order_relaxed);
+		for (auto& buffer : buffers) {
+			//threads that didn't record during this capture still hold an older one's events
+			uint32_t count = buffer->capture.load(std::memory_order_acquire) == capture ? buffer->count.load(std::memory_order_acquire) : 0;
+			uint32_t tid = buffer->threadIndex;
+			separator() << "{\"ph\":\"M\",\"pid\":0,\"tid\":" << tid << ",\"name\":\"thread_name\",\"args\":{\"name\":\"" << escapeJSON(buffer->name.c_str()) << "\"}}";
+
+			//zones still open when the capture ended are closed at the last event so the viewer doesn't drop them
+			uint32_t openZones = 0;
+			double lastTimestamp = 0.0;
+			for (uint32_t i = 0; i < count; i++) {
+				Event& event = buffer->chunks[i / chunkSize][i % chunkSize];
+				double ts = event.timestamp / 1000.0;
+				lastTimestamp = ts;
+				switch (event.type) {
+				case EventType::eBegin:
+					openZones++;
+					separator() << "{\"ph\":\"B\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << ts << ",\"name\":\"" << escapeJSON(event.name) << "\"}";
+					break;
+				case EventType::eEnd:
+					//zones begun before the capture started have no begin to match
+					if (openZones == 0) { continue; }
+					openZones--;
+					separator() << "{\"ph\":\"E\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << ts << "}";
+					break;
+				case EventType::eCounter:
+					separator() << "{\"ph\":\"C\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << ts << ",\"name\":\"" << escapeJSON(event.name)
+						<< "\",\"args\":{\"value\":" << event.value << "}}";
+					break;
+				case EventType::eFrame:
+					separator() << "{\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << ts << ",\"name\":\"frame\"}";
+					break;
+				}
+			}
+			for (; openZones > 0; openZones--) {
+				separator() << "{\"ph\":\"E\",\"pid\":0,\"tid\":" << tid << ",\"ts\":" << lastTimestamp << "}";
+			}
+			eventCount += count;
+		}
+		file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+		NYLogger::logInfo("trace with %zu events written to %s", eventCount, capturePath.c_str());
+	}
+}
+#endif
\ No newline at end of file
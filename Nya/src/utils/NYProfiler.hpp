@@ -0,0 +1,106 @@
+#pragma once
+#include "pch.hpp"
+
+/*
+cpu zone profiler, writes chrome://tracing / perfetto json
+-zones and counters go into per thread buffers only the owning thread writes to, nothing is locked while recording
+-recording only happens during a capture, started with NYProfiler::beginCapture() and stopped after the given number of frames
+-everything is compiled out unless NY_ENABLE_PROFILING is defined, the macros below are the api to use
+*/
+
+#ifdef NY_ENABLE_PROFILING
+#define NY_PROFILE_CONCAT_INNER(a, b) a##b
+#define NY_PROFILE_CONCAT(a, b) NY_PROFILE_CONCAT_INNER(a, b)
+//times the rest of the enclosing scope, name has to be a string literal or otherwise outlive the capture
+#define NY_PROFILE_ZONE(name) Nya::NYProfiler::Zone NY_PROFILE_CONCAT(nyProfileZone, __LINE__)(name)
+#define NY_PROFILE_FUNCTION() NY_PROFILE_ZONE(__FUNCTION__)
+#define NY_PROFILE_COUNTER(name, value) Nya::NYProfiler::counter(name, static_cast<double>(value))
+//ends a frame, captures count and stop on these
+#define NY_PROFILE_FRAME() Nya::NYProfiler::frameMark()
+#define NY_PROFILE_THREAD(name) Nya::NYProfiler::setThreadName(name)
+//records the next frameCount frames into a trace at path
+#define NY_PROFILE_CAPTURE(frameCount, path) Nya::NYProfiler::beginCapture(frameCount, path)
+#define NY_PROFILE_IS_CAPTURING() Nya::NYProfiler::isCapturing()
+#else
+#define NY_PROFILE_ZONE(name) ((void)0)
+#define NY_PROFILE_FUNCTION() ((void)0)
+#define NY_PROFILE_COUNTER(name, value) ((void)0)
+#define NY_PROFILE_FRAME() ((void)0)
+#define NY_PROFILE_THREAD(name) ((void)0)
+#define NY_PROFILE_CAPTURE(frameCount, path) ((void)0)
+#define NY_PROFILE_IS_CAPTURING() false
+#endif
+
+#ifdef NY_ENABLE_PROFILING
+namespace Nya {
+	class NYProfiler {
+	public:
+		class Zone {
+		public:
+			Zone(const char* name) :recorded(isCapturing()) {
+				if (recorded) { record(name, EventType::eBegin, 0.0); }
+			}
+			~Zone() {
+				if (recorded) { record(nullptr, EventType::eEnd, 0.0); }
+			}
+			Zone(Zone const&) = delete;
+			Zone& operator=(Zone const&) = delete;
+		private:
+			bool recorded;
+		};
+
+		//records the next frameCount frames and writes them to path once the last one ends
+		//call it between frames, every thread drops its previous capture's events the first time it records in the new one
+		static void beginCapture(uint32_t frameCount, const std::string& path);
+		static bool isCapturing() { return capturing.load(std::memory_order_relaxed); }
+
+		static void counter(const char* name, double value) {
+			if (isCapturing()) { record(name, EventType::eCounter, value); }
+		}
+		static void frameMark();
+		//shows up as the thread's name in the trace, copied
+		static void setThreadName(const std::string& name);
+
+	private:
+		enum class EventType : uint8_t {
+			eBegin,
+			eEnd,
+			eCounter,
+			eFrame
+		};
+		struct Event {
+			const char* name;
+			uint64_t timestamp;//nanoseconds since the profiler started
+			double value;
+			EventType type;
+		};
+
+		//events live in fixed size chunks that are never moved, the owner fills them in and publishes with count
+		//capture is the capture the events belong to, only the owner resets count and it does so before stamping a new capture
+		static constexpr uint32_t chunkSize = 16 * 1024;
+		static constexpr uint32_t maxChunks = 256;
+		struct ThreadBuffer {
+			std::array<std::unique_ptr<Event[]>, maxChunks> chunks;
+			std::atomic<uint32_t> count{ 0 };
+			std::atomic<uint32_t> capture{ 0 };
+			uint32_t threadIndex = 0;
+			std::string name;
+		};
+
+		static void record(const char* name, EventType type, double value);
+		static ThreadBuffer& getThreadBuffer();
+		static void writeTrace();
+
+		static inline std::atomic<bool> capturing{ false };
+		//bumped by beginCapture() before capturing is set, 0 is never a capture
+		static inline std::atomic<uint32_t> captureIndex{ 0 };
+		static inline uint32_t framesLeft = 0;
+		static inline std::string capturePath;
+		static inline const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+		//only locked when a thread records for the first time and when writing the trace
+		static inline std::mutex buffersMutex;
+		static inline std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	};
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,86 @@
+#include "pch.hpp"
+#include "NYThreadPool.hpp"
+#include "NYProfiler.hpp"
+
+namespace Nya {
+	NYThreadPool::NYThreadPool(uint32_t threadCount) {
+		if (threadCount == 0) {
+			threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+		}
+
+		//the caller is the last worker, so only spawn the rest
+		for (uint32_t i = 0; i + 1 < threadCount; i++) {
+			threads.emplace_back(&NYThreadPool::workerLoop, this, i);
+		}
+	}
+
+	NYThreadPool::~NYThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		jobReady.notify_all();
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
+	void NYThreadPool::parallelFor(uint32_t taskCount, const std::function<void(uint32_t, uint32_t)>& task) {
+		if (taskCount == 0) {
+			return;
+		}
+
+		//a single task isn't worth waking anyone up for
+		if (taskCount == 1 || threads.empty()) {
+			for (uint32_t i = 0; i < taskCount; i++) {
+				task(i, getWorkerCount() - 1);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &task;
+			jobTaskCount = taskCount;
+			nextTask.store(0);
+			busyWorkers = static_cast<uint32_t>(threads.size());
+			jobGeneration++;
+		}
+		jobReady.notify_all();
+
+		runTasks(getWorkerCount() - 1);
+
+		std::unique_lock<std::mutex> lock(mutex);
+		jobDone.wait(lock, [this]() { return busyWorkers == 0; });
+		job = nullptr;
+	}
+
+	void NYThreadPool::workerLoop(uint32_t workerIndex) {
+		NY_PROFILE_THREAD("worker " + std::to_string(workerIndex));
+		uint64_t seenGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				jobReady.wait(lock, [&]() { return stopping || jobGeneration != seenGeneration; });
+				if (stopping) {
+					return;
+				}
+				seenGeneration = jobGeneration;
+			}
+
+			runTasks(workerIndex);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			if (--busyWorkers == 0) {
+				jobDone.notify_one();
+			}
+		}
+	}
+
+	void NYThreadPool::runTasks(uint32_t workerIndex) {
+		//tasks are handed out one at a time so uneven tasks still balance out
+		for (uint32_t task = nextTask.fetch_add(1); task < jobTaskCount; task = nextTask.fetch_add(1)) {
+			(*job)(task, workerIndex);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	//fixed set of worker threads that split a batch of tasks between them
+	//the calling thread joins in as the last worker, so a job runs on getWorkerCount() threads
+	class NYThreadPool {
+	public:
+		//0 uses one thread per core, the calling thread counts as one of them
+		NYThreadPool(uint32_t threadCount = 0);
+		~NYThreadPool();
+
+		NYThreadPool(NYThreadPool const&) = delete;
+		NYThreadPool& operator=(NYThreadPool const&) = delete;
+
+		//threads that run tasks, including the caller of parallelFor()
+		uint32_t getWorkerCount() { return static_cast<uint32_t>(threads.size()) + 1; }
+
+		//calls task(taskIndex, workerIndex) for every index in [0, taskCount) and returns once all of them are done
+		//workerIndex is in [0, getWorkerCount()) and no two tasks with the same worker index ever run at once,
+		//so it can pick per thread resources. not reentrant, a task can't call parallelFor() itself
+		void parallelFor(uint32_t taskCount, const std::function<void(uint32_t, uint32_t)>& task);
+
+	private:
+		void workerLoop(uint32_t workerIndex);
+		void runTasks(uint32_t workerIndex);
+
+		std::vector<std::thread> threads;
+
+		std::mutex mutex;
+		std::condition_variable jobReady;
+		std::condition_variable jobDone;
+
+		//current job, only changed by parallelFor() while no worker is running it
+		const std::function<void(uint32_t, uint32_t)>* job = nullptr;
+		uint32_t jobTaskCount = 0;
+		std::atomic<uint32_t> nextTask{ 0 };
+		uint64_t jobGeneration = 0;
+		uint32_t busyWorkers = 0;
+		bool stopping = false;
+	};
+}
\ No newline at end of file
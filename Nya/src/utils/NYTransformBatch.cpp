@@ -0,0 +1,259 @@
+#include "pch.hpp"
+#include "NYTransformBatch.hpp"
+#include "NYTimer.hpp"
+#include "logging/NYLogger.hpp"
+#include <emmintrin.h>
+#include <random>
+
+namespace Nya {
+	//sse2 sine and cosine of four angles at once, cephes polynomials with the usual octant reduction
+	//accurate to a couple of ulp for the angle range sprites use, well beyond what a model matrix needs
+	static inline void sincos4(__m128 x, __m128& sinOut, __m128& cosOut) {
+		const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int>(0x80000000)));
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		const __m128i four = _mm_set1_epi32(4);
+
+		__m128 signSin = _mm_and_ps(x, signMask);
+		x = _mm_andnot_ps(signMask, x);
+
+		//octant of the angle, rounded up to even so the remainder lands in [-pi/4, pi/4]
+		__m128i octant = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+		octant = _mm_add_epi32(octant, one);
+		octant = _mm_andnot_si128(one, octant);
+		__m128 y = _mm_cvtepi32_ps(octant);
+
+		__m128 swapSignSin = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(octant, four), 29));
+		__m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(octant, two), _mm_setzero_si128()));
+		__m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(octant, two), four), 29));
+		signSin = _mm_xor_ps(signSin, swapSignSin);
+
+		//pi/4 split in three so the reduction doesn't lose precision
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+		x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+
+		__m128 z = _mm_mul_ps(x, x);
+
+		__m128 cosPoly = _mm_set1_ps(2.443315711809948e-5f);
+		cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(-1.388731625493765e-3f));
+		cosPoly = _mm_add_ps(_mm_mul_ps(cosPoly, z), _mm_set1_ps(4.166664568298827e-2f));
+		cosPoly = _mm_mul_ps(_mm_mul_ps(cosPoly, z), z);
+		cosPoly = _mm_sub_ps(cosPoly, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+		cosPoly = _mm_add_ps(cosPoly, _mm_set1_ps(1.0f));
+
+		__m128 sinPoly = _mm_set1_ps(-1.9515295891e-4f);
+		sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(8.3321608736e-3f));
+		sinPoly = _mm_add_ps(_mm_mul_ps(sinPoly, z), _mm_set1_ps(-1.6666654611e-1f));
+		sinPoly = _mm_mul_ps(_mm_mul_ps(sinPoly, z), x);
+		sinPoly = _mm_add_ps(sinPoly, x);
+
+		//in odd quadrants sine and cosine swap polynomials
+		__m128 sinResult = _mm_or_ps(_mm_and_ps(polyMask, sinPoly), _mm_andnot_ps(polyMask, cosPoly));
+		__m128 cosResult = _mm_or_ps(_mm_and_ps(polyMask, cosPoly), _mm_andnot_ps(polyMask, sinPoly));
+
+		sinOut = _mm_xor_ps(sinResult, signSin);
+		cosOut = _mm_xor_ps(cosResult, signCos);
+	}
+
+	NYTransformBatch::NYTransformBatch() {
+	}
+
+	NYTransformBatch::~NYTransformBatch() {
+	}
+
+	void NYTransformBatch::clear() {
+		tx.clear(); ty.clear(); tz.clear();
+		sx.clear(); sy.clear(); sz.clear();
+		rx.clear(); ry.clear(); rz.clear();
+	}
+
+	void NYTransformBatch::reserve(uint32_t count) {
+		tx.reserve(count); ty.reserve(count); tz.reserve(count);
+		sx.reserve(count); sy.reserve(count); sz.reserve(count);
+		rx.reserve(count); ry.reserve(count); rz.reserve(count);
+	}
+
+	void NYTransformBatch::push(const glm::vec3& translation, const glm::vec3& scale, const glm::vec3& rotation) {
+		tx.push_back(translation.x); ty.push_back(translation.y); tz.push_back(translation.z);
+		sx.push_back(scale.x); sy.push_back(scale.y); sz.push_back(scale.z);
+		rx.push_back(rotation.x); ry.push_back(rotation.y); rz.push_back(rotation.z);
+	}
+
+	glm::mat4 NYTransformBatch::computeMatrix(const glm::vec3& translation, const glm::vec3& scale, const glm::vec3& rotation) {
+		//thanks to https://www.youtube.com/@BrendanGalea for the simplified matrix calculations
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		return glm::mat4{
+			{
+				scale.x * (c1 * c3 + s1 * s2 * s3),
+				scale.x * (c2 * s3),
+				scale.x * (c1 * s2 * s3 - c3 * s1),
+				0.0f,
+			},
+			{
+				scale.y * (c3 * s1 * s2 - c1 * s3),
+				scale.y * (c2 * c3),
+				scale.y * (c1 * c3 * s2 + s1 * s3),
+				0.0f,
+			},
+			{
+				scale.z * (c2 * s1),
+				scale.z * (-s2),
+				scale.z * (c1 * c2),
+				0.0f,
+			},
+			{translation.x, translation.y, translation.z, 1.0f}
+		};
+	}
+
+	void NYTransformBatch::computeScalar(uint32_t index, float* output) {
+		glm::mat4 matrix = computeMatrix(glm::vec3(tx[index], ty[index], tz[index]),
+			glm::vec3(sx[index], sy[index], sz[index]), glm::vec3(rx[index], ry[index], rz[index]));
+		memcpy(output, &matrix, sizeof(glm::mat4));
+	}
+
+	void NYTransformBatch::compute(void* output, size_t stride) {
+		uint32_t count = size();
+		uint8_t* out = static_cast<uint8_t*>(output);
+		fastPathCount = 0;
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		uint32_t i = 0;
+		for (; i + 4 <= count; i += 4) {
+			__m128 rotX = _mm_loadu_ps(&rx[i]);
+			__m128 rotY = _mm_loadu_ps(&ry[i]);
+			__m128 scaleX = _mm_loadu_ps(&sx[i]);
+			__m128 scaleY = _mm_loadu_ps(&sy[i]);
+			__m128 scaleZ = _mm_loadu_ps(&sz[i]);
+
+			__m128 s3, c3;
+			sincos4(_mm_loadu_ps(&rz[i]), s3, c3);
+
+			//columns[c][r] holds element r of column c for all four transforms
+			__m128 columns[4][4];
+			columns[3][0] = _mm_loadu_ps(&tx[i]);
+			columns[3][1] = _mm_loadu_ps(&ty[i]);
+			columns[3][2] = _mm_loadu_ps(&tz[i]);
+			columns[0][3] = columns[1][3] = columns[2][3] = zero;
+			columns[3][3] = one;
+
+			//a group only takes the fast path if none of its four transforms rotate around x or y
+			__m128 tilted = _mm_or_ps(_mm_cmpneq_ps(rotX, zero), _mm_cmpneq_ps(rotY, zero));
+			if (_mm_movemask_ps(tilted) == 0) {
+				//with x and y rotation at zero the matrix is a scaled 2D rotation plus translation
+				columns[0][0] = _mm_mul_ps(scaleX, c3);
+				columns[0][1] = _mm_mul_ps(scaleX, s3);
+				columns[0][2] = zero;
+				columns[1][0] = _mm_sub_ps(zero, _mm_mul_ps(scaleY, s3));
+				columns[1][1] = _mm_mul_ps(scaleY, c3);
+				columns[1][2] = zero;
+				columns[2][0] = zero;
+				columns[2][1] = zero;
+				columns[2][2] = scaleZ;
+				fastPathCount += 4;
+			}
+			else {
+				__m128 s2, c2, s1, c1;
+				sincos4(rotX, s2, c2);
+				sincos4(rotY, s1, c1);
+
+				//same terms as computeMatrix()
+				__m128 s1s2 = _mm_mul_ps(s1, s2);
+				__m128 c1s2 = _mm_mul_ps(c1, s2);
+				columns[0][0] = _mm_mul_ps(scaleX, _mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3)));
+				columns[0][1] = _mm_mul_ps(scaleX, _mm_mul_ps(c2, s3));
+				columns[0][2] = _mm_mul_ps(scaleX, _mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1)));
+				columns[1][0] = _mm_mul_ps(scaleY, _mm_sub_ps(_mm_mul_ps(c3, s1s2), _mm_mul_ps(c1, s3)));
+				columns[1][1] = _mm_mul_ps(scaleY, _mm_mul_ps(c2, c3));
+				columns[1][2] = _mm_mul_ps(scaleY, _mm_add_ps(_mm_mul_ps(c1s2, c3), _mm_mul_ps(s1, s3)));
+				columns[2][0] = _mm_mul_ps(scaleZ, _mm_mul_ps(c2, s1));
+				columns[2][1] = _mm_mul_ps(scaleZ, _mm_sub_ps(zero, s2));
+				columns[2][2] = _mm_mul_ps(scaleZ, _mm_mul_ps(c1, c2));
+			}
+
+			//transpose each column so lane n becomes transform n's column
+			for (uint32_t col = 0; col < 4; col++) {
+				_MM_TRANSPOSE4_PS(columns[col][0], columns[col][1], columns[col][2], columns[col][3]);
+			}
+
+			for (uint32_t j = 0; j < 4; j++) {
+				float* matrix = reinterpret_cast<float*>(out + (i + j) * stride);
+				_mm_storeu_ps(matrix, columns[0][j]);
+				_mm_storeu_ps(matrix + 4, columns[1][j]);
+				_mm_storeu_ps(matrix + 8, columns[2][j]);
+				_mm_storeu_ps(matrix + 12, columns[3][j]);
+			}
+		}
+
+		//leftovers that don't fill a register
+		for (; i < count; i++) {
+			computeScalar(i, reinterpret_cast<float*>(out + i * stride));
+		}
+	}
+
+	void NYTransformBatch::runBenchmark(uint32_t count, uint32_t iterations) {
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+		std::uniform_real_distribution<float> angle(-glm::pi<float>(), glm::pi<float>());
+
+		std::vector<glm::vec3> translations(count), scales(count), rotations2D(count), rotations3D(count);
+		for (uint32_t i = 0; i < count; i++) {
+			translations[i] = glm::vec3(position(rng), position(rng), position(rng));
+			scales[i] = glm::vec3(scale(rng), scale(rng), 1.0f);
+			rotations2D[i] = glm::vec3(0.0f, 0.0f, angle(rng));
+			rotations3D[i] = glm::vec3(angle(rng), angle(rng), angle(rng));
+		}
+
+		std::vector<glm::mat4> scalarOutput(count);
+		std::vector<glm::mat4> batchOutput(count);
+		NYTransformBatch batch;
+		batch.reserve(count);
+
+		auto measure = [&](const char* name, std::vector<glm::vec3>& rotations) {
+			batch.clear();
+			for (uint32_t i = 0; i < count; i++) {
+				batch.push(translations[i], scales[i], rotations[i]);
+			}
+
+			NYTimer scalarTimer;
+			for (uint32_t it = 0; it < iterations; it++) {
+				for (uint32_t i = 0; i < count; i++) {
+					scalarOutput[i] = computeMatrix(translations[i], scales[i], rotations[i]);
+				}
+			}
+			scalarTimer.endTimer();
+
+			NYTimer batchTimer;
+			for (uint32_t it = 0; it < iterations; it++) {
+				batch.compute(batchOutput.data());
+			}
+			batchTimer.endTimer();
+
+			float maxError = 0.0f;
+			for (uint32_t i = 0; i < count; i++) {
+				for (uint32_t col = 0; col < 4; col++) {
+					glm::vec4 diff = glm::abs(scalarOutput[i][col] - batchOutput[i][col]);
+					maxError = glm::max(maxError, glm::max(glm::max(diff.x, diff.y), glm::max(diff.z, diff.w)));
+				}
+			}
+
+			float total = static_cast<float>(count) * static_cast<float>(iterations);
+			float scalarRate = total / scalarTimer.getMillis();
+			float batchRate = total / batchTimer.getMillis();
+			NYLogger::logInfo("%s: scalar %.0f sprites/ms, batch %.0f sprites/ms (%.2fx), fast path %u/%u, max error %g",
+				name, scalarRate, batchRate, batchRate / scalarRate, batch.getFastPathCount(), count, maxError);
+		};
+
+		NYLogger::logInfo("transform benchmark, %u sprites x %u iterations", count, iterations);
+		measure("2D", rotations2D);
+		measure("3D", rotations3D);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "pch.hpp"
+
+namespace Nya {
+	//builds model matrices for many transforms at once, the components are kept as structure of arrays so
+	//four transforms can be loaded into one SSE register per component
+	//transforms that only rotate around z take a fast path that skips the x and y rotation terms entirely
+	class NYTransformBatch {
+	public:
+		NYTransformBatch();
+		~NYTransformBatch();
+
+		void clear();
+		void reserve(uint32_t count);
+		void push(const glm::vec3& translation, const glm::vec3& scale, const glm::vec3& rotation);
+		uint32_t size() { return static_cast<uint32_t>(tx.size()); }
+
+		//writes one mat4 per transform in push order, stride is the byte distance between matrices so they can be
+		//written straight into interleaved instance data
+		void compute(void* output, size_t stride = sizeof(glm::mat4));
+
+		//scalar euler (y, x, z) model matrix, the reference the batch path matches
+		static glm::mat4 computeMatrix(const glm::vec3& translation, const glm::vec3& scale, const glm::vec3& rotation);
+
+		//times the batch path against computeMatrix() over the same random transforms and logs sprites/ms for both
+		//half of the runs are pure 2D so the fast path shows up separately
+		static void runBenchmark(uint32_t count, uint32_t iterations);
+
+		//stats of the last compute() call
+		uint32_t getFastPathCount() { return fastPathCount; }
+
+	private:
+		void computeScalar(uint32_t index, float* output);
+
+		std::vector<float> tx, ty, tz;
+		std::vector<float> sx, sy, sz;
+		std::vector<float> rx, ry, rz;
+
+		uint32_t fastPathCount = 0;
+	};
+}
\ No newline at end of file
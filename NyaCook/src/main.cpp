@@ -0,0 +1,204 @@
+#include "pch.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+#include "assets/NYKTX2.hpp"
+#include "assets/NYBlockCompressor.hpp"
+#include "utils/NYImageUtils.hpp"
+#include "utils/NYThreadPool.hpp"
+#include "utils/NYTimer.hpp"
+#include "logging/NYLogger.hpp"
+
+//offline texture cooker, turns source images into ktx2 files NYTexture uploads without decoding
+//NyaCook <input image or directory> <output file or directory> [--format auto|bc1|bc3|bc4|bc7|rgba8] [--no-mips] [--linear] [--force]
+//a directory is walked recursively and mirrored into the output with .ktx2 extensions, files newer than their source are skipped
+namespace Nya {
+	struct CookOptions {
+		std::string format = "auto";
+		bool mipmaps = true;
+		bool linear = false;//unorm formats instead of srgb, for textures that hold data rather than color
+		bool force = false;
+	};
+
+	struct CookJob {
+		std::filesystem::path input;
+		std::filesystem::path output;
+	};
+
+	//per job results, written by whichever worker cooked it
+	struct CookResult {
+		bool cooked = false;
+		bool failed = false;
+		size_t decodedBytes = 0;//what the image and its mips take as rgba8
+		size_t cookedBytes = 0;
+	};
+
+	static bool isSourceImage(const std::filesystem::path& path){
+		std::string extension = path.extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+	}
+
+	static VkFormat pickFormat(const CookOptions& options, const uint8_t* pixels, uint32_t width, uint32_t height, NYBlockCompressor::Format& compressorFormat){
+		std::string format = options.format;
+		//opaque images get the smaller bc1, anything with alpha keeps it through bc7
+		if (format == "auto") {
+			bool opaque = true;
+			for (size_t i = 0; i < static_cast<size_t>(width) * height && opaque; i++) {
+				opaque = pixels[i * 4 + 3] == 255;
+			}
+			format = opaque ? "bc1" : "bc7";
+		}
+
+		if (format == "bc1") {
+			compressorFormat = NYBlockCompressor::Format::eBC1;
+			return options.linear ? VK_FORMAT_BC1_RGB_UNORM_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		}
+		if (format == "bc3") {
+			compressorFormat = NYBlockCompressor::Format::eBC3;
+			return options.linear ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC3_SRGB_BLOCK;
+		}
+		//single channel masks, there's no srgb bc4 so it's always read back linear
+		if (format == "bc4") {
+			compressorFormat = NYBlockCompressor::Format::eBC4;
+			return VK_FORMAT_BC4_UNORM_BLOCK;
+		}
+		if (format == "bc7") {
+			compressorFormat = NYBlockCompressor::Format::eBC7;
+			return options.linear ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK;
+		}
+		return options.linear ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+	}
+
+	static CookResult cook(const CookJob& job, const CookOptions& options){
+		CookResult result;
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(job.input.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels) {
+			NYLogger::logWarning("Failed to load image %s", job.input.string().c_str());
+			result.failed = true;
+			return result;
+		}
+
+		NYBlockCompressor::Format compressorFormat;
+		VkFormat format = pickFormat(options, pixels, width, height, compressorFormat);
+		uint32_t levelCount = options.mipmaps ? NYImageUtils::getMipLevelCount(width, height) : 1;
+
+		//the chain is built from the decoded image, each level compressed on its own
+		std::vector<std::vector<uint8_t>> levels;
+		std::vector<uint8_t> level(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+		uint32_t levelWidth = static_cast<uint32_t>(width);
+		uint32_t levelHeight = static_cast<uint32_t>(height);
+		for (uint32_t i = 0; i < levelCount; i++) {
+			result.decodedBytes += level.size();
+			if (NYKTX2::isBlockCompressed(format)) {
+				levels.push_back(NYBlockCompressor::compress(compressorFormat, level.data(), levelWidth, levelHeight));
+			}
+			else {
+				levels.push_back(level);
+			}
+
+			if (i + 1 < levelCount) {
+				std::vector<uint8_t> next(static_cast<size_t>(std::max(levelWidth / 2, 1u)) * std::max(levelHeight / 2, 1u) * 4);
+				NYImageUtils::downsample(level.data(), levelWidth, levelHeight, next.data());
+				level = std::move(next);
+				levelWidth = std::max(levelWidth / 2, 1u);
+				levelHeight = std::max(levelHeight / 2, 1u);
+			}
+		}
+
+		std::vector<uint8_t> file = NYKTX2::write(format, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+		std::filesystem::create_directories(job.output.parent_path());
+		std::ofstream output(job.output, std::ios::binary);
+		if (!output.is_open()) {
+			NYLogger::logWarning("Failed to write %s", job.output.string().c_str());
+			result.failed = true;
+			return result;
+		}
+		output.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+		result.cooked = true;
+		result.cookedBytes = file.size();
+		return result;
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace Nya;
+	if (argc < 3) {
+		NYLogger::logInfo("usage: NyaCook <input image or directory> <output file or directory> [--format auto|bc1|bc3|bc4|bc7|rgba8] [--no-mips] [--linear] [--force]");
+		return 1;
+	}
+
+	CookOptions options;
+	for (int i = 3; i < argc; i++) {
+		if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+			options.format = argv[++i];
+		}
+		else if (strcmp(argv[i], "--no-mips") == 0) {
+			options.mipmaps = false;
+		}
+		else if (strcmp(argv[i], "--linear") == 0) {
+			options.linear = true;
+		}
+		else if (strcmp(argv[i], "--force") == 0) {
+			options.force = true;
+		}
+		else {
+			NYLogger::logWarning("unknown option %s", argv[i]);
+			return 1;
+		}
+	}
+	const char* formats[] = { "auto", "bc1", "bc3", "bc4", "bc7", "rgba8" };
+	if (std::find_if(std::begin(formats), std::end(formats), [&](const char* format) { return options.format == format; }) == std::end(formats)) {
+		NYLogger::logWarning("unknown format %s", options.format.c_str());
+		return 1;
+	}
+
+	std::filesystem::path input = argv[1];
+	std::filesystem::path output = argv[2];
+	std::vector<CookJob> jobs;
+	if (std::filesystem::is_directory(input)) {
+		for (auto& entry : std::filesystem::recursive_directory_iterator(input)) {
+			if (!entry.is_regular_file() || !isSourceImage(entry.path())) {
+				continue;
+			}
+			CookJob job{ entry.path(), output / std::filesystem::relative(entry.path(), input) };
+			job.output.replace_extension(".ktx2");
+			if (!options.force && std::filesystem::exists(job.output) &&
+				std::filesystem::last_write_time(job.output) >= std::filesystem::last_write_time(job.input)) {
+				continue;
+			}
+			jobs.push_back(job);
+		}
+	}
+	else {
+		jobs.push_back({ input, output });
+	}
+
+	//one image per task, compressing is the slow part and every image is independent
+	NYTimer timer;
+	NYThreadPool threadPool;
+	std::vector<CookResult> results(jobs.size());
+	threadPool.parallelFor(static_cast<uint32_t>(jobs.size()), [&](uint32_t taskIndex, uint32_t workerIndex) {
+		results[taskIndex] = cook(jobs[taskIndex], options);
+		if (results[taskIndex].cooked) {
+			NYLogger::logTrace("cooked %s", jobs[taskIndex].output.string().c_str());
+		}
+	});
+	timer.endTimer();
+
+	uint32_t cooked = 0;
+	uint32_t failed = 0;
+	size_t decodedBytes = 0;
+	size_t cookedBytes = 0;
+	for (auto& result : results) {
+		cooked += result.cooked ? 1 : 0;
+		failed += result.failed ? 1 : 0;
+		decodedBytes += result.decodedBytes;
+		cookedBytes += result.cookedBytes;
+	}
+	NYLogger::logInfo("cooked %u textures in %f ms, %u failed, %zu KB as rgba8 -> %zu KB cooked", cooked, timer.getMillis(), failed,
+		decodedBytes / 1024, cookedBytes / 1024);
+	return failed > 0 ? 1 : 0;
+}
\ No newline at end of file
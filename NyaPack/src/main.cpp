@@ -0,0 +1,87 @@
+#include "pch.hpp"
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb/stb_image.h"
+#include "assets/NYAssetPack.hpp"
+#include "assets/NYKTX2.hpp"
+#include "utils/NYTimer.hpp"
+#include "logging/NYLogger.hpp"
+
+//packs a directory into an asset pack the game maps instead of opening loose files
+//NyaPack <directory> <output.pack> [--decode]
+//paths are stored relative to the directory's parent, so packing res keeps the res/... paths the game loads
+//--decode stores images as rgba8 ktx2 so nothing is decoded at load, bigger on disk. cooked .ktx2 files always go in as they are
+namespace Nya {
+	static bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& data){
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			return false;
+		}
+		data.resize(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		return file.good();
+	}
+
+	//images stb can read become single level ktx2 files, the runtime builds their mips like it would for the source image
+	static bool readDecoded(const std::filesystem::path& path, std::vector<uint8_t>& data){
+		if (!readFile(path, data)) {
+			return false;
+		}
+		//already cooked
+		if (NYKTX2::isKTX2(data.data(), data.size())) {
+			return true;
+		}
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load_from_memory(data.data(), static_cast<int>(data.size()), &width, &height, &channels, STBI_rgb_alpha);
+		//not an image, it goes in as it is
+		if (!pixels) {
+			return true;
+		}
+		std::vector<std::vector<uint8_t>> levels(1);
+		levels[0].assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+		stbi_image_free(pixels);
+		data = NYKTX2::write(VK_FORMAT_R8G8B8A8_SRGB, static_cast<uint32_t>(width), static_cast<uint32_t>(height), levels);
+		return true;
+	}
+}
+
+int main(int argc, char** argv) {
+	using namespace Nya;
+	if (argc < 3 || !std::filesystem::is_directory(argv[1])) {
+		NYLogger::logInfo("usage: NyaPack <directory> <output.pack> [--decode]");
+		return 1;
+	}
+	bool decode = argc > 3 && strcmp(argv[3], "--decode") == 0;
+
+	std::filesystem::path directory = std::filesystem::canonical(argv[1]);
+	std::vector<std::filesystem::path> files;
+	for (auto& entry : std::filesystem::recursive_directory_iterator(directory)) {
+		if (entry.is_regular_file()) {
+			files.push_back(entry.path());
+		}
+	}
+	//sorted so the same directory always gives the same pack
+	std::sort(files.begin(), files.end());
+
+	size_t packedBytes = 0;
+	std::vector<NYAssetPack::PackEntry> entries;
+	for (auto& file : files) {
+		NYAssetPack::PackEntry entry;
+		entry.path = std::filesystem::relative(file, directory.parent_path()).generic_string();
+		entry.read = [file, decode, &packedBytes](std::vector<uint8_t>& data) {
+			bool read = decode ? readDecoded(file, data) : readFile(file, data);
+			packedBytes += data.size();
+			return read;
+		};
+		entries.push_back(std::move(entry));
+	}
+
+	NYTimer timer;
+	bool written = NYAssetPack::write(argv[2], entries);
+	timer.endTimer();
+	if (!written) {
+		return 1;
+	}
+	NYLogger::logInfo("packed %zu files, %zu KB in %f ms", entries.size(), packedBytes / 1024, timer.getMillis());
+	return 0;
+}
\ No newline at end of file